@@ -0,0 +1,164 @@
+/**
+ * @file	CameraCalibration.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Calibration of the RGB gains of the PO8030 on a white cell.
+ * 			Every gain is scaled by the ratio of the target to the sum of its color,
+ * 			 as ProcessImage computes it, until the three sums are at the target.
+ * 			The gains are runtime parameters: CaptureImage gives them to the PO8030
+ * 			 before the next capture, and they are saved in flash with the others.
+ */
+
+#include <stdlib.h>
+
+#include <main.h>
+#include <CameraCalibration.h>
+#include <DataAcquisition.h>
+#include <MazeParameters.h>
+#include <ModeManager.h>
+#include <Telemetry.h>
+
+// Colors define, in the order of the parameters
+#define CALIB_NB_COLORS			3		// PARAM_RED_GAIN, PARAM_GREEN_GAIN, PARAM_BLUE_GAIN
+#define CALIB_GAIN_MIN			16		// range of the parameters
+#define CALIB_GAIN_MAX			255
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Waits for new images and returns the sums of the last one and their number of pixels.
+ *
+ * @return	1 if the images came, 0 if the selector changed or the camera is asleep
+ */
+static uint8_t wait_frames(uint8_t NbFrames, uint32_t *Sum, uint16_t *Width){
+	uint32_t First = get_color_sums(&Sum[0], &Sum[1], &Sum[2], Width);
+	systime_t Start = chVTGetSystemTime();
+
+	while((get_color_sums(&Sum[0], &Sum[1], &Sum[2], Width) - First) < NbFrames){
+		mode_wait_events(0, MS2ST(CALIB_POLL_PERIOD));
+		if(mode_change_pending() || (chVTGetSystemTime() - Start > MS2ST(CALIB_FRAME_TIMEOUT))){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief	Returns the gain bringing the sum of a color to the target,
+ * 			 limited to CALIB_MAX_CHANGE so that a noisy image doesn't make it oscillate.
+ */
+static int32_t next_gain(int32_t Gain, uint32_t Sum, uint32_t Target){
+	int32_t MaxChange = (Gain * CALIB_MAX_CHANGE) / 100;
+	int32_t Change;
+
+	// Black row --> largest increase
+	Change = Sum ? (int32_t)((Gain * (int64_t)Target) / Sum) - Gain : MaxChange;
+	if(Change > MaxChange){
+		Change = MaxChange;
+	}else if(Change < -MaxChange){
+		Change = -MaxChange;
+	}
+
+	Gain += Change;
+	if(Gain < CALIB_GAIN_MIN){
+		return CALIB_GAIN_MIN;
+	}
+	return (Gain > CALIB_GAIN_MAX) ? CALIB_GAIN_MAX : Gain;
+}
+
+/**
+ * @brief	Sets the gains of the three colors, CaptureImage applies them
+ * 			 at once before its next capture.
+ */
+static void set_gains(const int32_t *Gain){
+	for(uint8_t c = 0 ; c < CALIB_NB_COLORS ; c++){
+		param_set(PARAM_RED_GAIN + c, Gain[c]);
+	}
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** PUBLIC FUNCTIONS ***/
+
+uint8_t camera_calibrate(void){
+	tlm_calibration_t CalibData;
+	uint32_t Sum[CALIB_NB_COLORS] = {0};
+	int32_t Gain[CALIB_NB_COLORS];
+	int32_t Previous[CALIB_NB_COLORS];
+	uint32_t Target;
+	uint16_t Width;
+	systime_t Start = chVTGetSystemTime();
+	uint8_t Result = CALIB_NOT_CONVERGED;
+	uint8_t Iteration, Balanced, Stuck;
+	const int32_t *Applied = Gain;
+
+	for(uint8_t c = 0 ; c < CALIB_NB_COLORS ; c++){
+		Previous[c] = Gain[c] = param_get(PARAM_RED_GAIN + c);
+	}
+
+	for(Iteration = 1 ; Iteration <= CALIB_MAX_ITERATIONS ; Iteration++){
+		// Images taken with the gains of the previous iteration
+		if(!wait_frames(CALIB_SETTLE_FRAMES, Sum, &Width)){
+			Result = CALIB_ABORTED;
+			break;
+		}
+		// Sums of the row of the image width, or of the full frame while streaming
+		Target = CALIB_TARGET_LEVEL * Width;
+
+		Balanced = 1;
+		for(uint8_t c = 0 ; c < CALIB_NB_COLORS ; c++){
+			if(abs((int32_t)Sum[c] - (int32_t)Target) * 100 > (int32_t)(Target * CALIB_TOLERANCE)){
+				Balanced = 0;
+			}
+		}
+		if(Balanced){
+			Result = CALIB_CONVERGED;
+			break;
+		}
+
+		// A gain at its limit can't bring its color to the target
+		Stuck = 1;
+		for(uint8_t c = 0 ; c < CALIB_NB_COLORS ; c++){
+			int32_t Next = next_gain(Gain[c], Sum[c], Target);
+
+			if(Next != Gain[c]){
+				Stuck = 0;
+			}
+			Gain[c] = Next;
+		}
+		if(Stuck){
+			break;
+		}
+		set_gains(Gain);
+	}
+
+	if((Result == CALIB_CONVERGED) && !parameters_save()){
+		Result = CALIB_NOT_SAVED;
+	}else if(Result != CALIB_CONVERGED){
+		// Gains which don't balance the colors would misclassify them
+		set_gains(Previous);
+		Applied = Previous;
+	}
+
+	CalibData.Result 		= Result;
+	CalibData.Iterations 	= (Iteration > CALIB_MAX_ITERATIONS) ? CALIB_MAX_ITERATIONS : Iteration;
+	CalibData.DurationMs 	= ST2MS(chVTGetSystemTime() - Start);
+	// CaptureImage may not have applied them yet
+	CalibData.RedGain 		= Applied[0];
+	CalibData.GreenGain 	= Applied[1];
+	CalibData.BlueGain 		= Applied[2];
+	CalibData.Contrast 		= param_get(PARAM_CONTRAST);
+	CalibData.RedVal 		= Sum[0];
+	CalibData.GreenVal 		= Sum[1];
+	CalibData.BlueVal 		= Sum[2];
+	telemetry_write(TLM_CALIBRATION, &CalibData, sizeof(CalibData));
+
+	return Result;
+}
+
+/*** END PUBLIC FUNCTIONS ***/
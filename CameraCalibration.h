@@ -0,0 +1,44 @@
+/**
+ * @file	CameraCalibration.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of the calibration of the RGB gains of the PO8030
+ * 			 on a white cell, so that a new venue needs no new firmware.
+ */
+
+#ifndef CAMERACALIBRATION_H_
+#define CAMERACALIBRATION_H_
+
+#include <stdint.h>
+
+// Calibration define
+#define CALIB_TARGET_LEVEL		44		// mean value of a pixel on white for every color, in green size (0 to 63)
+#define CALIB_TOLERANCE			4		// in [%] of the target, the colors are balanced
+#define CALIB_MAX_CHANGE		25		// in [%], largest change of a gain in one iteration
+#define CALIB_SETTLE_FRAMES		2		// images after a change, the first one may be taken with the old gains
+#define CALIB_MAX_ITERATIONS	20
+#define CALIB_POLL_PERIOD		10		// in [ms], checks of a new image
+#define CALIB_FRAME_TIMEOUT		500		// in [ms], without a new image the camera is asleep
+// Result define
+#define CALIB_CONVERGED			0		// gains balanced and saved in flash
+#define CALIB_NOT_CONVERGED		1		// gain at its limit or too many iterations, previous gains kept
+#define CALIB_ABORTED			2		// selector changed or no image, previous gains kept
+#define CALIB_NOT_SAVED			3		// gains balanced but the flash wasn't written
+
+
+/**
+ * @brief	Adjusts the RGB gains of the runtime parameters until the sums of the color
+ * 			 row are balanced at CALIB_TARGET_LEVEL, then saves them in flash.
+ * 			The e-puck stands on a white cell, CaptureImage and ProcessImage are awake.
+ * 			Runs in the calling thread, returns early if the selector changes.
+ * 			Sends a TLM_CALIBRATION record with the convergence time.
+ *
+ * @return	CALIB_CONVERGED, CALIB_NOT_CONVERGED, CALIB_ABORTED or CALIB_NOT_SAVED
+ */
+uint8_t camera_calibrate(void);
+
+#endif /* CAMERACALIBRATION_H_ */
@@ -0,0 +1,168 @@
+/**
+ * @file	CameraControl.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Exposure and frame timing of the PO8030, and measure of the frame rate.
+ * 			The driver only sets the window, so the sensor still reads a whole VGA frame
+ * 			 for the two lines of the color row, and the automatic exposure lengthens
+ * 			 the frame in a dim maze. The fast preset fixes a short exposure and ends
+ * 			 the frame just below the color row: the next frame starts sooner.
+ * 			The frame height isn't set by the driver, it is written in bank A of the PO8030,
+ * 			 the value of the driver is read once and written back by the other presets.
+ */
+
+#include <stdlib.h>
+#include <i2c_bus.h>
+#include <camera/po8030.h>
+
+#include <main.h>
+#include <CameraControl.h>
+#include <SystemControl.h>
+#include <MazeParameters.h>
+#include <Telemetry.h>
+
+// PO8030 define (datasheet)
+#define PO8030_I2C_ADDR			0x6E
+#define PO8030_REG_BANK			0x03
+#define PO8030_BANK_A			0x00
+#define PO8030_REG_FRAME_HEIGHT_H	0x06	// in [lines], bank A
+#define PO8030_REG_FRAME_HEIGHT_L	0x07
+#define DRIVER_FRAME			0		// frame height of the driver, not written
+#define NO_PRESET				0xFF
+
+
+/*** STATIC VARIABLES ***/
+typedef struct camera_preset_s{
+	uint8_t AutoExposure;
+	uint16_t Exposure;		// in [lines], fixed exposure
+	uint16_t FrameHeight;	// in [lines], DRIVER_FRAME or a shorter frame
+} camera_preset_t;
+
+static const camera_preset_t Preset[CAMERA_NB_PRESETS] = {
+		[CAMERA_PRESET_AUTO] 		= {1, 0, 						DRIVER_FRAME},
+		[CAMERA_PRESET_FAST] 		= {0, CAMERA_FAST_EXPOSURE, 	CAMERA_FAST_FRAME},
+		[CAMERA_PRESET_LOW_NOISE] 	= {0, CAMERA_LOW_NOISE_EXPOSURE, DRIVER_FRAME}};
+
+// Preset given to the PO8030, written by CaptureImage only
+static uint8_t AppliedPreset = NO_PRESET;
+static uint8_t AppliedFullFrame = FALSE;
+static uint16_t DriverFrameHeight = 0;	// in [lines], 0 until read
+// Frames of the current period, written by ProcessImage only
+static uint16_t NbFrames = 0;
+static systime_t PeriodStart = 0;
+static uint16_t Rate = 0;				// in [0.1 frame/s]
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Reads the frame height set by the driver, so that it can be written back.
+ *
+ * @return	In [lines], 0 if the PO8030 didn't answer
+ */
+static uint16_t read_frame_height(void){
+	uint8_t High, Low;
+
+	if((write_reg(PO8030_I2C_ADDR, PO8030_REG_BANK, PO8030_BANK_A) != MSG_OK)
+			|| (read_reg(PO8030_I2C_ADDR, PO8030_REG_FRAME_HEIGHT_H, &High) != MSG_OK)
+			|| (read_reg(PO8030_I2C_ADDR, PO8030_REG_FRAME_HEIGHT_L, &Low) != MSG_OK)){
+		return 0;
+	}
+	return (High << 8) | Low;
+}
+
+/**
+ * @brief	Writes the frame height, the driver selects its bank before each access.
+ */
+static void write_frame_height(uint16_t Height){
+	write_reg(PO8030_I2C_ADDR, PO8030_REG_BANK, PO8030_BANK_A);
+	write_reg(PO8030_I2C_ADDR, PO8030_REG_FRAME_HEIGHT_H, Height >> 8);
+	write_reg(PO8030_I2C_ADDR, PO8030_REG_FRAME_HEIGHT_L, Height & 0xFF);
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** PUBLIC FUNCTIONS ***/
+
+void camera_control_update(uint8_t FullFrame){
+	uint8_t Id = param_get(PARAM_CAMERA_PRESET);
+	const camera_preset_t* New = &Preset[Id];
+
+	if((Id == AppliedPreset) && (FullFrame == AppliedFullFrame)){
+		return;
+	}
+
+	if(!DriverFrameHeight){
+		DriverFrameHeight = read_frame_height();
+	}
+
+	// Fixed exposure first, it has to fit in the new frame
+	if(New->AutoExposure){
+		po8030_set_ae(1);
+	}else{
+		po8030_set_ae(0);
+		po8030_set_exposure(New->Exposure, 0);
+	}
+
+	// A shorter frame would cut the full images
+	if((New->FrameHeight != DRIVER_FRAME) && !FullFrame){
+		write_frame_height(New->FrameHeight);
+	}else if(DriverFrameHeight && (AppliedPreset != NO_PRESET)){
+		write_frame_height(DriverFrameHeight);
+	}
+
+	AppliedPreset = Id;
+	AppliedFullFrame = FullFrame;
+}
+
+void camera_frame_done(void){
+	systime_t Time = chVTGetSystemTime();
+	uint32_t Elapsed = ST2MS(Time - PeriodStart);
+	tlm_camera_t CameraData;
+	int16_t SpeedLeft, SpeedRight;
+	const camera_preset_t* Current;
+
+	NbFrames++;
+
+	// First frame after a wakeup --> new period, the time asleep isn't counted
+	if(Elapsed > 2 * CAMERA_RATE_PERIOD){
+		NbFrames = 0;
+		PeriodStart = Time;
+		Rate = 0;
+		return;
+	}
+	if(Elapsed < CAMERA_RATE_PERIOD){
+		return;
+	}
+
+	Rate = (NbFrames * 10000UL) / Elapsed;
+
+	motor_get_speed(&SpeedLeft, &SpeedRight);
+	Current = &Preset[(AppliedPreset < CAMERA_NB_PRESETS) ? AppliedPreset : CAMERA_PRESET_AUTO];
+	CameraData.Preset 		= AppliedPreset;
+	CameraData.AutoExposure = Current->AutoExposure;
+	CameraData.Exposure 	= Current->Exposure;
+	CameraData.FrameHeight 	= ((Current->FrameHeight != DRIVER_FRAME) && !AppliedFullFrame) ? Current->FrameHeight : DriverFrameHeight;
+	CameraData.Frames 		= NbFrames;
+	CameraData.Rate 		= Rate;
+	// Travel of the e-puck between two colors, in [0.1 mm]
+	CameraData.Travel 		= Rate ? (abs(SpeedLeft) + abs(SpeedRight)) * 50 / (MM_2_STEP * Rate) : 0;
+	telemetry_write(TLM_CAMERA, &CameraData, sizeof(CameraData));
+
+	NbFrames = 0;
+	PeriodStart = Time;
+}
+
+uint16_t get_camera_rate(void){
+	// No frame for two periods --> asleep
+	if(ST2MS(chVTGetSystemTime() - PeriodStart) > 2 * CAMERA_RATE_PERIOD){
+		return 0;
+	}
+	return Rate;
+}
+
+/*** END PUBLIC FUNCTIONS ***/
@@ -0,0 +1,55 @@
+/**
+ * @file	CameraControl.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of the exposure and frame timing of the PO8030,
+ * 			 set by presets trading the latency of the colors against their noise,
+ * 			 and of the measure of the frames per second given to ProcessImage.
+ */
+
+#ifndef CAMERACONTROL_H_
+#define CAMERACONTROL_H_
+
+#include <stdint.h>
+
+// Preset define, values of PARAM_CAMERA_PRESET
+#define CAMERA_PRESET_AUTO		0		// automatic exposure, frame of the driver
+#define CAMERA_PRESET_FAST		1		// short exposure and frame ending below the color row --> highest rate, noisier colors
+#define CAMERA_PRESET_LOW_NOISE	2		// long fixed exposure, frame of the driver --> steady colors, lowest rate
+#define CAMERA_NB_PRESETS		3
+#define CAMERA_PRESET			CAMERA_PRESET_AUTO	// default of PARAM_CAMERA_PRESET
+// Timing define, in [lines] of the sensor (experimental)
+#define CAMERA_FAST_EXPOSURE	128		// enough light on a lit floor
+#define CAMERA_FAST_FRAME		280		// last line of the color rows (242) plus the vertical blanking
+#define CAMERA_LOW_NOISE_EXPOSURE 400
+// Measure define
+#define CAMERA_RATE_PERIOD		1000	// in [ms], frames counted before a TLM_CAMERA record
+
+
+/**
+ * @brief	Gives the exposure and the frame height of PARAM_CAMERA_PRESET to the PO8030
+ * 			 if the preset changed. Called by CaptureImage between two captures.
+ *
+ * @param FullFrame		1 while full images are streamed, the frame of the driver is kept
+ */
+void camera_control_update(uint8_t FullFrame);
+
+/**
+ * @brief	Counts a frame given to ProcessImage. Every CAMERA_RATE_PERIOD, computes the rate
+ * 			 and sends a TLM_CAMERA record with the travel of the e-puck between two frames.
+ * 			Called by ProcessImage only.
+ */
+void camera_frame_done(void);
+
+/**
+ * @brief	Returns the rate of the frames given to ProcessImage during the last CAMERA_RATE_PERIOD.
+ *
+ * @return	In [0.1 frame/s], 0 while the camera is asleep
+ */
+uint16_t get_camera_rate(void);
+
+#endif /* CAMERACONTROL_H_ */
@@ -7,26 +7,47 @@
  * @date	16.05.2021
  *
  * @brief	Thread to acquire proximity data based on IR sensors.
- * 			Threads to acquire colors detection based on CMOS camera.
+ * 			Threads to acquire colors detection based on CMOS camera,
+ * 			 and the front wall above the floor (VISION_FRONT_WALL),
+ * 			 or full images streamed to the host (ImageStream).
+ * 			Thread to measure the length of the corridor ahead based on time of flight.
  * 			Static variable and getter to save environment.
  */
 
+#include <string.h>
 #include <camera/po8030.h>
 #include <camera/dcmi_camera.h>
 #include <sensors/proximity.h>
+#include <sensors/VL53L0X/VL53L0X.h>
 #include <leds.h>
 
 #include <main.h>
 #include <DataAcquisition.h>
+#include <Telemetry.h>
+#include <LatencyProbe.h>
+#include <SystemMonitor.h>
+#include <PowerManager.h>
+#include <ThreadPark.h>
+#include <SystemControl.h>
+#include <MazeParameters.h>
+#include <DataProcess.h>
+#include <CameraControl.h>
+#include <ImageStream.h>
+#if COLOR_CLASSIFIER == TRUE
+#include <ColorLut.h>
+#endif
 
 
 /*** GLOBAL VARIABLES ***/
-thd_metadata_t CaptureImage_MetaData = {.Sleep = 0, .ThdReference = NULL};
-thd_metadata_t GetProximity_MetaData = {.Sleep = 0, .ThdReference = NULL};
+thd_metadata_t CaptureImage_MetaData = {.Request = AWAKE_MODE, .Sleep = AWAKE_MODE};
+thd_metadata_t GetProximity_MetaData = {.Request = AWAKE_MODE, .Sleep = AWAKE_MODE};
+thd_metadata_t GetDistance_MetaData = {.Request = AWAKE_MODE, .Sleep = AWAKE_MODE};
 
 
 /*** STATIC VARIABLES ***/
 static BSEMAPHORE_DECL(ImageReady_sem, FALSE);
+// Broadcast by threads GetProximity and ProcessImage when ActualCell changes
+static EVENTSOURCE_DECL(CellChanged_src);
 /* Variable ActualCell is continuously updated by threads: GetProximity and ProcessImage,
  *  according to the environment.
  * Bits 0 to 3 are set to 1 if the corresponding
@@ -41,6 +62,23 @@ static BSEMAPHORE_DECL(ImageReady_sem, FALSE);
  *		Bit 6 --> red
  */
 static uint8_t ActualCell;
+// Width of the captured images in [pxl], written by CaptureImage while the DCMI is stopped
+static volatile uint16_t ImageWidth = IMAGE_BUFFER_SIZE;
+// Full images for the host instead of the color row, written by CaptureImage while the DCMI is stopped
+static volatile uint8_t FullFrame = FALSE;
+// Free cells ahead, written by GetDistance only
+static uint8_t CorridorLength = 0;
+// Sums of the last color row and number of images, written by ProcessImage only
+static uint32_t ColorSums[3] = {0};
+static uint16_t ColorWidth = IMAGE_BUFFER_SIZE;	// in [pixels], IMAGE_FRAME_WIDTH while streaming
+static uint32_t NbFrames = 0;
+// Gains and contrast given to the PO8030, written by CaptureImage only
+static int32_t AppliedGains[4] = {0};
+// Front wall seen by the camera, written by ProcessImage only
+static uint16_t FrontWallDistance = VISION_NO_WALL;	// in [mm]
+static systime_t FrontWallTime = 0;
+// Last frames of the camera, a color is saved once stable, written by ProcessImage only
+static color_vote_t Vote;
 
 
 /*** INTERNAL FUNCTIONS ***/
@@ -49,96 +87,213 @@ static uint8_t ActualCell;
  * @brief	Thread which retrieves continuously proximity data.
  * 			Sets corresponding walls to static variable ActualCell.
  */
-static THD_WORKING_AREA(waGetProximity, 64);
+static THD_WORKING_AREA(waGetProximity, 256);
 static THD_FUNCTION(GetProximity, arg){
 	chRegSetThreadName(__FUNCTION__);
 	(void)arg;
 
-	/* variables used when two sensors are used for the same wall, as an "or" condition
-	 *  example condition: (IR1 || IR8) --> wall detected
-	 */
-	uint8_t Check_IR18 = 0;
-	uint8_t Check_IR45 = 0;
-
+	tlm_prox_t ProxData;
+	uint16_t Prox[PROXIMITY_NB_CHANNELS];
 	systime_t Time;
+	uint8_t LastCell;
+	uint8_t Walls;
+	int32_t Threshold;
+
+	messagebus_topic_t *ProxTopic = messagebus_find_topic_blocking(&bus, "/proximity");
+	proximity_msg_t ProxMsg;
+
+	period_monitor_init(PERIOD_GET_PROXIMITY, 50000);
 
 	/*** INFINITE LOOP ***/
 	while(1){
 		// Enters sleep mode if asked by another thread.
-		if(GetProximity_MetaData.Sleep){
-			chSysLock();
-			GetProximity_MetaData.Sleep = chThdSuspendS(&GetProximity_MetaData.ThdReference);
-			chSysUnlock();
+		if(park_requested(&GetProximity_MetaData)){
+			// Stops the IR pulses and the ADC sampling while asleep
+			proximity_stop();
+			power_off(POWER_PROXIMITY);
+
+			park_self(&GetProximity_MetaData);
+
+			// Walls are detected again once every sensor has been sampled
+			proximity_start();
+			power_wakeup(POWER_PROXIMITY);
+			messagebus_topic_wait(ProxTopic, &ProxMsg, sizeof(ProxMsg));
+			power_ready(POWER_PROXIMITY);
+			period_monitor_restart(PERIOD_GET_PROXIMITY);
 		}
 
 		Time = chVTGetSystemTime();
+		period_monitor_tick(PERIOD_GET_PROXIMITY);
+		// Threshold set from the host --> used from this scan
+		parameters_update(PARAM_PROX_B);
+		Threshold = param_get(PARAM_PROX_THRESHOLD);
+		PROBE_BEGIN(PROBE_PROXIMITY_SCAN);
+		LastCell = ActualCell;
+
+		// Reads all the sensors once, values are also sent as telemetry
+		for(uint8_t i=0 ; i<PROXIMITY_NB_CHANNELS ; i++){
+			Prox[i] = get_prox(i);
+			ProxData.Prox[i] = Prox[i];
+		}
 
 		/*** SCAN FOR WALLS ***
-		 * Walls are saved on bits 0 to 3
-		 * 	IR1 and IR8 --> front wall
-		 * 	IR3 		--> right wall
-		 * 	IR4 and IR5 --> back wall
-		 * 	IR6			--> left wall
+		 * Walls are saved on bits 0 to 3, the colors saved by ProcessImage are kept
 		 */
-		for(uint8_t i=0 ; i<PROXIMITY_NB_CHANNELS ; i++){
-			if((i == IR2) || (i == IR7)){					// no use of IR2 and IR7 sensors
-				continue;
+		Walls = scan_walls(Prox, Threshold);
+		chSysLock();
+		ActualCell = (ActualCell & ~WALL_B) | Walls;
+		chSysUnlock();
+		PROBE_END(PROBE_PROXIMITY_SCAN);
+
+		// Wakes the listeners up only if a wall appeared or disappeared
+		if(ActualCell != LastCell){
+			chEvtBroadcast(&CellChanged_src);
+		}
+
+		telemetry_write(TLM_PROX, &ProxData, sizeof(ProxData));
+		telemetry_write(TLM_CELL, &ActualCell, sizeof(ActualCell));
+
+		// 20 Hz cycle, interrupted by a park request
+		park_sleep_until(0, Time, Time + MS2ST(50));
+	}
+	/*** END INFINITE LOOP ***/
+}
+
+/**
+ * @brief	Returns the median of three distances, a single wrong reading is ignored.
+ */
+static uint16_t median_distance(const uint16_t *Distance){
+	uint16_t A = Distance[0], B = Distance[1], C = Distance[2];
+
+	if((A > B) == (A < C)){
+		return A;
+	}else if((B > A) == (B < C)){
+		return B;
+	}
+	return C;
+}
+
+/**
+ * @brief	Thread which reads the VL53L0X distance and converts it in free cells ahead.
+ * 			Readings taken while moving are discarded, the corridor is measured
+ * 			 from the center of the cell where the e-puck stands.
+ */
+static THD_WORKING_AREA(waGetDistance, 256);
+static THD_FUNCTION(GetDistance, arg){
+	chRegSetThreadName(__FUNCTION__);
+	(void)arg;
+
+	uint16_t Distance[TOF_FILTER_SIZE];	// in [mm]
+	uint8_t NbReadings = 0;
+	uint8_t Oldest = 0;
+	uint8_t Cells;
+	int16_t SpeedLeft, SpeedRight;
+	uint32_t FromCenter;				// in [mm]
+	tlm_corridor_t CorridorData;
+	systime_t Time;
+
+	VL53L0X_start();
+
+	/*** INFINITE LOOP ***/
+	while(1){
+		// Enters sleep mode if asked by another thread.
+		if(park_requested(&GetDistance_MetaData)){
+			// Stops the continuous ranging while asleep
+			VL53L0X_stop();
+			power_off(POWER_TOF);
+			CorridorLength = 0;
+			NbReadings = 0;
+
+			park_self(&GetDistance_MetaData);
+
+			VL53L0X_start();
+			power_wakeup(POWER_TOF);
+		}
+
+		Time = chVTGetSystemTime();
+
+		motor_get_speed(&SpeedLeft, &SpeedRight);
+		if((SpeedLeft != STOP_SPEED) || (SpeedRight != STOP_SPEED)){
+			CorridorLength = 0;
+			NbReadings = 0;
+		}else{
+			// Oldest reading replaced, the filter is valid once full
+			Distance[Oldest] = VL53L0X_get_dist_mm();
+			Oldest = (Oldest + 1) % TOF_FILTER_SIZE;
+			if(NbReadings < TOF_FILTER_SIZE){
+				NbReadings++;
 			}
-			else if(get_prox(i) > PROXIMITY_THRESHOLD){		// wall detected --> sets bit to 1
-				switch (i) {
-				case IR1:
-				case IR8:
-					ActualCell |= WALL_FRONT_B;
-					Check_IR18 = 1;
-					break;
-				case IR3:
-					ActualCell |= WALL_RIGHT_B;
-					break;
-				case IR4:
-				case IR5:
-					ActualCell |= WALL_BACK_B;
-					Check_IR45 = 1;
-					break;
-				case IR6:
-					ActualCell |= WALL_LEFT_B;
-					break;
-				default:
-					break;
-				}
-			}else{											// no wall detected --> sets bit to 0
-				switch (i) {
-				case IR1:
-				case IR8:
-					if(!Check_IR18){
-						ActualCell &= ~WALL_FRONT_B;
-					}
-					Check_IR18 = 0;
-					break;
-				case IR3:
-					ActualCell &= ~WALL_RIGHT_B;
-					break;
-				case IR4:
-				case IR5:
-					if(!Check_IR45){
-						ActualCell &= ~WALL_BACK_B;
-					}
-					Check_IR45 = 0;
-					break;
-				case IR6:
-					ActualCell &= ~WALL_LEFT_B;
-					break;
-				default:
-					break;
+			if(NbReadings == TOF_FILTER_SIZE){
+				power_ready(POWER_TOF);
+
+				/* Wall at the border of the cell ahead --> CELL_SIZE/2 from the center,
+				 *  each free cell adds CELL_SIZE
+				 */
+				CorridorData.Distance = median_distance(Distance);
+				FromCenter = CorridorData.Distance + TOF_SENSOR_OFFSET;
+				Cells = (FromCenter > CELL_SIZE / 2) ? (FromCenter - CELL_SIZE / 2) / CELL_SIZE : 0;
+				if(Cells > TOF_MAX_CELLS){
+					Cells = TOF_MAX_CELLS;
 				}
 
+				if(Cells != CorridorLength){
+					CorridorLength = Cells;
+					CorridorData.Cells = Cells;
+					telemetry_write(TLM_CORRIDOR, &CorridorData, sizeof(CorridorData));
+				}
 			}
 		}
-		// 20 Hz cycle
-		chThdSleepUntilWindowed(Time, Time + MS2ST(50));
+
+		park_sleep_until(0, Time, Time + MS2ST(TOF_PERIOD));
 	}
 	/*** END INFINITE LOOP ***/
 }
 
+/**
+ * @brief	Configures the size of the images with PARAM_IMAGE_WIDTH,
+ * 			 the row stays centered, or the full images of the stream.
+ * 			Called while the DCMI unit isn't prepared.
+ */
+static void configure_image_size(void){
+	ImageWidth = param_get(PARAM_IMAGE_WIDTH);
+	FullFrame = image_stream_enabled();
+
+	if(FullFrame){
+		// Image configuration: format --> RGB565, whole sensor subsampled by 4 --> (IMAGE_FRAME_WIDTH, IMAGE_FRAME_HEIGHT)
+		po8030_advanced_config(FORMAT_RGB565, 0, 0, 4 * IMAGE_FRAME_WIDTH, 4 * IMAGE_FRAME_HEIGHT,
+				SUBSAMPLING_X4, SUBSAMPLING_X4);
+		return;
+	}
+
+#if VISION_FRONT_WALL == TRUE
+	/* Image configuration: format --> RGB565, origin --> above (220,240) for the widest row,
+	 *  size --> (ImageWidth, VISION_ROWS) one line out of VISION_ROW_STEP, the last row is the color row
+	 */
+	po8030_advanced_config(FORMAT_RGB565, 220 + (IMAGE_BUFFER_SIZE - ImageWidth) / 2,
+			VISION_COLOR_LINE - (VISION_ROWS - 1) * VISION_ROW_STEP, ImageWidth, VISION_ROWS * VISION_ROW_STEP,
+			SUBSAMPLING_X1, SUBSAMPLING_X4);
+#else
+	// Image configuration: format --> RGB565, origin --> (220,240) for the widest row, size --> (ImageWidth, 2)
+	po8030_advanced_config(FORMAT_RGB565, 220 + (IMAGE_BUFFER_SIZE - ImageWidth) / 2, 240, ImageWidth, 2,
+			SUBSAMPLING_X1, SUBSAMPLING_X1);
+#endif
+}
+
+/**
+ * @brief	Gives the RGB gains and the contrast of the runtime parameters to the PO8030
+ * 			 if they changed. Called by CaptureImage between two captures.
+ */
+static void configure_image_gains(void){
+	int32_t Gains[4] = {param_get(PARAM_RED_GAIN), param_get(PARAM_GREEN_GAIN),
+			param_get(PARAM_BLUE_GAIN), param_get(PARAM_CONTRAST)};
+
+	if(memcmp(Gains, AppliedGains, sizeof(Gains))){
+		po8030_set_rgb_gain(Gains[0], Gains[1], Gains[2]);
+		po8030_set_contrast(Gains[3]);
+		memcpy(AppliedGains, Gains, sizeof(Gains));
+	}
+}
+
 /**
  * @brief	Thread which configures and captures images.
  * 			Signals semaphore ImageReady_sem when an image has been captured.
@@ -149,16 +304,13 @@ static THD_FUNCTION(CaptureImage, arg){
 	(void)arg;
 
 	/*** PO8030 CONFIGURATION ***/
-	// Image configuration: format --> RGB565, origin --> (220,240), size --> (IMAGE_BUFFER_SIZE, 2)
-	po8030_advanced_config(FORMAT_RGB565, 220, 240, IMAGE_BUFFER_SIZE, 2, SUBSAMPLING_X1, SUBSAMPLING_X1);
+	configure_image_size();
 	// White balance disabled in order to identify the colors
 	po8030_set_awb(0);
-	// RGB gain adjusted to the scene
-	po8030_set_rgb_gain(0x52, 0x52 , 0x65);		// Office - Sunny
-	//po8030_set_rgb_gain(0x55, 0x4F , 0x65);	// Home - Sunny
-	//po8030_set_rgb_gain(0x5E, 0x4F , 0x5D);	// Home - Cloudy
-	// Contrast adjusted to the scene
-	po8030_set_contrast(20);
+	// RGB gain and contrast adjusted to the scene, from the parameters (calibrated or defaults)
+	configure_image_gains();
+	// Exposure and frame timing of the preset
+	camera_control_update(FullFrame);
 
 	/*** DCMI CONFIGURATION ***/
 	// Double buffering enabled in order to process image while capturing another
@@ -171,17 +323,50 @@ static THD_FUNCTION(CaptureImage, arg){
 	/*** INFINITE LOOP ***/
 	while(1){
 		// Enters sleep mode if asked by another thread.
-		if(CaptureImage_MetaData.Sleep){
-			chSysLock();
-			CaptureImage_MetaData.Sleep = chThdSuspendS(&CaptureImage_MetaData.ThdReference);
-			chSysUnlock();
+		if(park_requested(&CaptureImage_MetaData)){
+			// Releases the DCMI unit and its DMA while asleep
+			dcmi_unprepare();
+			power_off(POWER_DCMI);
+
+			park_self(&CaptureImage_MetaData);
+
+			// PO8030 keeps its configuration, only the image size may have been changed meanwhile
+			parameters_update(PARAM_CAMERA_B);
+			if((ImageWidth != param_get(PARAM_IMAGE_WIDTH)) || (FullFrame != image_stream_enabled())){
+				image_stream_wait(NULL);
+				configure_image_size();
+			}
+			dcmi_prepare();
+			power_wakeup(POWER_DCMI);
 		}
 
+		// Stream started or stopped by the host --> new image size, once the last image is sent
+		if(FullFrame != image_stream_enabled()){
+			image_stream_wait(NULL);
+			dcmi_unprepare();
+			configure_image_size();
+			dcmi_prepare();
+		}
+
+		// New gains and preset from the calibration or from the host, applied to the next capture
+		parameters_update(PARAM_CAMERA_B);
+		configure_image_gains();
+		camera_control_update(FullFrame);
+
+		// The next capture overwrites the image before the last one, it may still be streamed
+		image_stream_wait(dcmi_get_last_image_ptr());
+
 		// Starts a capture
 		dcmi_capture_start();
 
-		// Waits for the capture to be done
+		// Waits for the capture to be done, the first one after a wakeup is the time-to-ready
 		wait_image_ready();
+		power_ready(POWER_DCMI);
+		PROBE_BEGIN(PROBE_CAMERA_TO_CELL);
+
+		if(FullFrame){
+			image_stream_offer(dcmi_get_last_image_ptr(), ActualCell);
+		}
 
 		// Signals an image has been captured
 		chBSemSignal(&ImageReady_sem);
@@ -189,12 +374,42 @@ static THD_FUNCTION(CaptureImage, arg){
 	/*** END INFINITE LOOP ***/
 }
 
+#if VISION_FRONT_WALL == TRUE
+/**
+ * @brief	Finds the front wall in the rows above the color row and saves its distance.
+ * 			The work is the same for every frame, VISION_ROWS times VISION_COLUMNS pixels.
+ * 			Called by ProcessImage only, once the colors are saved.
+ */
+static void find_front_wall(const uint8_t *Image){
+	tlm_vision_t VisionData;
+	uint32_t Start = PROBE_NOW();
+	uint32_t Cycles;
+
+	VisionData.Row = find_wall_row(Image, ImageWidth);
+	VisionData.Distance = wall_row_distance(VisionData.Row);
+	// Duration also sent with the distance, so that the budget is checked per frame
+	Cycles = PROBE_NOW() - Start;
+	probe_record(PROBE_VISION_WALL, Cycles);
+
+	if(VisionData.Distance != FrontWallDistance){
+		VisionData.Reserved = 0;
+		VisionData.DurationUs = Cycles / PROBE_CYCLES_PER_US;
+		telemetry_write(TLM_VISION, &VisionData, sizeof(VisionData));
+	}
+
+	chSysLock();
+	FrontWallDistance = VisionData.Distance;
+	FrontWallTime = chVTGetSystemTimeX();
+	chSysUnlock();
+}
+#endif
+
 /**
  * @brief	Thread which extracts the colors of the image.
  * 			Sets the colors to RGB front LEDs.
  * 			Sets the colors to static variable ActualCell.
  */
-static THD_WORKING_AREA(waProcessImage, 32);
+static THD_WORKING_AREA(waProcessImage, 256);
 static THD_FUNCTION(ProcessImage, arg){
 	chRegSetThreadName(__FUNCTION__);
 	(void)arg;
@@ -202,9 +417,12 @@ static THD_FUNCTION(ProcessImage, arg){
 	/*** INTERNAL VARIABLES ***/
 
 	uint8_t *ImgBuff_ptr = NULL;
+	const uint8_t *Row;
+	uint16_t Width;
+	tlm_color_t ColorData;
+	int32_t Threshold;
 
 	uint8_t Color 		= 0;
-	uint16_t MaxVal 	= 0;
 	uint32_t RedVal 	= 0;
 	uint32_t GreenVal 	= 0;
 	uint32_t BlueVal 	= 0;
@@ -213,58 +431,79 @@ static THD_FUNCTION(ProcessImage, arg){
 	while(1){
 		// Waits until an image has been captured
 		chBSemWait(&ImageReady_sem);
+		PROBE_BEGIN(PROBE_PROCESS_IMAGE);
 
 		// Gets the pointer to the array filled with the last image in RGB565
 		ImgBuff_ptr = dcmi_get_last_image_ptr();
 
-		// Resets values of last image
-		RedVal 		= 0;
-		GreenVal 	= 0;
-		BlueVal 	= 0;
-		Color 		= 0;
-
-		// Extracts and adds all pixels values of one line, by color (format RGB565)
-		for(uint16_t i = 0 ; i < (2 * IMAGE_BUFFER_SIZE) ; i+=2){	// pixels are acquired on two bytes
-			RedVal += (ImgBuff_ptr[i] & 0xF8) >> 2;				// red value scaled to green size
-			GreenVal += ((ImgBuff_ptr[i] & 0x07) << 3) +			// green value
-					((ImgBuff_ptr[i+1] & 0xE0) >> 5);
-			BlueVal += (ImgBuff_ptr[i+1] & 0x1F) << 1;			// blue value scaled to green size
-		}
-
-		// Checks for the maximum value of RGB
-		if(RedVal >= GreenVal && RedVal >= BlueVal){
-			MaxVal = RedVal;
-		}else if(GreenVal >= BlueVal){
-			MaxVal = GreenVal;
+		// Color row of the image
+		if(FullFrame){
+			Row = ImgBuff_ptr + IMAGE_COLOR_ROW * 2 * IMAGE_FRAME_WIDTH;
+			Width = IMAGE_FRAME_WIDTH;
 		}else{
-			MaxVal = BlueVal;
+#if VISION_FRONT_WALL == TRUE
+			Row = ImgBuff_ptr + (VISION_ROWS - 1) * 2 * ImageWidth;
+#else
+			Row = ImgBuff_ptr;
+#endif
+			Width = ImageWidth;
 		}
 
-		// Sets scale to percentage of maximum value
-		RedVal = (RedVal*RGB_MAX)/MaxVal;
-		GreenVal = (GreenVal*RGB_MAX)/MaxVal;
-		BlueVal = (BlueVal*RGB_MAX)/MaxVal;
+		// Adds all pixels values of one line, by color
+		sum_row_colors(Row, Width, &RedVal, &GreenVal, &BlueVal);
 
-		// Saves the colors to variable Color
-		if(RedVal > COLOR_THRESHOLD){
-			Color |= RED_B;
-		}
-		if(GreenVal > COLOR_THRESHOLD){
-			Color |= GREEN_B;
-		}
-		if(BlueVal > COLOR_THRESHOLD){
-			Color |= BLUE_B;
-		}
+		ColorData.RedVal 	= RedVal;
+		ColorData.GreenVal 	= GreenVal;
+		ColorData.BlueVal 	= BlueVal;
+
+		chSysLock();
+		ColorSums[0] = RedVal;
+		ColorSums[1] = GreenVal;
+		ColorSums[2] = BlueVal;
+		ColorWidth = Width;
+		NbFrames++;
+		chSysUnlock();
+		camera_frame_done();
+
+		// Sums scaled to percentage of the maximum value, also for the RGB LEDs
+		parameters_update(PARAM_COLOR_B);
+		Threshold = param_get(PARAM_COLOR_THRESHOLD);
+		ColorData.Color = extract_color(&RedVal, &GreenVal, &BlueVal, Threshold);
+#if COLOR_CLASSIFIER == TRUE
+		// Colors trained on the venue replace the threshold, the sums are only for the LEDs
+		ColorData.Color = classify_row(Row, Width, ColorLut, &ColorData.Confidence);
+#else
+		ColorData.Confidence = color_confidence(RedVal, GreenVal, BlueVal, Threshold);
+#endif
+
+		// A misclassified frame at the edge of a cell doesn't reach the floor actions
+		Color = vote_color(&Vote, ColorData.Color, ColorData.Confidence,
+				param_get(PARAM_COLOR_WINDOW), param_get(PARAM_COLOR_CONFIDENCE));
 
 		/* Transfers the colors to a static variable, ActualCell, and erases the previous ones
 		 *  while in lock state so that colors aren't mixed with previous ones.
 		 */
 		chSysLock();
-		ActualCell = ((ActualCell & ~COLOR_B) | Color);
+		if((ActualCell & COLOR_B) != Color){
+			ActualCell = ((ActualCell & ~COLOR_B) | Color);
+			chEvtBroadcastI(&CellChanged_src);
+			chSchRescheduleS();
+		}
 		chSysUnlock();
+		PROBE_END(PROBE_PROCESS_IMAGE);
+		PROBE_END(PROBE_CAMERA_TO_CELL);
+
+		ColorData.Published = Color;
+		telemetry_write(TLM_COLOR, &ColorData, sizeof(ColorData));
+
+#if VISION_FRONT_WALL == TRUE
+		if(!FullFrame){
+			find_front_wall(ImgBuff_ptr);
+		}
+#endif
 
 		// Sets camera output to RGB front LEDs
-		if(!CaptureImage_MetaData.Sleep){
+		if(CaptureImage_MetaData.Request == AWAKE_MODE){
 			set_rgb_led(LED2, RedVal, GreenVal, BlueVal);
 			set_rgb_led(LED8, RedVal, GreenVal, BlueVal);
 		}else{	// only once if thread CaptureImage went to sleep --> switches off the RGB LEDs
@@ -280,16 +519,58 @@ static THD_FUNCTION(ProcessImage, arg){
 /*** PUBLIC FUNCTIONS ***/
 
 void proximity_acquisition_start(void){
-	chThdCreateStatic(waGetProximity, sizeof(waGetProximity), NORMALPRIO, GetProximity, NULL);
+	park_init(&GetProximity_MetaData,
+			chThdCreateStatic(waGetProximity, sizeof(waGetProximity), NORMALPRIO, GetProximity, NULL));
 }
 
 void color_acquisition_start(void){
-	chThdCreateStatic(waCaptureImage, sizeof(waCaptureImage), NORMALPRIO, CaptureImage, NULL);
+	park_init(&CaptureImage_MetaData,
+			chThdCreateStatic(waCaptureImage, sizeof(waCaptureImage), NORMALPRIO, CaptureImage, NULL));
 	chThdCreateStatic(waProcessImage, sizeof(waProcessImage), NORMALPRIO, ProcessImage, NULL);
 }
 
+void distance_acquisition_start(void){
+	park_init(&GetDistance_MetaData,
+			chThdCreateStatic(waGetDistance, sizeof(waGetDistance), NORMALPRIO, GetDistance, NULL));
+}
+
 uint8_t get_actual_cell(void){
 	return ActualCell;
 }
 
+uint8_t get_corridor_length(void){
+	return CorridorLength;
+}
+
+uint32_t get_color_sums(uint32_t *RedVal, uint32_t *GreenVal, uint32_t *BlueVal, uint16_t *Width){
+	uint32_t Frame;
+
+	chSysLock();
+	*RedVal = ColorSums[0];
+	*GreenVal = ColorSums[1];
+	*BlueVal = ColorSums[2];
+	*Width = ColorWidth;
+	Frame = NbFrames;
+	chSysUnlock();
+
+	return Frame;
+}
+
+uint16_t get_front_wall_distance(uint32_t *Age){
+	uint16_t Distance;
+	systime_t Time;
+
+	chSysLock();
+	Distance = FrontWallDistance;
+	Time = FrontWallTime;
+	chSysUnlock();
+
+	*Age = ST2MS(chVTGetSystemTime() - Time);
+	return Distance;
+}
+
+void register_cell_listener(event_listener_t *Listener, eventmask_t Events){
+	chEvtRegisterMask(&CellChanged_src, Listener, Events);
+}
+
 /*** END PUBLIC FUNCTIONS ***/
@@ -7,7 +7,7 @@
  * @date	16.05.2021
  *
  * @brief	Public prototypes of function for object and color detection.
- * 			Define for IR sensors and camera settings.
+ * 			Define for IR sensors, camera settings and the front wall seen by the camera.
  */
 
 #ifndef DATAACQUISITION_H_
@@ -22,11 +22,42 @@
 #define IR6 				5
 #define IR7 				6
 #define IR8 				7
-#define PROXIMITY_THRESHOLD 120		// experimental value
+#define PROXIMITY_THRESHOLD 120		// experimental value, default of PARAM_PROX_THRESHOLD
 
 // Image define
-#define IMAGE_BUFFER_SIZE 	200		// size of a row [pxl]
-#define COLOR_THRESHOLD 	66		// two third of maximal value
+#define IMAGE_BUFFER_SIZE 	200		// size of the widest row [pxl], default of PARAM_IMAGE_WIDTH
+#define COLOR_THRESHOLD 	66		// two third of maximal value, default of PARAM_COLOR_THRESHOLD
+#define COLOR_WINDOW		3		// in [frames], vote before a color is saved, default of PARAM_COLOR_WINDOW
+#define COLOR_MAX_WINDOW	8		// in [frames], maximum of PARAM_COLOR_WINDOW
+#define COLOR_MIN_CONFIDENCE 5		// in [%] from the threshold (of the votes of the pixels with COLOR_CLASSIFIER), frames closer don't vote, default of PARAM_COLOR_CONFIDENCE
+#define COLOR_CLASSIFIER	FALSE	// TRUE --> pixels classified with ColorLut.h (generated by tools/ColorTrain) instead of the threshold
+// RGB gains and contrast of the PO8030, defaults of PARAM_RED_GAIN, ... (CameraCalibration)
+#define RED_GAIN			0x52	// Office - Sunny, Home - Sunny: 0x55, Home - Cloudy: 0x5E
+#define GREEN_GAIN			0x52	// Office - Sunny, Home - Sunny: 0x4F, Home - Cloudy: 0x4F
+#define BLUE_GAIN			0x65	// Office - Sunny, Home - Sunny: 0x65, Home - Cloudy: 0x5D
+#define CAMERA_CONTRAST		20
+
+// Time of flight define
+#define TOF_PERIOD			50		// in [ms], period of the distance readings
+#define TOF_FILTER_SIZE		3		// median of the last three readings, taken while standing still
+#define TOF_SETTLE_TIME		(TOF_PERIOD * (TOF_FILTER_SIZE + 1))	// in [ms], until a median is valid
+#define TOF_SENSOR_OFFSET	35		// in [mm], from the center of the e-puck to the sensor
+#define CELL_SIZE			115		// in [mm]
+#define TOF_MAX_CELLS		6		// longest free corridor trusted, about 0.75 m
+
+// Vision define, the front wall is found at the bottom of the wall in rows above the color row
+#define VISION_FRONT_WALL	FALSE	// TRUE --> VISION_ROWS captured instead of 2, needs 2x12.8 kB of DCMI buffers
+#define VISION_ROWS			32		// rows of the image, the last one is the color row
+#define VISION_ROW_STEP		4		// sensor lines between two rows (vertical subsampling)
+#define VISION_COLOR_LINE	240		// sensor line of the color row
+#define VISION_COLUMNS		16		// in [pxl], center of each row, fixed work per frame
+#define VISION_EDGE_DROP	30		// in [%] of the floor brightness, darker rows are the wall (experimental)
+#define VISION_WALL_ROWS	3		// consecutive darker rows, a single row is noise
+#define VISION_HORIZON_LINE	100		// sensor line of the floor at infinity (experimental)
+#define VISION_DISTANCE_GAIN 1960	// in [mm*line], camera height times focal length (experimental)
+#define VISION_CAMERA_OFFSET 35		// in [mm], from the center of the e-puck to the camera
+#define VISION_MAX_AGE		150		// in [ms], older distances aren't used by the collision check
+#define VISION_NO_WALL		0
 
 
 /**
@@ -41,6 +72,12 @@ void proximity_acquisition_start(void);
  */
 void color_acquisition_start(void);
 
+/**
+ * @brief	Starts thread to measure the free corridor ahead with the VL53L0X with
+ * 			 NORMALPRIO to GetDistance
+ */
+void distance_acquisition_start(void);
+
 /**
  * @brief	Get the static variable ActualCell with the most recent data
  *
@@ -57,4 +94,46 @@ void color_acquisition_start(void);
  */
 uint8_t get_actual_cell(void);
 
+/**
+ * @brief	Returns the number of free cells ahead of the cell where the e-puck stands,
+ * 			 from the time of flight distance to the next front wall.
+ * 			Valid TOF_SETTLE_TIME after the motors stopped, 0 while moving.
+ *
+ * @return	0 (wall in the cell) to TOF_MAX_CELLS
+ */
+uint8_t get_corridor_length(void);
+
+/**
+ * @brief	Returns the distance to the front wall found by the camera (VISION_FRONT_WALL).
+ *
+ * @param Age	Time since the image in [ms]
+ *
+ * @return		In [mm] from the center of the e-puck, VISION_NO_WALL if none is seen
+ */
+uint16_t get_front_wall_distance(uint32_t *Age);
+
+/**
+ * @brief	Returns the sums of the color row of the last image, before extract_color().
+ *
+ * @param [out] RedVal		Sum of the red values scaled to green size
+ * @param [out] GreenVal	Sum of the green values
+ * @param [out] BlueVal		Sum of the blue values scaled to green size
+ * @param [out] Width		Number of pixels of the sums, PARAM_IMAGE_WIDTH or IMAGE_FRAME_WIDTH
+ * 							 while streaming full images
+ *
+ * @return					Number of images processed since the start, changes with every image
+ */
+uint32_t get_color_sums(uint32_t *RedVal, uint32_t *GreenVal, uint32_t *BlueVal, uint16_t *Width);
+
+#if !defined(HOST_BUILD)
+/**
+ * @brief	Registers a listener of the current thread, which receives Events
+ * 			 each time ActualCell changes (wall or color).
+ *
+ * @param Listener	Listener of the current thread
+ * @param Events	Events to signal to the current thread (EVENT_MASK(n))
+ */
+void register_cell_listener(event_listener_t *Listener, eventmask_t Events);
+#endif
+
 #endif /* DATAACQUISITION_H_ */
@@ -8,12 +8,18 @@
  *
  * @brief	Algorithms to solve a maze (Pledge, Left wall follower).
  * 			Some actions depending on wall and color detections.
+ * 			Wall, color and front wall detections, without access to the sensors so that
+ * 			 the trace replay runs them on the host (HOST_BUILD).
  */
 
+#include <stdlib.h>
 #include <leds.h>
 
 #include <main.h>
 #include <SystemControl.h>
+#include <MazeParameters.h>
+#include <DataAcquisition.h>
+#include <DataProcess.h>
 
 
 /*** STATIC VARIABLES ***/
@@ -90,7 +96,9 @@ void floor_color_action(uint8_t Cell_Ref_EPuck){
 		correction_nominal_speed(-CORRECTION_SPEED);
 		break;
 	case BLUE_B:	// Action: spin on itself
-		turn(ONE_TURN);
+		turn(-param_get(PARAM_ONE_TURN));
+		// The square-up of go_next_cell() reads the front wall, not during the spin
+		motor_wait_ready();
 		break;
 	default:
 		break;
@@ -115,4 +123,180 @@ void check_exit(uint8_t Cell_Ref_EPuck, int8_t* EPuckStatus){
 	}
 }
 
+uint8_t scan_walls(const uint16_t *Prox, int32_t Threshold){
+	uint8_t Walls = NO_WALL;
+
+	// No use of IR2 and IR7 sensors
+	if((Prox[IR1] > Threshold) || (Prox[IR8] > Threshold)){
+		Walls |= WALL_FRONT_B;
+	}
+	if(Prox[IR3] > Threshold){
+		Walls |= WALL_RIGHT_B;
+	}
+	if((Prox[IR4] > Threshold) || (Prox[IR5] > Threshold)){
+		Walls |= WALL_BACK_B;
+	}
+	if(Prox[IR6] > Threshold){
+		Walls |= WALL_LEFT_B;
+	}
+	return Walls;
+}
+
+void sum_row_colors(const uint8_t *Row, uint16_t Width, uint32_t *RedVal, uint32_t *GreenVal, uint32_t *BlueVal){
+	*RedVal 	= 0;
+	*GreenVal 	= 0;
+	*BlueVal 	= 0;
+
+	// Extracts and adds all pixels values of one line, by color (format RGB565)
+	for(uint16_t i = 0 ; i < (2 * Width) ; i+=2){	// pixels are acquired on two bytes
+		*RedVal += (Row[i] & 0xF8) >> 2;				// red value scaled to green size
+		*GreenVal += ((Row[i] & 0x07) << 3) +			// green value
+				((Row[i+1] & 0xE0) >> 5);
+		*BlueVal += (Row[i+1] & 0x1F) << 1;			// blue value scaled to green size
+	}
+}
+
+uint8_t extract_color(uint32_t *RedVal, uint32_t *GreenVal, uint32_t *BlueVal, int32_t Threshold){
+	uint32_t MaxVal;
+	uint8_t Color = 0;
+
+	// Checks for the maximum value of RGB
+	if(*RedVal >= *GreenVal && *RedVal >= *BlueVal){
+		MaxVal = *RedVal;
+	}else if(*GreenVal >= *BlueVal){
+		MaxVal = *GreenVal;
+	}else{
+		MaxVal = *BlueVal;
+	}
+
+	// Black image --> no color
+	if(!MaxVal){
+		return 0;
+	}
+
+	// Sets scale to percentage of maximum value
+	*RedVal = (*RedVal*RGB_MAX)/MaxVal;
+	*GreenVal = (*GreenVal*RGB_MAX)/MaxVal;
+	*BlueVal = (*BlueVal*RGB_MAX)/MaxVal;
+
+	// Saves the colors to variable Color
+	if(*RedVal > (uint32_t)Threshold){
+		Color |= RED_B;
+	}
+	if(*GreenVal > (uint32_t)Threshold){
+		Color |= GREEN_B;
+	}
+	if(*BlueVal > (uint32_t)Threshold){
+		Color |= BLUE_B;
+	}
+	return Color;
+}
+
+uint8_t color_confidence(uint32_t RedVal, uint32_t GreenVal, uint32_t BlueVal, int32_t Threshold){
+	uint32_t Percent[3] = {RedVal, GreenVal, BlueVal};
+	int32_t Distance;
+	int32_t Confidence = 100;
+
+	for(uint8_t i = 0 ; i < 3 ; i++){
+		Distance = abs((int32_t)Percent[i] - Threshold);
+		if(Distance < Confidence){
+			Confidence = Distance;
+		}
+	}
+	return Confidence;
+}
+
+uint8_t vote_color(color_vote_t *Vote, uint8_t Color, uint8_t Confidence, uint8_t Window, uint8_t MinConfidence){
+	uint8_t Candidate, NbVotes;
+
+	Vote->Color[Vote->Next] = (Confidence >= MinConfidence) ? Color : COLOR_NO_VOTE;
+	Vote->Next = (Vote->Next + 1) % COLOR_MAX_WINDOW;
+
+	// Each color of the window against the others, at most COLOR_MAX_WINDOW^2 comparisons
+	for(uint8_t i = 1 ; i <= Window ; i++){
+		Candidate = Vote->Color[(Vote->Next + COLOR_MAX_WINDOW - i) % COLOR_MAX_WINDOW];
+		if(Candidate == COLOR_NO_VOTE){
+			continue;
+		}
+
+		NbVotes = 0;
+		for(uint8_t j = 1 ; j <= Window ; j++){
+			if(Vote->Color[(Vote->Next + COLOR_MAX_WINDOW - j) % COLOR_MAX_WINDOW] == Candidate){
+				NbVotes++;
+			}
+		}
+		// Frames without a vote count against every color
+		if(2 * NbVotes > Window){
+			Vote->Published = Candidate;
+			break;
+		}
+	}
+	return Vote->Published;
+}
+
+uint16_t color_lut_index(uint8_t High, uint8_t Low){
+	uint8_t Red = High >> 3;								// 5 bits
+	uint8_t Green = ((High & 0x07) << 3) | (Low >> 5);		// 6 bits
+	uint8_t Blue = Low & 0x1F;								// 5 bits
+
+	return ((Red >> (5 - COLOR_LUT_BITS)) << (2 * COLOR_LUT_BITS))
+			| ((Green >> (6 - COLOR_LUT_BITS)) << COLOR_LUT_BITS)
+			| (Blue >> (5 - COLOR_LUT_BITS));
+}
+
+uint8_t classify_row(const uint8_t *Row, uint16_t Width, const uint8_t *Lut, uint8_t *Confidence){
+	uint16_t Votes[8] = {0};	// per combination of bits 4 to 6
+	uint8_t First = 0, Second = 1;
+
+	for(uint16_t i = 0 ; i < (2 * Width) ; i+=2){
+		Votes[(Lut[color_lut_index(Row[i], Row[i+1])] & COLOR_B) >> BLUE_BIT]++;
+	}
+
+	for(uint8_t c = 1 ; c < 8 ; c++){
+		if(Votes[c] > Votes[First]){
+			Second = First;
+			First = c;
+		}else if((c != First) && (Votes[c] > Votes[Second])){
+			Second = c;
+		}
+	}
+
+	*Confidence = Width ? ((Votes[First] - Votes[Second]) * 100) / Width : 0;
+	return First << BLUE_BIT;
+}
+
+int8_t find_wall_row(const uint8_t *Image, uint16_t Width){
+	const uint8_t *Center = Image + 2 * ((Width - VISION_COLUMNS) / 2);
+	uint32_t RedVal, GreenVal, BlueVal;
+	uint32_t Floor;
+	uint8_t NbDark = 0;
+
+	// Brightness of the floor just ahead, in the color row
+	sum_row_colors(Center + (VISION_ROWS - 1) * 2 * Width, VISION_COLUMNS, &RedVal, &GreenVal, &BlueVal);
+	Floor = RedVal + GreenVal + BlueVal;
+
+	for(int8_t Row = VISION_ROWS - 2 ; Row >= 0 ; Row--){
+		sum_row_colors(Center + Row * 2 * Width, VISION_COLUMNS, &RedVal, &GreenVal, &BlueVal);
+
+		// Edge between the floor and the wall --> the rows above stay dark
+		if((RedVal + GreenVal + BlueVal) * 100 < Floor * (100 - VISION_EDGE_DROP)){
+			if(++NbDark == VISION_WALL_ROWS){
+				return Row + VISION_WALL_ROWS - 1;
+			}
+		}else{
+			NbDark = 0;
+		}
+	}
+	return -1;
+}
+
+uint16_t wall_row_distance(int8_t Row){
+	int32_t Line = VISION_COLOR_LINE - (VISION_ROWS - 1 - Row) * VISION_ROW_STEP;
+
+	if((Row < 0) || (Line <= VISION_HORIZON_LINE)){
+		return VISION_NO_WALL;
+	}
+	return VISION_DISTANCE_GAIN / (Line - VISION_HORIZON_LINE) + VISION_CAMERA_OFFSET;
+}
+
 /*** END PUBLIC FUNCTIONS ***/
@@ -7,11 +7,26 @@
  * @date	16.05.2021
  *
  * @brief	Public prototypes of functions used to solve a maze and actions.
+ * 			Detection of the walls and of the color, shared with the host tools (tools/).
  */
 
 #ifndef DATAPROCESS_H_
 #define DATAPROCESS_H_
 
+// Vote define
+#define COLOR_NO_VOTE		0xFF	// frame too close to the threshold
+// Classifier define, colors of the pixels in a lookup table (COLOR_CLASSIFIER)
+#define COLOR_LUT_BITS		4		// bits of each color in the index of a pixel
+#define COLOR_LUT_SIZE		(1 << (3 * COLOR_LUT_BITS))	// in [bytes]
+
+/*** Structure ***/
+// Last classifications of the camera, the oldest one is replaced (DataAcquisition.h included before)
+typedef struct color_vote_s{
+	uint8_t Color[COLOR_MAX_WINDOW];	// bits 4 to 6 of ActualCell or COLOR_NO_VOTE
+	uint8_t Next;						// index of the next frame
+	uint8_t Published;					// last color with a majority
+} color_vote_t;
+
 /**
  * @brief	Resets the value of the static variable EPuckOrientation to 0.
  */
@@ -132,4 +147,114 @@ void floor_color_action(uint8_t Cell_Ref_EPuck);
  */
 void check_exit(uint8_t Cell_Ref_EPuck, int8_t* EPuckStatus);
 
+/**
+ * @brief	Returns the walls seen by the IR sensors.
+ * 			 IR1 or IR8 --> front, IR3 --> right, IR4 or IR5 --> back, IR6 --> left.
+ *
+ * @param Prox		Values of the 8 IR sensors
+ * @param Threshold	A wall is seen above (PARAM_PROX_THRESHOLD)
+ *
+ * @return			Bits 0 to 3 of ActualCell (WALL_FRONT_B, ...)
+ */
+uint8_t scan_walls(const uint16_t *Prox, int32_t Threshold);
+
+/**
+ * @brief	Adds the values of all the pixels of one camera row, by color.
+ *
+ * @param [in] Row			Pixels in RGB565, two bytes each
+ * @param [in] Width		Number of pixels
+ * @param [out] RedVal		Sum of the red values scaled to green size
+ * @param [out] GreenVal	Sum of the green values
+ * @param [out] BlueVal		Sum of the blue values scaled to green size
+ */
+void sum_row_colors(const uint8_t *Row, uint16_t Width, uint32_t *RedVal, uint32_t *GreenVal, uint32_t *BlueVal);
+
+/**
+ * @brief	Returns the colors of the floor from the sums of one camera row.
+ * 			 A color is set if its sum is above Threshold % of the highest one.
+ *
+ * @param [in,out] RedVal	Sum of the red values scaled to green size, then in [%] of the highest sum
+ * @param [in,out] GreenVal	Sum of the green values, then in [%] of the highest sum
+ * @param [in,out] BlueVal	Sum of the blue values scaled to green size, then in [%] of the highest sum
+ * @param [in] Threshold	In [%] of the highest sum (PARAM_COLOR_THRESHOLD)
+ *
+ * @return					Bits 4 to 6 of ActualCell (RED_B, GREEN_B, BLUE_B)
+ */
+uint8_t extract_color(uint32_t *RedVal, uint32_t *GreenVal, uint32_t *BlueVal, int32_t Threshold);
+
+/**
+ * @brief	Returns the confidence of the colors of one frame, the distance
+ * 			 of the closest color to the threshold.
+ *
+ * @param RedVal	Red sum in [%] of the highest sum, from extract_color()
+ * @param GreenVal	Green sum in [%] of the highest sum, from extract_color()
+ * @param BlueVal	Blue sum in [%] of the highest sum, from extract_color()
+ * @param Threshold	In [%] of the highest sum (PARAM_COLOR_THRESHOLD)
+ *
+ * @return			In [%], 0 if a color is on the threshold
+ */
+uint8_t color_confidence(uint32_t RedVal, uint32_t GreenVal, uint32_t BlueVal, int32_t Threshold);
+
+/**
+ * @brief	Adds the colors of one frame to the vote and returns the color to save.
+ * 			A color is saved once it has the majority of the last Window frames,
+ * 			 until then the previous one is kept. A window of 1 and a confidence of 0
+ * 			 save the colors of every frame.
+ *
+ * @param [in,out] Vote		Last frames, zeroed before the first one
+ * @param [in] Color		Bits 4 to 6 of ActualCell, from extract_color()
+ * @param [in] Confidence	From color_confidence()
+ * @param [in] Window		Frames of the vote, 1 to COLOR_MAX_WINDOW (PARAM_COLOR_WINDOW)
+ * @param [in] MinConfidence	Frames with a lower confidence don't vote (PARAM_COLOR_CONFIDENCE)
+ *
+ * @return					Bits 4 to 6 of ActualCell (RED_B, GREEN_B, BLUE_B)
+ */
+uint8_t vote_color(color_vote_t *Vote, uint8_t Color, uint8_t Confidence, uint8_t Window, uint8_t MinConfidence);
+
+/**
+ * @brief	Returns the index of a pixel in the lookup table of the colors,
+ * 			 the COLOR_LUT_BITS highest bits of red, green and blue.
+ *
+ * @param High	First byte of the pixel in RGB565
+ * @param Low	Second byte of the pixel in RGB565
+ *
+ * @return		0 to COLOR_LUT_SIZE-1
+ */
+uint16_t color_lut_index(uint8_t High, uint8_t Low);
+
+/**
+ * @brief	Returns the colors of the floor from the pixels of one camera row,
+ * 			 each pixel votes for its color in the lookup table (ColorLut.h, tools/ColorTrain).
+ *
+ * @param [in] Row			Pixels in RGB565, two bytes each
+ * @param [in] Width		Number of pixels
+ * @param [in] Lut			Colors of the pixels, COLOR_LUT_SIZE entries of bits 4 to 6 of ActualCell
+ * @param [out] Confidence	In [%] of the pixels, votes of the color minus those of the next one
+ *
+ * @return					Bits 4 to 6 of ActualCell, the color with the most votes
+ */
+uint8_t classify_row(const uint8_t *Row, uint16_t Width, const uint8_t *Lut, uint8_t *Confidence);
+
+/**
+ * @brief	Returns the row of the bottom of the front wall in an image of VISION_ROWS rows.
+ * 			From the color row upwards, the wall starts at the first of VISION_WALL_ROWS
+ * 			 rows darker than the floor by VISION_EDGE_DROP %, on VISION_COLUMNS pixels.
+ *
+ * @param Image		Rows in RGB565, the last one is the color row
+ * @param Width		Number of pixels of a row, at least VISION_COLUMNS
+ *
+ * @return			Row of the bottom of the wall, -1 if no wall is seen
+ */
+int8_t find_wall_row(const uint8_t *Image, uint16_t Width);
+
+/**
+ * @brief	Returns the distance to a wall whose bottom is on a row of the image,
+ * 			 with the floor seen by a pinhole camera (VISION_DISTANCE_GAIN).
+ *
+ * @param Row	From find_wall_row()
+ *
+ * @return		In [mm] from the center of the e-puck, VISION_NO_WALL for -1
+ */
+uint16_t wall_row_distance(int8_t Row);
+
 #endif /* DATAPROCESS_H_ */
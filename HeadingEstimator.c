@@ -0,0 +1,129 @@
+/**
+ * @file	HeadingEstimator.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Thread fusing the gyroscope with the odometry at the rate of the IMU.
+ * 			The gyro follows the real rotation even if a wheel slips, the odometry
+ * 			 doesn't drift with the bias. The bias is learnt while standing still.
+ */
+
+#if !defined(HOST_BUILD)
+#include <sensors/imu.h>
+#endif
+
+#include <main.h>
+#include <HeadingEstimator.h>
+#include <SystemControl.h>
+#include <LatencyProbe.h>
+
+#if defined(HOST_BUILD)
+// The simulator of the host tools gives the samples and reads the heading in one thread
+#define chSysLock()
+#define chSysUnlock()
+#endif
+
+
+/*** STATIC VARIABLES ***/
+// Written by heading_update() only, read in lock
+static float Heading 		= 0;	// in [rad], fused
+static float Odometry 		= 0;	// in [rad]
+static float Rate 			= 0;	// in [rad/s], fused rotation of the last sample
+static float Bias 			= 0;	// in [rad/s]
+static uint32_t SampleTime 	= 0;	// in [cycles], last IMU sample
+
+
+#if !defined(HOST_BUILD)
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Thread which integrates every IMU sample. The rotation of the wheels
+ * 			 is given by the speeds applied to the motors, so the resets
+ * 			 of the motor positions at each command have no effect.
+ */
+static THD_WORKING_AREA(waEstimateHeading, 256);
+static THD_FUNCTION(EstimateHeading, arg) {
+
+	chRegSetThreadName(__FUNCTION__);
+	(void)arg;
+
+	messagebus_topic_t *ImuTopic = messagebus_find_topic_blocking(&bus, "/imu");
+	imu_msg_t ImuMsg;
+	int16_t SpeedLeft, SpeedRight;
+
+	SampleTime = PROBE_NOW();
+
+	/*** INFINITE LOOP ***/
+	while(1){
+		messagebus_topic_wait(ImuTopic, &ImuMsg, sizeof(ImuMsg));
+
+		motor_get_speed(&SpeedLeft, &SpeedRight);
+		heading_update(ImuMsg.gyro_rate[Z_AXIS], SpeedLeft, SpeedRight, PROBE_NOW());
+	}
+	/*** END INFINITE LOOP ***/
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+#endif
+
+/*** PUBLIC FUNCTIONS ***/
+
+#if !defined(HOST_BUILD)
+void heading_estimator_start(void){
+	chThdCreateStatic(waEstimateHeading, sizeof(waEstimateHeading), NORMALPRIO+2, EstimateHeading, NULL);
+}
+#else
+void heading_reset(void){
+	Heading = 0;
+	Odometry = 0;
+	Rate = 0;
+	Bias = 0;
+	SampleTime = PROBE_NOW();
+}
+#endif
+
+void heading_update(float Gyro, int16_t SpeedLeft, int16_t SpeedRight, uint32_t Now){
+	float Dt = (float)(Now - SampleTime) / (PROBE_CYCLES_PER_US * 1000000.0f);
+	// Counterclockwise is positive, as for the gyro
+	float OdometryRate = (SpeedRight - SpeedLeft) / (MM_2_STEP * WHEEL_DISTANCE);
+	float FusedRate;
+
+	if((SpeedLeft == STOP_SPEED) && (SpeedRight == STOP_SPEED)){
+		// Standing still --> the gyro only gives its bias, the heading doesn't move
+		Bias += HEADING_BIAS_GAIN * (Gyro - Bias);
+		FusedRate = 0;
+	}else{
+		FusedRate = HEADING_GYRO_WEIGHT * (Gyro - Bias) + (1 - HEADING_GYRO_WEIGHT) * OdometryRate;
+	}
+
+	chSysLock();
+	// Trapezoid of the last two samples, the new rate alone runs ahead during the ramp of a turn
+	Heading += (Rate + FusedRate) / 2 * Dt;
+	Odometry += OdometryRate * Dt;
+	Rate = FusedRate;
+	SampleTime = Now;
+	chSysUnlock();
+}
+
+float heading_get(void){
+	float Fused;
+
+	chSysLock();
+	Fused = Heading + Rate * (float)(PROBE_NOW() - SampleTime) / (PROBE_CYCLES_PER_US * 1000000.0f);
+	chSysUnlock();
+
+	return Fused;
+}
+
+float heading_get_odometry(void){
+	return Odometry;
+}
+
+float heading_get_bias(void){
+	return Bias;
+}
+
+/*** END PUBLIC FUNCTIONS ***/
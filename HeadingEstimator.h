@@ -0,0 +1,64 @@
+/**
+ * @file	HeadingEstimator.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of the heading estimator.
+ * 			The heading fuses the rotation of the wheels (applied speeds)
+ * 			 with the gyroscope of the IMU, counterclockwise is positive.
+ */
+
+#ifndef HEADINGESTIMATOR_H_
+#define HEADINGESTIMATOR_H_
+
+// Heading define
+#define HEADING_USE_GYRO		TRUE	// TRUE --> turns closed on the heading, needs the IMU started
+#define HEADING_GYRO_WEIGHT		0.95f	// share of the gyro in the fused rotation, the rest is odometry
+#define HEADING_BIAS_GAIN		0.01f	// low-pass gain of the gyro bias, updated while standing still
+#define HEADING_TOLERANCE		0.005f	// in [rad], about 0.3 degree, a turn ends this close to its target
+#define HEADING_STEP_MARGIN		10		// in [%], extra steps allowed to a turn closed on the heading
+
+
+/**
+ * @brief	Starts thread to fuse every IMU sample with the odometry with
+ * 			NORMALPRIO+2 to EstimateHeading
+ */
+void heading_estimator_start(void);
+
+/**
+ * @brief	Integrates one IMU sample: fuses the gyro with the applied speeds, or learns
+ * 			 the bias of the gyro if both speeds are STOP_SPEED. Called by EstimateHeading.
+ *
+ * @param Gyro		Rotation around the Z axis given by the IMU in [rad/s]
+ * @param Now		PROBE_NOW() at the sample
+ */
+void heading_update(float Gyro, int16_t SpeedLeft, int16_t SpeedRight, uint32_t Now);
+
+#if defined(HOST_BUILD)
+/**
+ * @brief	Clears the heading and the bias, the simulator of the host tools
+ * 			 calls it at the reset of the e-puck and gives the IMU samples.
+ */
+void heading_reset(void);
+#endif
+
+/**
+ * @brief	Returns the fused heading in [rad], extrapolated with the last rotation speed
+ * 			 since the last IMU sample so that a fast turn doesn't stop late.
+ */
+float heading_get(void);
+
+/**
+ * @brief	Returns the heading given by the odometry only in [rad].
+ */
+float heading_get_odometry(void);
+
+/**
+ * @brief	Returns the estimated bias of the gyro in [rad/s].
+ */
+float heading_get_bias(void);
+
+#endif /* HEADINGESTIMATOR_H_ */
@@ -0,0 +1,203 @@
+/**
+ * @file	ImageStream.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Stream of full images to the host over USB serial, while the modes run.
+ * 			CaptureImage gives an image once captured, thread SendTelemetry
+ * 			 sends it in chunks after the records (TLM_IMAGE blocks). The host acknowledges
+ * 			 every chunk, at most IMAGE_CREDITS chunks are sent ahead, so the USB buffers
+ * 			 never hold more than what the host reads.
+ * 			The image is sent from the DCMI buffer itself, there is no room for a copy:
+ * 			 CaptureImage waits before overwriting it, the rate of the colors drops
+ * 			 to two images per streamed image when the host is slower than the camera.
+ */
+
+#include <main.h>
+#include <ImageStream.h>
+#include <MazeMap.h>
+#include <ModeManager.h>
+#include <Telemetry.h>
+
+
+/*** STATIC VARIABLES ***/
+static BSEMAPHORE_DECL(FrameSent_sem, TRUE);
+// Commands of the host, written by SendTelemetry only
+static volatile uint8_t Streaming 	= FALSE;
+static uint8_t Encoding 			= IMAGE_RAW;
+static uint8_t Credits 				= 0;
+static systime_t LastAck 			= 0;
+// Image being sent, NULL once sent. Set by CaptureImage, cleared by SendTelemetry (or CaptureImage if no host)
+static const uint8_t * volatile SentFrame = NULL;
+static uint16_t FrameId 			= 0;
+static uint8_t Chunk 				= 0;
+// Chunk encoded with the RLE, written by SendTelemetry only
+static uint8_t Encoded[IMAGE_CHUNK_SIZE];
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Encodes the pixels of a chunk as (count, pixel high, pixel low) triplets.
+ *
+ * @return	In [bytes], 0 if the chunk would be longer than IMAGE_CHUNK_SIZE (noisy image)
+ */
+static uint16_t encode_rle(const uint8_t *Raw){
+	uint16_t Length = 0;
+	uint16_t i = 0;
+	uint8_t Count;
+
+	while(i < IMAGE_CHUNK_SIZE){
+		Count = 1;
+		while((i + 2 * Count < IMAGE_CHUNK_SIZE) && (Count < IMAGE_MAX_RUN)
+				&& (Raw[i + 2 * Count] == Raw[i]) && (Raw[i + 2 * Count + 1] == Raw[i + 1])){
+			Count++;
+		}
+		if(Length + 3 > IMAGE_CHUNK_SIZE){
+			return 0;
+		}
+		Encoded[Length++] = Count;
+		Encoded[Length++] = Raw[i];
+		Encoded[Length++] = Raw[i + 1];
+		i += 2 * Count;
+	}
+	return Length;
+}
+
+/**
+ * @brief	Frees the streamed buffer for CaptureImage.
+ */
+static void release_frame(void){
+	SentFrame = NULL;
+	chBSemSignal(&FrameSent_sem);
+}
+
+/**
+ * @brief	Sends the chunks of the image allowed by the acknowledgements of the host.
+ * 			Stream handler of thread SendTelemetry.
+ */
+static void send_chunks(void){
+	const uint8_t *Frame = SentFrame;
+	const uint8_t *Data;
+	tlm_image_t Header;
+
+	if(Frame == NULL){
+		return;
+	}
+
+	// Host gone --> the buffer is given back to the camera
+	if(chVTGetSystemTime() - LastAck > MS2ST(IMAGE_ACK_TIMEOUT)){
+		Streaming = FALSE;
+		release_frame();
+		return;
+	}
+
+	while(Credits && (Chunk < IMAGE_NB_CHUNKS)){
+		Data = Frame + Chunk * IMAGE_CHUNK_SIZE;
+		Header.Length = (Encoding == IMAGE_RLE) ? encode_rle(Data) : 0;
+		Header.Encoding = Header.Length ? IMAGE_RLE : IMAGE_RAW;
+		if(Header.Encoding == IMAGE_RLE){
+			Data = Encoded;
+		}else{
+			Header.Length = IMAGE_CHUNK_SIZE;
+		}
+		Header.Frame = FrameId;
+		Header.Chunk = Chunk;
+		Header.RawLength = IMAGE_CHUNK_SIZE;
+		Header.Checksum = 0;
+		for(uint16_t i = 0 ; i < Header.Length ; i++){
+			Header.Checksum += Data[i];
+		}
+
+		// Cut by a timeout --> the host resynchronises on the next record, the image is incomplete
+		telemetry_write_block(TLM_IMAGE, &Header, sizeof(Header), Data, Header.Length);
+		Credits--;
+		Chunk++;
+	}
+
+	if(Chunk == IMAGE_NB_CHUNKS){
+		release_frame();
+	}
+}
+
+/**
+ * @brief	Starts or stops the stream. Command of the host (IMAGE_STREAM_KEY).
+ */
+static void toggle_stream(void){
+	Credits = IMAGE_CREDITS;
+	LastAck = chVTGetSystemTime();
+	Streaming = !Streaming;
+}
+
+/**
+ * @brief	Switches the RLE on or off, from the next chunk. Command of the host (IMAGE_RLE_KEY).
+ */
+static void toggle_rle(void){
+	Encoding = (Encoding == IMAGE_RAW) ? IMAGE_RLE : IMAGE_RAW;
+}
+
+/**
+ * @brief	One more chunk may be sent. Command of the host (IMAGE_ACK_KEY).
+ */
+static void acknowledge_chunk(void){
+	if(Credits < IMAGE_CREDITS){
+		Credits++;
+	}
+	LastAck = chVTGetSystemTime();
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** PUBLIC FUNCTIONS ***/
+
+void image_stream_init(void){
+	telemetry_set_command(IMAGE_STREAM_KEY, toggle_stream);
+	telemetry_set_command(IMAGE_RLE_KEY, toggle_rle);
+	telemetry_set_command(IMAGE_ACK_KEY, acknowledge_chunk);
+	telemetry_set_stream(send_chunks);
+}
+
+uint8_t image_stream_enabled(void){
+	return Streaming;
+}
+
+void image_stream_offer(const uint8_t *Image, uint8_t Cell){
+	tlm_frame_t FrameData;
+
+	if(!Streaming || (SentFrame != NULL)){
+		return;
+	}
+
+	FrameData.Frame = ++FrameId;
+	FrameData.Width = IMAGE_FRAME_WIDTH;
+	FrameData.Height = IMAGE_FRAME_HEIGHT;
+	FrameData.NbChunks = IMAGE_NB_CHUNKS;
+	FrameData.Selector = mode_get_selector();
+	FrameData.Cell = Cell;
+	map_get_pose(&FrameData.X, &FrameData.Y, &FrameData.Heading);
+	telemetry_write(TLM_FRAME, &FrameData, sizeof(FrameData));
+
+	// Chunk set before the image is given to SendTelemetry
+	Chunk = 0;
+	chBSemReset(&FrameSent_sem, TRUE);
+	__atomic_store_n(&SentFrame, Image, __ATOMIC_RELEASE);
+}
+
+void image_stream_wait(const uint8_t *Last){
+	const uint8_t *Frame = SentFrame;
+
+	if((Frame == NULL) || ((Last != NULL) && (Frame == Last))){
+		return;
+	}
+
+	// No host to send it (USB unplugged) --> SendTelemetry doesn't release it
+	if(chBSemWaitTimeout(&FrameSent_sem, MS2ST(IMAGE_WAIT_TIMEOUT)) == MSG_TIMEOUT){
+		Streaming = FALSE;
+		SentFrame = NULL;
+	}
+}
+
+/*** END PUBLIC FUNCTIONS ***/
@@ -0,0 +1,72 @@
+/**
+ * @file	ImageStream.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of the stream of full images to the host over USB serial,
+ * 			 to collect the images of the training and of the calibration.
+ * 			Defines shared with the host receiver (tools/ImageReceiver.c).
+ */
+
+#ifndef IMAGESTREAM_H_
+#define IMAGESTREAM_H_
+
+#include <stdint.h>
+
+// Image define, whole sensor subsampled by 4, the two DCMI buffers fill MAX_BUFF_SIZE
+#define IMAGE_FRAME_WIDTH	160		// in [pxl]
+#define IMAGE_FRAME_HEIGHT	120		// in [pxl]
+#define IMAGE_FRAME_SIZE	(IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT * 2)	// in [bytes], RGB565
+#define IMAGE_COLOR_ROW		60		// row of the color line (VISION_COLOR_LINE / 4)
+// Stream define
+#define IMAGE_CHUNK_SIZE	1920	// in [bytes], 6 rows
+#define IMAGE_NB_CHUNKS		(IMAGE_FRAME_SIZE / IMAGE_CHUNK_SIZE)
+#define IMAGE_CREDITS		8		// chunks sent ahead of the acknowledgements of the host
+#define IMAGE_ACK_TIMEOUT	500		// in [ms], without acknowledgement the host is gone, the stream stops
+#define IMAGE_WAIT_TIMEOUT	(2 * IMAGE_ACK_TIMEOUT)	// in [ms], longest wait of CaptureImage for the streamed buffer
+#define IMAGE_MAX_RUN		255		// pixels of one RLE triplet
+// Encoding define
+#define IMAGE_RAW			0
+#define IMAGE_RLE			1		// (count, pixel high, pixel low) triplets
+// Command define
+#define IMAGE_STREAM_KEY	'i'		// telemetry command to start or stop the stream
+#define IMAGE_RLE_KEY		'z'		// telemetry command to switch the RLE on or off
+#define IMAGE_ACK_KEY		'a'		// telemetry command of the host for each chunk received
+
+
+/**
+ * @brief	Registers the telemetry commands and the stream handler.
+ * 			Called before color_acquisition_start().
+ */
+void image_stream_init(void);
+
+/**
+ * @brief	Returns 1 while the host asks for full images, CaptureImage captures them
+ * 			 instead of the color row.
+ */
+uint8_t image_stream_enabled(void);
+
+/**
+ * @brief	Takes a full image to stream if the previous one is sent, and sends its TLM_FRAME.
+ * 			Called by CaptureImage only, once the image is captured, so that
+ * 			 image_stream_wait() always sees the last streamed image.
+ *
+ * @param Image		Full image in RGB565, IMAGE_FRAME_SIZE bytes
+ * @param Cell		ActualCell when the image was captured
+ */
+void image_stream_offer(const uint8_t *Image, uint8_t Cell);
+
+/**
+ * @brief	Waits until the buffer of the next capture isn't streamed anymore,
+ * 			 at most IMAGE_WAIT_TIMEOUT, then the stream stops.
+ * 			With two DCMI buffers, the next capture overwrites the image before the last one.
+ * 			Called by CaptureImage only, before a capture.
+ *
+ * @param Last		Last captured image (dcmi_get_last_image_ptr()), NULL before the DCMI is prepared again
+ */
+void image_stream_wait(const uint8_t *Last);
+
+#endif /* IMAGESTREAM_H_ */
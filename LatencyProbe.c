@@ -0,0 +1,88 @@
+/**
+ * @file	LatencyProbe.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Latency histograms of the probes and their dump as telemetry.
+ */
+
+#if defined(HOST_BUILD)
+#include <time.h>
+#else
+#include <main.h>
+#endif
+
+#include <LatencyProbe.h>
+#include <Telemetry.h>
+
+
+/*** GLOBAL VARIABLES ***/
+volatile uint32_t ProbeStart[PROBE_NB];
+
+
+/*** STATIC VARIABLES ***/
+// Counts since the last dump, saturated to the size of the telemetry fields
+static uint16_t Histogram[PROBE_NB][PROBE_NB_BUCKETS];
+
+
+/*** PUBLIC FUNCTIONS ***/
+
+#if defined(HOST_BUILD)
+uint32_t probe_host_now(void){
+	struct timespec Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (uint32_t)((Now.tv_sec * 1000000000ULL) + Now.tv_nsec);
+}
+#endif
+
+void probe_init(void){
+#if !defined(HOST_BUILD)
+	// Cycle counter is also the realtime counter of the kernel, enabling it twice is harmless
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+	telemetry_set_command(PROBE_DUMP_KEY, probe_dump);
+}
+
+void probe_record(uint8_t Id, uint32_t Cycles){
+	uint32_t Micros = Cycles / PROBE_CYCLES_PER_US;
+	uint8_t Bucket = 0;
+
+	// Index of the highest bit set (CLZ instruction) gives the bucket
+	if(Micros){
+		Bucket = 32 - __builtin_clz(Micros);
+		if(Bucket >= PROBE_NB_BUCKETS){
+			Bucket = PROBE_NB_BUCKETS - 1;
+		}
+	}
+
+	if(Histogram[Id][Bucket] < UINT16_MAX){
+		Histogram[Id][Bucket]++;
+	}
+}
+
+void probe_dump(void){
+	tlm_histogram_t HistogramData;
+
+	for(uint8_t Id = 0 ; Id < PROBE_NB ; Id++){
+		HistogramData.Probe = Id;
+		for(uint8_t First = 0 ; First < PROBE_NB_BUCKETS ; First += TLM_HISTOGRAM_BUCKETS){
+			HistogramData.FirstBucket = First;
+			for(uint8_t i = 0 ; i < TLM_HISTOGRAM_BUCKETS ; i++){
+				if((First + i) < PROBE_NB_BUCKETS){
+					HistogramData.Counts[i] = Histogram[Id][First + i];
+					Histogram[Id][First + i] = 0;
+				}else{
+					HistogramData.Counts[i] = 0;
+				}
+			}
+			telemetry_write(TLM_HISTOGRAM, &HistogramData, sizeof(HistogramData));
+		}
+	}
+}
+
+/*** END PUBLIC FUNCTIONS ***/
@@ -0,0 +1,70 @@
+/**
+ * @file	LatencyProbe.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Begin/end probes measuring the duration of the hot paths with the
+ * 			 DWT cycle counter of the Cortex-M4, saved in fixed-bucket histograms.
+ * 			With HOST_BUILD defined, clock_gettime() replaces the cycle counter.
+ */
+
+#ifndef LATENCYPROBE_H_
+#define LATENCYPROBE_H_
+
+#include <stdint.h>
+
+// Probe define
+#define PROBE_PROCESS_IMAGE		0	// per-frame loop of ProcessImage
+#define PROBE_PROXIMITY_SCAN	1	// wall scan of GetProximity
+#define PROBE_CAMERA_TO_CELL	2	// image captured --> colors saved in ActualCell
+#define PROBE_VISION_WALL		3	// front wall search of ProcessImage (VISION_FRONT_WALL)
+#define PROBE_NB				4
+// Histogram define
+#define PROBE_NB_BUCKETS		14	// bucket 0: < 1 us, bucket n: [2^(n-1), 2^n[ us, last: >= 4096 us
+#define PROBE_DUMP_KEY			'h'	// telemetry command to dump the histograms
+
+// Time base define
+#if defined(HOST_BUILD)
+#define PROBE_CYCLES_PER_US		1000	// clock_gettime() resolution is the nanosecond
+#define PROBE_NOW()				probe_host_now()
+uint32_t probe_host_now(void);
+#else
+#include <hal.h>
+#define PROBE_CYCLES_PER_US		(STM32_SYSCLK / 1000000)
+#define PROBE_NOW()				(DWT->CYCCNT)
+#endif
+
+/* Begin and end of a measurement. The start is saved per probe,
+ *  so a probe can begin in one thread and end in another one.
+ *  Only one measurement of a given probe can be in progress at a time.
+ */
+#define PROBE_BEGIN(Id)			(ProbeStart[(Id)] = PROBE_NOW())
+#define PROBE_END(Id)			probe_record((Id), PROBE_NOW() - ProbeStart[(Id)])
+
+extern volatile uint32_t ProbeStart[PROBE_NB];
+
+
+/**
+ * @brief	Enables the DWT cycle counter and registers the telemetry command
+ * 			 PROBE_DUMP_KEY to dump the histograms.
+ */
+void probe_init(void);
+
+/**
+ * @brief	Adds a duration to the histogram of a probe. Called by PROBE_END().
+ *
+ * @param Id		Probe (PROBE_PROCESS_IMAGE, ...)
+ * @param Cycles	Duration in cycles of the time base
+ */
+void probe_record(uint8_t Id, uint32_t Cycles);
+
+/**
+ * @brief	Sends the histograms as TLM_HISTOGRAM records and clears them,
+ * 			 each dump holds the measurements done since the previous one.
+ */
+void probe_dump(void);
+
+#endif /* LATENCYPROBE_H_ */
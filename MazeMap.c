@@ -0,0 +1,541 @@
+/**
+ * @file	MazeMap.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Map of the maze built during the exploration.
+ * 			Colored cells are recorded as waypoints, the order to visit them
+ * 			 is computed exactly (Held-Karp) on the distances of the mapped cells.
+ */
+
+#include <main.h>
+#include <SystemControl.h>
+#include <MazeMap.h>
+
+
+/*** STATIC VARIABLES ***/
+/* Each cell of the map uses the same bits as ActualCell but in the absolute frame.
+ * 		Bit 0 --> north wall
+ * 		Bit 1 --> east wall
+ * 		Bit 2 --> south wall
+ * 		Bit 3 --> west wall
+ * 		Bits 4 to 6 --> color of the floor
+ * 		Bit 7 --> cell visited
+ */
+static uint8_t Map[MAP_CELLS];
+static uint8_t PosX 			= MAP_ORIGIN;
+static uint8_t PosY 			= MAP_ORIGIN;
+static uint8_t Heading 			= NORTH;
+static uint16_t NbMoves 		= 0;
+static uint8_t LoopClosed 		= 0;
+static uint8_t Departure[MAP_CELLS];	// bit n set --> the e-puck has left the cell heading n
+// Cells out of the exit, closed as dead ends until visited cells are found around them
+static uint8_t ExitX[MAX_EXITS];
+static uint8_t ExitY[MAX_EXITS];
+static uint8_t ExitCount 		= 0;
+// Visited coordinates, the exit is out of them (inner cells without walls are not)
+static uint8_t MinX, MaxX, MinY, MaxY;
+
+// Waypoints and cached distance fields (one field per waypoint, valid until the map changes)
+static uint8_t Waypoint[MAX_WAYPOINTS];
+static uint8_t WaypointCount 	= 0;
+static uint8_t WaypointDropped 	= 0;	// colored cells found once the waypoints are full
+static uint8_t DistField[MAX_WAYPOINTS][MAP_CELLS];
+static uint8_t FieldValid 		= 0;	// bit n set --> DistField[n] is up to date
+
+// Route through the waypoints
+static uint8_t RouteOrder[MAX_WAYPOINTS];
+static uint8_t RouteLength 		= 0;
+static uint8_t RouteIdx 		= 0;
+static uint8_t RoutePlanned 	= 0;
+static uint8_t WaypointDone 	= 0;	// bit n set --> waypoint n has been visited by the route
+
+// Working memory of BFS and Held-Karp, kept static to spare the stack of the caller
+static uint8_t BfsQueue[MAP_CELLS];
+static uint8_t FrontierField[MAP_CELLS];
+static uint16_t TourCost[1 << MAX_WAYPOINTS][MAX_WAYPOINTS];
+static uint8_t TourParent[1 << MAX_WAYPOINTS][MAX_WAYPOINTS];
+
+// Relative direction to the steps given to go_next_cell (forward, right, backward, left)
+static const int16_t RelativeDirection[4] = {MOVE_FORWARD, RIGHT_TURN, BACKWARD_TURN, LEFT_TURN};
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Returns the index in the map of the coordinates, wraps around the borders.
+ */
+static uint8_t cell_index(uint8_t X, uint8_t Y){
+	return ((Y & (MAP_SIZE-1)) * MAP_SIZE) + (X & (MAP_SIZE-1));
+}
+
+/**
+ * @brief	Returns the index of the neighbor of a cell in an absolute direction.
+ */
+static uint8_t neighbor_index(uint8_t Idx, uint8_t Direction){
+	uint8_t X = Idx % MAP_SIZE;
+	uint8_t Y = Idx / MAP_SIZE;
+
+	switch (Direction) {
+	case NORTH:
+		Y++;
+		break;
+	case EAST:
+		X++;
+		break;
+	case SOUTH:
+		Y--;
+		break;
+	default:	// WEST
+		X--;
+		break;
+	}
+	return cell_index(X, Y);
+}
+
+/**
+ * @brief	Checks if the e-puck can go from a visited cell to its neighbor.
+ */
+static uint8_t is_passable(uint8_t Idx, uint8_t Direction){
+	return !(Map[Idx] & (1 << Direction)) && (Map[neighbor_index(Idx, Direction)] & VISITED_B);
+}
+
+/**
+ * @brief	Checks if a visited cell has an open side towards an unvisited cell.
+ *
+ * @return	Absolute direction of the unvisited cell, UNREACHABLE if none
+ */
+static uint8_t frontier_side(uint8_t Idx){
+	if(Map[Idx] & VISITED_B){
+		for(uint8_t Dir = NORTH ; Dir <= WEST ; Dir++){
+			if(!(Map[Idx] & (1 << Dir)) && !(Map[neighbor_index(Idx, Dir)] & VISITED_B)){
+				return Dir;
+			}
+		}
+	}
+	return UNREACHABLE;
+}
+
+/**
+ * @brief	Checks if a cell has been recorded as out of the exit of the maze.
+ */
+static uint8_t is_exit(uint8_t Idx){
+	for(uint8_t n = 0 ; n < ExitCount ; n++){
+		if(cell_index(ExitX[n], ExitY[n]) == Idx){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief	Fills a distance field (in cells) from a source cell with a
+ * 			 breadth-first search over the visited cells.
+ */
+static void compute_distance_field(uint8_t Source, uint8_t* Field){
+	uint16_t Head = 0;
+	uint16_t Tail = 0;
+	uint8_t Idx, Next;
+
+	for(uint16_t i = 0 ; i < MAP_CELLS ; i++){
+		Field[i] = UNREACHABLE;
+	}
+
+	Field[Source] = 0;
+	BfsQueue[Tail++] = Source;
+
+	while(Head < Tail){
+		Idx = BfsQueue[Head++];
+		for(uint8_t Dir = NORTH ; Dir <= WEST ; Dir++){
+			if(is_passable(Idx, Dir)){
+				Next = neighbor_index(Idx, Dir);
+				if(Field[Next] == UNREACHABLE){
+					Field[Next] = Field[Idx] + 1;
+					BfsQueue[Tail++] = Next;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief	Computes the distance fields of the waypoints which are not cached.
+ */
+static void update_distance_cache(void){
+	for(uint8_t n = 0 ; n < WaypointCount ; n++){
+		if(!(FieldValid & (1 << n))){
+			compute_distance_field(Waypoint[n], DistField[n]);
+			FieldValid |= (1 << n);
+		}
+	}
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** PUBLIC FUNCTIONS ***/
+
+void map_reset(void){
+	for(uint16_t i = 0 ; i < MAP_CELLS ; i++){
+		Map[i] = 0;
+		Departure[i] = 0;
+	}
+	PosX 			= MAP_ORIGIN;
+	PosY 			= MAP_ORIGIN;
+	Heading 		= NORTH;
+	NbMoves 		= 0;
+	LoopClosed 		= 0;
+	ExitCount 		= 0;
+	MinX 			= MAP_ORIGIN;
+	MaxX 			= MAP_ORIGIN;
+	MinY 			= MAP_ORIGIN;
+	MaxY 			= MAP_ORIGIN;
+	WaypointCount 	= 0;
+	WaypointDropped = 0;
+	FieldValid 		= 0;
+	RouteLength 	= 0;
+	RouteIdx 		= 0;
+	RoutePlanned 	= 0;
+	WaypointDone 	= 0;
+}
+
+void map_record_cell(uint8_t Cell_Ref_EPuck){
+	uint8_t Idx = cell_index(PosX, PosY);
+	uint8_t NewCell = VISITED_B | (Cell_Ref_EPuck & COLOR_B);
+	uint8_t FirstVisit = !(Map[Idx] & VISITED_B);
+
+	// Rotates the walls from the e-puck reference to the absolute frame
+	for(uint8_t Wall = WALL_FRONT_BIT ; Wall <= WALL_LEFT_BIT ; Wall++){
+		if(Cell_Ref_EPuck & (1 << Wall)){
+			NewCell |= 1 << ((Wall + Heading) & 0x03);
+		}
+	}
+
+	/* No wall and out of the visited coordinates --> out of the exit of the maze.
+	 *  An inner cell without walls entered from the border of the visited cells looks
+	 *  the same, so the exit entered from a cell of the maze is left open straight ahead:
+	 *  the exploration looks one cell beyond, out of the maze it is an exit too, a cell
+	 *  with walls grows the visited coordinates around the inner cell.
+	 *  Entered from an exit --> closed but its entry so that the exploration turns back.
+	 */
+	if(((Cell_Ref_EPuck & WALL_B) == NO_WALL) && NbMoves &&
+			(map_at_exit() || (((PosX < MinX) || (PosX > MaxX) || (PosY < MinY) || (PosY > MaxY)) && (ExitCount < MAX_EXITS)))){
+		if(map_at_exit()){
+			NewCell = Map[Idx];
+		}else{
+			NewCell = VISITED_B | (WALL_B & ~(1 << ((WALL_BACK_BIT + Heading) & 0x03)));
+			if(!is_exit(neighbor_index(Idx, (Heading + 2) & 0x03))){
+				NewCell &= ~(1 << Heading);
+			}
+			ExitX[ExitCount] = PosX;
+			ExitY[ExitCount] = PosY;
+			ExitCount++;
+		}
+	}else{
+		MinX = (PosX < MinX) ? PosX : MinX;
+		MaxX = (PosX > MaxX) ? PosX : MaxX;
+		MinY = (PosY < MinY) ? PosY : MinY;
+		MaxY = (PosY > MaxY) ? PosY : MaxY;
+
+		// Visited cells around an exit --> it was a cell of the maze, explored again
+		for(uint8_t n = 0 ; n < ExitCount ; ){
+			if((ExitX[n] >= MinX) && (ExitX[n] <= MaxX) && (ExitY[n] >= MinY) && (ExitY[n] <= MaxY)){
+				Map[cell_index(ExitX[n], ExitY[n])] = 0;
+				ExitCount--;
+				ExitX[n] = ExitX[ExitCount];
+				ExitY[n] = ExitY[ExitCount];
+				FieldValid = 0;
+				RoutePlanned = 0;
+			}else{
+				n++;
+			}
+		}
+	}
+
+	// Connectivity changed --> every cached distance field is outdated
+	if(NewCell != Map[Idx]){
+		if((NewCell ^ Map[Idx]) & (WALL_B | VISITED_B)){
+			FieldValid = 0;
+			RoutePlanned = 0;
+		}
+		Map[Idx] = NewCell;
+	}
+
+	// Records red, green and blue cells only once as waypoints
+	switch (Cell_Ref_EPuck & COLOR_B) {
+	case RED_B:
+	case GREEN_B:
+	case BLUE_B:
+		for(uint8_t n = 0 ; n < WaypointCount ; n++){
+			if(Waypoint[n] == Idx){
+				return;
+			}
+		}
+		if(WaypointCount < MAX_WAYPOINTS){
+			Waypoint[WaypointCount++] = Idx;
+			RoutePlanned = 0;
+		}else if(FirstVisit){
+			// Not visited by the route, reported by map_get_waypoint_dropped()
+			WaypointDropped++;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void map_advance(int16_t DirectionVal, uint8_t NbCells){
+	switch (DirectionVal) {
+	case LEFT_TURN:
+		Heading = (Heading + 3) & 0x03;
+		break;
+	case RIGHT_TURN:
+		Heading = (Heading + 1) & 0x03;
+		break;
+	case BACKWARD_TURN:
+		Heading = (Heading + 2) & 0x03;
+		break;
+	default:	// MOVE_FORWARD
+		break;
+	}
+
+	for(uint8_t i = 0 ; i < NbCells ; i++){
+		/* Left wall follower leaves a cell the same way a second time
+		 *  --> it loops around a part of the maze, the frontiers are explored
+		 */
+		if(Departure[cell_index(PosX, PosY)] & (1 << Heading)){
+			LoopClosed = 1;
+		}
+		Departure[cell_index(PosX, PosY)] |= (1 << Heading);
+
+		switch (Heading) {
+		case NORTH:
+			PosY++;
+			break;
+		case EAST:
+			PosX++;
+			break;
+		case SOUTH:
+			PosY--;
+			break;
+		default:	// WEST
+			PosX--;
+			break;
+		}
+		NbMoves++;
+	}
+}
+
+void map_get_pose(uint8_t* X, uint8_t* Y, uint8_t* HeadingVal){
+	*X = PosX & (MAP_SIZE-1);
+	*Y = PosY & (MAP_SIZE-1);
+	*HeadingVal = Heading;
+}
+
+uint8_t map_exploration_done(void){
+	// Looks for an open side leading to an unvisited cell
+	for(uint16_t Idx = 0 ; Idx < MAP_CELLS ; Idx++){
+		if(frontier_side(Idx) != UNREACHABLE){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+uint8_t map_frontier_direction(int16_t* DirectionVal){
+	uint8_t Idx = cell_index(PosX, PosY);
+	uint8_t Target = Idx;
+	uint8_t Side;
+
+	/* Out of the exit --> the cell beyond at once if not seen yet, then back into the maze
+	 *  by the cell it was entered from, as from a dead end.
+	 */
+	if(map_at_exit()){
+		Side = frontier_side(Idx);
+		if(Side == UNREACHABLE){
+			// Towards a cell of the maze, otherwise towards the exit it was entered from
+			for(Side = NORTH ; Side <= WEST ; Side++){
+				if(is_passable(Idx, Side) && !is_exit(neighbor_index(Idx, Side))){
+					break;
+				}
+			}
+			if(Side > WEST){
+				Side = NORTH;
+				while(!is_passable(Idx, Side)){
+					Side++;
+				}
+			}
+		}
+		*DirectionVal = RelativeDirection[(Side - Heading) & 0x03];
+		return 1;
+	}
+	if(!LoopClosed){
+		return 0;
+	}
+
+	// Nearest cell with an open side towards an unvisited cell
+	compute_distance_field(Idx, FrontierField);
+	Side = UNREACHABLE;
+	for(uint16_t i = 0 ; i < MAP_CELLS ; i++){
+		if((FrontierField[i] != UNREACHABLE) && (frontier_side(i) != UNREACHABLE)
+				&& ((Side == UNREACHABLE) || (FrontierField[i] < FrontierField[Target]))){
+			Target = i;
+			Side = frontier_side(i);
+		}
+	}
+	if(Side == UNREACHABLE){
+		return 0;
+	}
+
+	// On it --> into the unvisited cell, otherwise down the distance field of the target
+	if(Target != Idx){
+		compute_distance_field(Target, FrontierField);
+		for(Side = NORTH ; Side <= WEST ; Side++){
+			if(is_passable(Idx, Side) && (FrontierField[neighbor_index(Idx, Side)] < FrontierField[Idx])){
+				break;
+			}
+		}
+		if(Side > WEST){
+			return 0;
+		}
+	}
+	*DirectionVal = RelativeDirection[(Side - Heading) & 0x03];
+	return 1;
+}
+
+uint8_t map_at_exit(void){
+	return is_exit(cell_index(PosX, PosY));
+}
+
+uint8_t map_get_waypoint_count(void){
+	return WaypointCount;
+}
+
+uint8_t map_get_waypoint_dropped(void){
+	return WaypointDropped;
+}
+
+void route_plan(void){
+	uint8_t Start = cell_index(PosX, PosY);
+	uint8_t FullMask = (1 << WaypointCount) - 1;
+	uint16_t Cost;
+	uint8_t Mask, Last, Best;
+
+	update_distance_cache();
+
+	// Held-Karp: TourCost[Mask][Last] is the shortest path from Start visiting Mask, ending at Last
+	for(uint16_t m = 0 ; m <= FullMask ; m++){
+		for(uint8_t n = 0 ; n < WaypointCount ; n++){
+			TourCost[m][n] = UINT16_MAX;
+		}
+	}
+	for(uint8_t n = 0 ; n < WaypointCount ; n++){
+		TourCost[1 << n][n] = DistField[n][Start];
+		TourParent[1 << n][n] = n;
+	}
+	for(uint16_t m = 1 ; m <= FullMask ; m++){
+		for(uint8_t n = 0 ; n < WaypointCount ; n++){
+			if(!(m & (1 << n)) || (TourCost[m][n] == UINT16_MAX)){
+				continue;
+			}
+			for(uint8_t k = 0 ; k < WaypointCount ; k++){
+				if(m & (1 << k)){
+					continue;
+				}
+				Cost = TourCost[m][n] + DistField[k][Waypoint[n]];
+				if(Cost < TourCost[m | (1 << k)][k]){
+					TourCost[m | (1 << k)][k] = Cost;
+					TourParent[m | (1 << k)][k] = n;
+				}
+			}
+		}
+	}
+
+	// Visited and unreachable waypoints are dropped from the tour
+	Mask = 0;
+	for(uint8_t n = 0 ; n < WaypointCount ; n++){
+		if(!(WaypointDone & (1 << n)) && (DistField[n][Start] != UNREACHABLE)){
+			Mask |= (1 << n);
+		}
+	}
+
+	// Best last waypoint, then walks the parents back to the first one
+	RouteLength = 0;
+	if(Mask){
+		Best = 0;
+		Cost = UINT16_MAX;
+		for(uint8_t n = 0 ; n < WaypointCount ; n++){
+			if((Mask & (1 << n)) && (TourCost[Mask][n] < Cost)){
+				Cost = TourCost[Mask][n];
+				Best = n;
+			}
+		}
+		while(Mask){
+			RouteOrder[RouteLength++] = Best;
+			Last = TourParent[Mask][Best];
+			Mask &= ~(1 << Best);
+			Best = Last;
+		}
+		// Order has been built from the end
+		for(uint8_t i = 0 ; i < RouteLength/2 ; i++){
+			Last = RouteOrder[i];
+			RouteOrder[i] = RouteOrder[RouteLength-1-i];
+			RouteOrder[RouteLength-1-i] = Last;
+		}
+	}
+	RouteIdx = 0;
+	RoutePlanned = 1;
+}
+
+uint8_t route_next_direction(int16_t* DirectionVal){
+	uint8_t Idx = cell_index(PosX, PosY);
+	uint8_t* Field;
+
+	if(!RoutePlanned){
+		route_plan();
+	}
+
+	// Skips the waypoints already reached
+	while((RouteIdx < RouteLength) && (Waypoint[RouteOrder[RouteIdx]] == Idx)){
+		WaypointDone |= (1 << RouteOrder[RouteIdx]);
+		RouteIdx++;
+	}
+	if(RouteIdx >= RouteLength){
+		return ROUTE_DONE;
+	}
+
+	// Goes down the distance field of the next waypoint
+	Field = DistField[RouteOrder[RouteIdx]];
+	for(uint8_t Dir = NORTH ; Dir <= WEST ; Dir++){
+		if(is_passable(Idx, Dir) && (Field[neighbor_index(Idx, Dir)] < Field[Idx])){
+			*DirectionVal = RelativeDirection[(Dir - Heading) & 0x03];
+			return ROUTE_ONGOING;
+		}
+	}
+
+	// Should not happen with a valid field --> plans again next time
+	RoutePlanned = 0;
+	return ROUTE_DONE;
+}
+
+uint8_t route_straight_cells(void){
+	uint8_t Idx = cell_index(PosX, PosY);
+	uint8_t NbCells = 0;
+	uint8_t* Field;
+
+	if(!RoutePlanned || (RouteIdx >= RouteLength)){
+		return 0;
+	}
+
+	// Forward as long as it goes down the distance field, stops on the waypoint to record it
+	Field = DistField[RouteOrder[RouteIdx]];
+	while(Field[Idx] && is_passable(Idx, Heading) && (Field[neighbor_index(Idx, Heading)] < Field[Idx])){
+		Idx = neighbor_index(Idx, Heading);
+		NbCells++;
+	}
+	return NbCells;
+}
+
+/*** END PUBLIC FUNCTIONS ***/
@@ -0,0 +1,144 @@
+/**
+ * @file	MazeMap.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of functions to map the maze while exploring it
+ * 			 and to route the e-puck through the colored cells (waypoints).
+ * 			Define for map size and route status.
+ */
+
+#ifndef MAZEMAP_H_
+#define MAZEMAP_H_
+
+// Map define
+#define MAP_SIZE		16		// cells per side, a maze up to 8x8 cells fits from any start
+#define MAP_CELLS		(MAP_SIZE * MAP_SIZE)
+#define MAP_ORIGIN		8		// x and y coordinates of the starting cell
+#define VISITED_B		0x80	// cell of the map has been visited
+#define UNREACHABLE		0xFF	// distance to a cell which is not connected
+// Heading define (absolute, heading at start is NORTH)
+#define NORTH			0
+#define EAST			1
+#define SOUTH			2
+#define WEST			3
+// Waypoint define
+#define MAX_WAYPOINTS	6		// exact visiting order is computed in 2^n * n^2
+// Exit define
+#define MAX_EXITS		8		// cells out of the exit at once and the cells beyond, inner cells without walls until visited around
+// Route status define
+#define ROUTE_ONGOING	0
+#define ROUTE_DONE		1
+
+
+/**
+ * @brief	Clears the map, the waypoints and the route.
+ * 			 The e-puck is set to MAP_ORIGIN heading NORTH.
+ */
+void map_reset(void);
+
+/**
+ * @brief	Saves the walls of the cell where the e-puck stands in the map
+ * 			 (absolute frame) and records it as a waypoint if it is red, green or blue.
+ * 			A cell without walls out of the visited cells is the exit, saved as a dead end.
+ *
+ * @param Cell_Ref_EPuck	Bits 0 to 3 are set to 1 if the corresponding
+ * 							 wall is around the e-puck.
+ * 								Bit 0 --> front wall
+ * 								Bit 1 --> right wall
+ * 								Bit 2 --> back wall
+ * 								Bit 3 --> left wall
+ * 							Bits 4 to 6 are set to 1 according to the color of the floor.
+ * 								Bit 4 --> blue
+ * 								Bit 5 --> green
+ * 								Bit 6 --> red
+ */
+void map_record_cell(uint8_t Cell_Ref_EPuck);
+
+/**
+ * @brief	Updates the heading and the position of the e-puck in the map
+ * 			 after a call to go_next_cell() or go_straight().
+ *
+ * @param DirectionVal	Value given to go_next_cell(), MOVE_FORWARD for go_straight().
+ * @param NbCells		Cells completed by the move, fewer than asked (0 --> only the turn)
+ * 						 if a collision stop cut it short.
+ */
+void map_advance(int16_t DirectionVal, uint8_t NbCells);
+
+/**
+ * @brief	Gives the position of the e-puck in the map.
+ *
+ * @param [out] X			Column of the cell, MAP_ORIGIN at start
+ * @param [out] Y			Row of the cell, MAP_ORIGIN at start
+ * @param [out] HeadingVal	NORTH, EAST, SOUTH or WEST
+ */
+void map_get_pose(uint8_t* X, uint8_t* Y, uint8_t* HeadingVal);
+
+/**
+ * @brief	Checks if the exploration of the maze is over.
+ *
+ * @return	1 if every open side of the visited cells leads to a visited cell,
+ * 			 0 otherwise.
+ */
+uint8_t map_exploration_done(void);
+
+/**
+ * @brief	Gives the direction to the nearest open side towards an unvisited cell,
+ * 			 once the left wall follower loops around a part of the maze.
+ * 			 Out of the exit, looks at the cell beyond then goes back into the maze.
+ *
+ * @param [out] DirectionVal	Value in steps to give to go_next_cell().
+ *
+ * @return	1 if the direction is given, 0 if the left wall follower goes on
+ */
+uint8_t map_frontier_direction(int16_t* DirectionVal);
+
+/**
+ * @brief	Checks if the e-puck stands out of the exit of the maze,
+ * 			 the exploration goes back in as from a dead end.
+ *
+ * @return	1 if the cell where the e-puck stands is the exit, 0 otherwise
+ */
+uint8_t map_at_exit(void);
+
+/**
+ * @brief	Returns the number of waypoints recorded in the map.
+ */
+uint8_t map_get_waypoint_count(void);
+
+/**
+ * @brief	Returns the number of colored cells found once MAX_WAYPOINTS waypoints
+ * 			 were recorded. They are not waypoints, the route doesn't visit them.
+ */
+uint8_t map_get_waypoint_dropped(void);
+
+/**
+ * @brief	Computes the shortest order to visit all the waypoints from the cell
+ * 			 where the e-puck stands. Distances are cached until the map changes,
+ * 			 so planning again after a new waypoint only explores the new one.
+ */
+void route_plan(void);
+
+/**
+ * @brief	Gives the direction to go to the next cell of the route.
+ * 			 Plans the route if it has not been done yet.
+ *
+ * @param [out] DirectionVal	Value in steps to give to go_next_cell().
+ *
+ * @return	ROUTE_DONE if all the reachable waypoints have been visited,
+ * 			 ROUTE_ONGOING otherwise.
+ */
+uint8_t route_next_direction(int16_t* DirectionVal);
+
+/**
+ * @brief	Counts the cells of the route straight ahead of the e-puck, up to the
+ * 			 next waypoint included. To call after route_next_direction().
+ *
+ * @return	Number of cells the route goes forward without a turn, 0 if it turns first.
+ */
+uint8_t route_straight_cells(void);
+
+#endif /* MAZEMAP_H_ */
@@ -0,0 +1,195 @@
+/**
+ * @file	MazeParameters.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Parameters of the maze geometry, of the motion and of the camera, with their ranges.
+ * 			The parameters are tuned from the host with single character
+ * 			 telemetry commands, a tuning sweep needs no new firmware.
+ * 			The values are saved in the flash sector of the configuration
+ * 			 (config_flash_storage of the e-puck2 library), so a calibration
+ * 			 survives a reset.
+ */
+
+#include <config_flash_storage.h>
+
+#include <main.h>
+#include <MazeParameters.h>
+#include <SystemControl.h>
+#include <DataAcquisition.h>
+#include <CameraControl.h>
+#include <Telemetry.h>
+
+
+/*** EXTERN VARIABLES ***/
+// Flash sector of the configuration, from the linker script of the e-puck2 library
+extern uint32_t _config_start, _config_end;
+
+
+/*** STATIC VARIABLES ***/
+typedef struct param_def_s{
+	const char *Name;
+	int32_t Default;
+	int32_t Min;
+	int32_t Max;
+	int32_t Step;		// change of the telemetry commands
+} param_def_t;
+
+static const param_def_t ParamDef[PARAM_NB] = {
+		[PARAM_ONE_CELL] 		= {"one_cell", 		ONE_CELL, 			400, 	2000, 	10},
+		[PARAM_LEFT_TURN] 		= {"left_turn", 	-LEFT_TURN, 		250, 	400, 	2},
+		[PARAM_RIGHT_TURN] 		= {"right_turn", 	RIGHT_TURN, 		250, 	400, 	2},
+		[PARAM_BACKWARD_TURN] 	= {"backward_turn", BACKWARD_TURN, 		500, 	800, 	2},
+		[PARAM_ONE_TURN] 		= {"one_turn", 		-ONE_TURN, 			1000, 	1600, 	5},
+		[PARAM_PROX_THRESHOLD] 	= {"prox_threshold",PROXIMITY_THRESHOLD, 20, 	1000, 	10},
+		[PARAM_IMAGE_WIDTH] 	= {"image_width", 	IMAGE_BUFFER_SIZE, 	20, 	IMAGE_BUFFER_SIZE, 20},
+		[PARAM_COLOR_THRESHOLD] = {"color_threshold",COLOR_THRESHOLD, 	40, 	95, 	2},
+		[PARAM_RED_GAIN] 		= {"red_gain", 		RED_GAIN, 			16, 	255, 	2},
+		[PARAM_GREEN_GAIN] 		= {"green_gain", 	GREEN_GAIN, 		16, 	255, 	2},
+		[PARAM_BLUE_GAIN] 		= {"blue_gain", 	BLUE_GAIN, 			16, 	255, 	2},
+		[PARAM_CONTRAST] 		= {"contrast", 		CAMERA_CONTRAST, 	0, 		255, 	4},
+		[PARAM_COLOR_WINDOW] 	= {"color_window", 	COLOR_WINDOW, 		1, 		COLOR_MAX_WINDOW, 1},
+		[PARAM_COLOR_CONFIDENCE]= {"color_confidence",COLOR_MIN_CONFIDENCE, 0, 	50, 	1},
+		[PARAM_CAMERA_PRESET] 	= {"camera_preset", CAMERA_PRESET, 		0, 		CAMERA_NB_PRESETS - 1, 1}};
+
+static parameter_namespace_t MazeNamespace;
+static parameter_t Param[PARAM_NB];
+// Last valid values, read without lock by the threads
+static volatile int32_t ParamValue[PARAM_NB];
+static uint8_t Selected = 0;
+// Changes of the parameters come from several threads
+static MUTEX_DECL(Param_mtx);
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Writes a parameter as a telemetry record.
+ */
+static void send_param(uint8_t Id, int32_t Value, uint8_t Result){
+	tlm_param_t ParamData = {
+			.Id 	= Id,
+			.Result = Result,
+			.Value 	= Value,
+			.Min 	= ParamDef[Id].Min,
+			.Max 	= ParamDef[Id].Max};
+
+	telemetry_write(TLM_PARAM, &ParamData, sizeof(ParamData));
+}
+
+/**
+ * @brief	Adds a change to the selected parameter, it is applied by parameters_update().
+ */
+static void change_selected(int32_t Change){
+	chMtxLock(&Param_mtx);
+	parameter_integer_set(&Param[Selected], ParamValue[Selected] + Change);
+	chMtxUnlock(&Param_mtx);
+}
+
+/**
+ * @brief	Telemetry command, selects the next parameter and reports it.
+ */
+static void select_next(void){
+	Selected = (Selected + 1) % PARAM_NB;
+	send_param(Selected, ParamValue[Selected], PARAM_ACCEPTED);
+}
+
+/**
+ * @brief	Telemetry command, increases the selected parameter of its step.
+ */
+static void increase_selected(void){
+	change_selected(ParamDef[Selected].Step);
+}
+
+/**
+ * @brief	Telemetry command, decreases the selected parameter of its step.
+ */
+static void decrease_selected(void){
+	change_selected(-ParamDef[Selected].Step);
+}
+
+/**
+ * @brief	Telemetry command, reports all the parameters.
+ */
+static void report_all(void){
+	for(uint8_t i = 0 ; i < PARAM_NB ; i++){
+		send_param(i, ParamValue[i], PARAM_ACCEPTED);
+	}
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** PUBLIC FUNCTIONS ***/
+
+void parameters_init(void){
+	parameter_namespace_declare(&MazeNamespace, &parameter_root, "maze");
+
+	for(uint8_t i = 0 ; i < PARAM_NB ; i++){
+		parameter_integer_declare_with_default(&Param[i], &MazeNamespace, ParamDef[i].Name, ParamDef[i].Default);
+		ParamValue[i] = ParamDef[i].Default;
+	}
+
+	// Saved values are marked as changed --> checked by the first parameters_update()
+	config_load(&parameter_root, &_config_start, (uint8_t*)&_config_end - (uint8_t*)&_config_start);
+
+	telemetry_set_command(PARAM_SELECT_KEY, select_next);
+	telemetry_set_command(PARAM_INCREASE_KEY, increase_selected);
+	telemetry_set_command(PARAM_DECREASE_KEY, decrease_selected);
+	telemetry_set_command(PARAM_REPORT_KEY, report_all);
+}
+
+uint8_t parameters_update(uint32_t Params){
+	uint8_t Updated = 0;
+	int32_t Value;
+
+	chMtxLock(&Param_mtx);
+	if(parameter_namespace_contains_changed(&MazeNamespace)){
+		for(uint8_t i = 0 ; i < PARAM_NB ; i++){
+			// Changes of the other groups wait for their thread
+			if(!(Params & PARAM_B(i)) || !parameter_changed(&Param[i])){
+				continue;
+			}
+
+			Value = parameter_integer_get(&Param[i]);
+			if((Value >= ParamDef[i].Min) && (Value <= ParamDef[i].Max)){
+				ParamValue[i] = Value;
+				Updated = 1;
+				send_param(i, Value, PARAM_ACCEPTED);
+			}else{
+				// Set back, reading it clears its change for the next update
+				parameter_integer_set(&Param[i], ParamValue[i]);
+				parameter_integer_get(&Param[i]);
+				send_param(i, Value, PARAM_REJECTED);
+			}
+		}
+	}
+	chMtxUnlock(&Param_mtx);
+
+	return Updated;
+}
+
+int32_t param_get(uint8_t Id){
+	return ParamValue[Id];
+}
+
+void param_set(uint8_t Id, int32_t Value){
+	chMtxLock(&Param_mtx);
+	parameter_integer_set(&Param[Id], Value);
+	chMtxUnlock(&Param_mtx);
+}
+
+uint8_t parameters_save(void){
+	uint8_t Saved;
+
+	chMtxLock(&Param_mtx);
+	config_erase(&_config_start);
+	Saved = config_save(&_config_start, (uint8_t*)&_config_end - (uint8_t*)&_config_start, &parameter_root);
+	chMtxUnlock(&Param_mtx);
+
+	return Saved;
+}
+
+/*** END PUBLIC FUNCTIONS ***/
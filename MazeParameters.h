@@ -0,0 +1,104 @@
+/**
+ * @file	MazeParameters.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of the parameters of the maze geometry, of the motion
+ * 			 and of the camera, declared in the namespace "maze" of parameter_root.
+ * 			The compile-time defines are the default values, a new value is checked
+ * 			 against its range before being used by the threads.
+ * 			The values saved in flash replace the defaults at the start.
+ */
+
+#ifndef MAZEPARAMETERS_H_
+#define MAZEPARAMETERS_H_
+
+#include <stdint.h>
+
+// Parameter define (index in the table)
+#define PARAM_ONE_CELL			0	// in [steps], default ONE_CELL
+#define PARAM_LEFT_TURN			1	// in [steps], default -LEFT_TURN
+#define PARAM_RIGHT_TURN		2	// in [steps], default RIGHT_TURN
+#define PARAM_BACKWARD_TURN		3	// in [steps], default BACKWARD_TURN
+#define PARAM_ONE_TURN			4	// in [steps], default -ONE_TURN
+#define PARAM_PROX_THRESHOLD	5	// default PROXIMITY_THRESHOLD
+#define PARAM_IMAGE_WIDTH		6	// in [pxl], default and maximum IMAGE_BUFFER_SIZE
+#define PARAM_COLOR_THRESHOLD	7	// in [%], default COLOR_THRESHOLD
+#define PARAM_RED_GAIN			8	// PO8030 register value, default RED_GAIN
+#define PARAM_GREEN_GAIN		9	// PO8030 register value, default GREEN_GAIN
+#define PARAM_BLUE_GAIN			10	// PO8030 register value, default BLUE_GAIN
+#define PARAM_CONTRAST			11	// PO8030 register value, default CAMERA_CONTRAST
+#define PARAM_COLOR_WINDOW		12	// in [frames], default COLOR_WINDOW
+#define PARAM_COLOR_CONFIDENCE	13	// in [%], default COLOR_MIN_CONFIDENCE
+#define PARAM_CAMERA_PRESET		14	// CAMERA_PRESET_AUTO, ..., default CAMERA_PRESET
+#define PARAM_NB				15
+// Group define (bits of the parameters), each group is applied by the thread which uses it
+#define PARAM_B(Id)				(1UL << (Id))
+#define PARAM_MOTION_B			(PARAM_B(PARAM_ONE_CELL) | PARAM_B(PARAM_LEFT_TURN) | PARAM_B(PARAM_RIGHT_TURN) \
+								| PARAM_B(PARAM_BACKWARD_TURN) | PARAM_B(PARAM_ONE_TURN))	// go_next_cell(), go_straight()
+#define PARAM_PROX_B			PARAM_B(PARAM_PROX_THRESHOLD)	// GetProximity
+#define PARAM_CAMERA_B			(PARAM_B(PARAM_IMAGE_WIDTH) | PARAM_B(PARAM_RED_GAIN) | PARAM_B(PARAM_GREEN_GAIN) \
+								| PARAM_B(PARAM_BLUE_GAIN) | PARAM_B(PARAM_CONTRAST) | PARAM_B(PARAM_CAMERA_PRESET))	// CaptureImage
+#define PARAM_COLOR_B			(PARAM_B(PARAM_COLOR_THRESHOLD) | PARAM_B(PARAM_COLOR_WINDOW) \
+								| PARAM_B(PARAM_COLOR_CONFIDENCE))	// ProcessImage
+// Command define
+#define PARAM_SELECT_KEY		'p'		// telemetry command to select the next parameter
+#define PARAM_INCREASE_KEY		'+'		// telemetry command to increase the selected parameter
+#define PARAM_DECREASE_KEY		'-'		// telemetry command to decrease the selected parameter
+#define PARAM_REPORT_KEY		'l'		// telemetry command to report all the parameters
+// Result define
+#define PARAM_REJECTED			0
+#define PARAM_ACCEPTED			1
+
+
+/**
+ * @brief	Declares the namespace "maze" in parameter_root with the default values,
+ * 			 loads the values saved in flash and registers the telemetry commands to tune them.
+ * 			parameter_root has to be declared before. The saved values are checked
+ * 			 by the first parameters_update() of their group, like the values set from the host.
+ */
+void parameters_init(void);
+
+/**
+ * @brief	Applies the values of a group set since the last call, by the telemetry commands
+ * 			 or by any other user of parameter_root. A value out of its range is
+ * 			 rejected and set back to the last valid one.
+ * 			Sends a TLM_PARAM record for every new value.
+ * 			Called by the thread using the group, at a point where a change is safe:
+ * 			 the geometry only while the motors are idle, so that a command ends
+ * 			 with the values it started with.
+ *
+ * @param Params	Bits of the parameters to apply, PARAM_MOTION_B, ..., PARAM_COLOR_B
+ *
+ * @return	1 if at least one value changed, 0 otherwise
+ */
+uint8_t parameters_update(uint32_t Params);
+
+/**
+ * @brief	Returns the last valid value of a parameter.
+ *
+ * @param Id	PARAM_ONE_CELL, ..., PARAM_CAMERA_PRESET
+ */
+int32_t param_get(uint8_t Id);
+
+/**
+ * @brief	Sets a new value of a parameter from the firmware, it is checked
+ * 			 and applied by the next parameters_update() of its group.
+ *
+ * @param Id	PARAM_ONE_CELL, ..., PARAM_CAMERA_PRESET
+ */
+void param_set(uint8_t Id, int32_t Value);
+
+/**
+ * @brief	Saves the values of all the parameters in flash, a value set but not
+ * 			 applied yet is checked at the next start.
+ * 			The erase of the flash sector stalls the CPU, only while standing still.
+ *
+ * @return	1 if saved, 0 otherwise
+ */
+uint8_t parameters_save(void);
+
+#endif /* MAZEPARAMETERS_H_ */
@@ -0,0 +1,171 @@
+/**
+ * @file	ModeManager.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Engine running the modes of operation of the selector.
+ * 			Virtual timer debouncing the selector and signalling its changes.
+ * 			Sleep and wakeup of the threads according to the mode.
+ */
+
+#include <selector.h>
+
+#include <main.h>
+#include <ModeManager.h>
+#include <Telemetry.h>
+#include <ThreadPark.h>
+
+// Selector define
+#define NO_SELECTOR		0xFF	// no mode running yet
+
+
+/*** EXTERN VARIABLES ***/
+extern thd_metadata_t ControlMotor_MetaData;
+extern thd_metadata_t GetProximity_MetaData;
+extern thd_metadata_t CaptureImage_MetaData;
+extern thd_metadata_t GetDistance_MetaData;
+
+
+/*** STATIC VARIABLES ***/
+static virtual_timer_t SelectorTimer;
+static thread_t *ModeThd 			= NULL;
+// Written by the timer callback only
+static volatile uint8_t Selector 	= NO_SELECTOR;	// debounced position
+static uint8_t Candidate 			= NO_SELECTOR;	// last position read
+static uint8_t NbEqual 				= 0;			// samples equal to Candidate
+static systime_t ChangeTime;						// first sample of Candidate
+static volatile systime_t RequestTime;				// first sample of Selector
+static volatile systime_t AcceptTime;				// Selector accepted
+// Selector position of the running mode
+static volatile uint8_t Current 	= NO_SELECTOR;
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Wakes the threads of AwakeThreads up and sends the other ones to sleep.
+ * 			All the requests are sent first so that the transitions run in parallel.
+ *
+ * @return	Time until every thread acknowledged in [ms], PARK_TIMEOUT at most per thread
+ */
+static uint32_t set_threads(uint8_t AwakeThreads){
+	systime_t Start = chVTGetSystemTime();
+
+	park_request(&ControlMotor_MetaData, (AwakeThreads & MODE_CONTROL_MOTOR_B) ? AWAKE_MODE : SLEEP_MODE);
+	park_request(&GetProximity_MetaData, (AwakeThreads & MODE_GET_PROXIMITY_B) ? AWAKE_MODE : SLEEP_MODE);
+	park_request(&CaptureImage_MetaData, (AwakeThreads & MODE_CAPTURE_IMAGE_B) ? AWAKE_MODE : SLEEP_MODE);
+	park_request(&GetDistance_MetaData, (AwakeThreads & MODE_GET_DISTANCE_B) ? AWAKE_MODE : SLEEP_MODE);
+
+	park_wait_ack(&ControlMotor_MetaData, MS2ST(PARK_TIMEOUT));
+	park_wait_ack(&GetProximity_MetaData, MS2ST(PARK_TIMEOUT));
+	park_wait_ack(&CaptureImage_MetaData, MS2ST(PARK_TIMEOUT));
+	park_wait_ack(&GetDistance_MetaData, MS2ST(PARK_TIMEOUT));
+
+	return ST2MS(chVTGetSystemTime() - Start);
+}
+
+/**
+ * @brief	Callback of the virtual timer, reads the selector every SELECTOR_SAMPLE_PERIOD.
+ * 			A position is accepted after SELECTOR_DEBOUNCE equal samples,
+ * 			 the thread running the modes is then signalled.
+ */
+static void sample_selector(void *arg){
+	(void)arg;
+
+	uint8_t Position = get_selector();
+	systime_t Now = chVTGetSystemTimeX();
+
+	chSysLockFromISR();
+	if(Position == Candidate){
+		if(NbEqual < SELECTOR_DEBOUNCE){
+			NbEqual++;
+		}
+	}else{
+		Candidate = Position;
+		NbEqual = 1;
+		ChangeTime = Now;
+	}
+
+	if((NbEqual == SELECTOR_DEBOUNCE) && (Candidate != Selector)){
+		Selector = Candidate;
+		RequestTime = ChangeTime;
+		AcceptTime = Now;
+		chEvtSignalI(ModeThd, MODE_CHANGED_EVT);
+	}
+
+	chVTSetI(&SelectorTimer, MS2ST(SELECTOR_SAMPLE_PERIOD), sample_selector, NULL);
+	chSysUnlockFromISR();
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** PUBLIC FUNCTIONS ***/
+
+void mode_manager_run(const selector_mode_t *Modes, uint8_t NbModes, const selector_mode_t *DefaultMode){
+	const selector_mode_t *Mode = NULL;
+	tlm_mode_t ModeData;
+	systime_t Request, Accept, ExitStart;
+
+	// Position at start is accepted without debounce
+	ModeThd = chThdGetSelfX();
+	Candidate = get_selector();
+	NbEqual = SELECTOR_DEBOUNCE;
+	RequestTime = AcceptTime = chVTGetSystemTime();
+	Selector = Candidate;
+	chVTSet(&SelectorTimer, MS2ST(SELECTOR_SAMPLE_PERIOD), sample_selector, NULL);
+
+	/*** INFINITE LOOP ***/
+	while(1){
+		if(Selector != Current){
+			chEvtGetAndClearEvents(MODE_CHANGED_EVT);
+			ExitStart = chVTGetSystemTime();
+
+			if((Mode != NULL) && (Mode->Exit != NULL)){
+				Mode->Exit();
+			}
+
+			// Selector may have changed again meanwhile, the most recent one is taken
+			chSysLock();
+			ModeData.Previous = Current;
+			Current = Selector;
+			Request = RequestTime;
+			Accept = AcceptTime;
+			chSysUnlock();
+
+			Mode = (Current < NbModes) ? &Modes[Current] : DefaultMode;
+			ModeData.ThreadsMs = set_threads(Mode->AwakeThreads);
+			if(Mode->Enter != NULL){
+				Mode->Enter();
+			}
+
+			ModeData.Selector = Current;
+			ModeData.DebounceMs = ST2MS(Accept - Request);
+			ModeData.StepMs = ST2MS(ExitStart - Accept);
+			ModeData.LatencyMs = ST2MS(chVTGetSystemTime() - Request);
+			telemetry_write(TLM_MODE, &ModeData, sizeof(ModeData));
+		}
+
+		Mode->Step();
+	}
+	/*** END INFINITE LOOP ***/
+}
+
+eventmask_t mode_wait_events(eventmask_t Events, systime_t Timeout){
+	if(mode_change_pending()){
+		return MODE_CHANGED_EVT;
+	}
+	return chEvtWaitAnyTimeout(Events | MODE_CHANGED_EVT, Timeout);
+}
+
+uint8_t mode_change_pending(void){
+	return (Selector != Current);
+}
+
+uint8_t mode_get_selector(void){
+	return Current;
+}
+
+/*** END PUBLIC FUNCTIONS ***/
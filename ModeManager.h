@@ -0,0 +1,70 @@
+/**
+ * @file	ModeManager.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of the engine running the modes of operation.
+ * 			A mode is described by the threads it needs and its hooks,
+ * 			 the selector position gives the mode to run.
+ */
+
+#ifndef MODEMANAGER_H_
+#define MODEMANAGER_H_
+
+// Selector define
+#define SELECTOR_SAMPLE_PERIOD	50		// in [ms], period of the timer reading the selector
+#define SELECTOR_DEBOUNCE		3		// equal samples before a new position is accepted
+// Awake threads define
+#define MODE_CONTROL_MOTOR_B	0x01
+#define MODE_GET_PROXIMITY_B	0x02
+#define MODE_CAPTURE_IMAGE_B	0x04
+#define MODE_GET_DISTANCE_B		0x08
+#define MODE_SOLVER_THREADS		0x07	// motors, walls and colors
+#define MODE_ALL_THREADS		0x0F
+#define MODE_NO_THREAD			0x00
+
+/*** Structure ***/
+typedef struct selector_mode_s{
+	uint8_t AwakeThreads;		// MODE_..._B of the threads needed, the others are sent to sleep
+	void (*Enter)(void);		// once when the mode starts, NULL if nothing to do
+	void (*Step)(void);			// in loop as long as the selector doesn't change
+	void (*Exit)(void);			// once when the mode ends, NULL if nothing to do
+} selector_mode_t;
+
+
+/**
+ * @brief	Starts the timer sampling the selector and runs the mode of its position
+ * 			 in the calling thread. Never returns.
+ * 			Sends a TLM_MODE record with the switch latency at each change of mode.
+ *
+ * @param Modes			Modes of the selector positions 0 to NbModes-1
+ * @param NbModes		Number of modes in the table
+ * @param DefaultMode	Mode of the other selector positions
+ */
+void mode_manager_run(const selector_mode_t *Modes, uint8_t NbModes, const selector_mode_t *DefaultMode);
+
+/**
+ * @brief	Waits for events of the calling thread, returns as well as soon as
+ * 			 the selector changes so that the Step hook ends quickly.
+ *
+ * @param Events		Events to wait for besides MODE_CHANGED_EVT (0 for none)
+ * @param Timeout		Maximum time to wait (TIME_INFINITE, MS2ST(...))
+ *
+ * @return				Events received, 0 if timeout
+ */
+eventmask_t mode_wait_events(eventmask_t Events, systime_t Timeout);
+
+/**
+ * @brief	Returns 1 if the selector has changed and the current mode is about to end.
+ */
+uint8_t mode_change_pending(void);
+
+/**
+ * @brief	Returns the selector position of the running mode.
+ */
+uint8_t mode_get_selector(void);
+
+#endif /* MODEMANAGER_H_ */
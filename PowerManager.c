@@ -0,0 +1,89 @@
+/**
+ * @file	PowerManager.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Power state of the peripherals, time spent in each state and time-to-ready.
+ * 			The current drawn is measured on the battery with a multimeter,
+ * 			 the TLM_POWER records give the time spent in each state to weight it.
+ */
+
+#include <main.h>
+#include <PowerManager.h>
+#include <Telemetry.h>
+#include <LatencyProbe.h>
+
+
+/*** STATIC VARIABLES ***/
+typedef struct power_stats_s{
+	uint8_t State;
+	systime_t Since;			// in [ticks], start of the current state
+	uint32_t WakeupStart;		// in [cycles], start of the time-to-ready
+} power_stats_t;
+
+// Every peripheral is started by main() before the threads
+static power_stats_t PowerStats[POWER_NB] = {
+		[POWER_DCMI] 		= {.State = POWER_ON},
+		[POWER_PROXIMITY] 	= {.State = POWER_ON},
+		[POWER_TOF] 		= {.State = POWER_ON}};
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Changes the state of a peripheral and returns the time spent
+ * 			 in the previous one in [ms].
+ */
+static uint32_t change_state(power_stats_t *Stats, uint8_t State){
+	systime_t Now = chVTGetSystemTime();
+	uint32_t StateMs = ST2MS(Now - Stats->Since);
+
+	Stats->State = State;
+	Stats->Since = Now;
+	return StateMs;
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** PUBLIC FUNCTIONS ***/
+
+void power_off(uint8_t Peripheral){
+	power_stats_t *Stats = &PowerStats[Peripheral];
+	tlm_power_t PowerData = {.Peripheral = Peripheral, .State = POWER_OFF};
+
+	PowerData.StateMs = change_state(Stats, POWER_OFF);
+	telemetry_write(TLM_POWER, &PowerData, sizeof(PowerData));
+}
+
+void power_wakeup(uint8_t Peripheral){
+	// Already on, no time-to-ready to measure
+	if(PowerStats[Peripheral].State == POWER_ON){
+		return;
+	}
+
+	PowerStats[Peripheral].WakeupStart = PROBE_NOW();
+	PowerStats[Peripheral].State = POWER_WAKING;
+}
+
+void power_ready(uint8_t Peripheral){
+	power_stats_t *Stats = &PowerStats[Peripheral];
+	tlm_power_t PowerData = {.Peripheral = Peripheral, .State = POWER_ON};
+
+	if(Stats->State != POWER_WAKING){
+		return;
+	}
+
+	PowerData.ReadyUs = (PROBE_NOW() - Stats->WakeupStart) / PROBE_CYCLES_PER_US;
+	// Time-to-ready is counted in the time spent off
+	PowerData.StateMs = change_state(Stats, POWER_ON);
+	telemetry_write(TLM_POWER, &PowerData, sizeof(PowerData));
+}
+
+uint8_t power_get_state(uint8_t Peripheral){
+	return PowerStats[Peripheral].State;
+}
+
+/*** END PUBLIC FUNCTIONS ***/
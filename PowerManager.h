@@ -0,0 +1,66 @@
+/**
+ * @file	PowerManager.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of functions to follow the power state of the peripherals.
+ * 			The threads owning a peripheral stop it before going to sleep,
+ * 			 restart it when woken up and tell when its first data is valid.
+ * 			Only what is really switched is followed: the libraries have no standby
+ * 			 for the PO8030 and no power down for the steppers.
+ */
+
+#ifndef POWERMANAGER_H_
+#define POWERMANAGER_H_
+
+#include <stdint.h>
+
+// Peripheral define
+#define POWER_DCMI			0	// DCMI unit and its DMA (thread CaptureImage)
+#define POWER_PROXIMITY		1	// IR pulses and ADC sampling (thread GetProximity)
+#define POWER_TOF			2	// VL53L0X continuous ranging (thread GetDistance)
+#define POWER_NB			3
+// State define
+#define POWER_OFF			0
+#define POWER_WAKING		1	// restarted, data not valid yet
+#define POWER_ON			2
+
+
+/**
+ * @brief	Saves that a peripheral has been stopped.
+ * 			Sends a TLM_POWER record with the time spent on.
+ *
+ * @param Peripheral	POWER_DCMI, POWER_PROXIMITY or POWER_TOF
+ */
+void power_off(uint8_t Peripheral);
+
+/**
+ * @brief	Saves that a peripheral has been restarted, its time-to-ready starts.
+ * 			Does nothing if the peripheral is already on.
+ *
+ * @param Peripheral	POWER_DCMI, POWER_PROXIMITY or POWER_TOF
+ */
+void power_wakeup(uint8_t Peripheral);
+
+/**
+ * @brief	Saves that the first valid data of a peripheral has been received.
+ * 			Sends a TLM_POWER record with the time spent off and the time-to-ready.
+ * 			Does nothing if the peripheral wasn't waking up.
+ *
+ * @param Peripheral	POWER_DCMI, POWER_PROXIMITY or POWER_TOF
+ */
+void power_ready(uint8_t Peripheral);
+
+/**
+ * @brief	Returns the power state of a peripheral.
+ *
+ * @param Peripheral	POWER_DCMI, POWER_PROXIMITY or POWER_TOF
+ *
+ * @return				POWER_OFF, POWER_WAKING or POWER_ON
+ */
+uint8_t power_get_state(uint8_t Peripheral);
+
+#endif /* POWERMANAGER_H_ */
@@ -11,15 +11,29 @@
  * 			Global semaphore to advertise that the motors are ready for a new command.
  */
 
+#include <math.h>
 #include <motors.h>
+#include <sensors/proximity.h>
+#include <sensors/imu.h>
 
 #include <main.h>
 #include <SystemControl.h>
+#include <DataAcquisition.h>
+#include <Telemetry.h>
+#include <SystemMonitor.h>
+#include <ThreadPark.h>
+#include <LatencyProbe.h>
+#include <HeadingEstimator.h>
+#include <MazeParameters.h>
+
+// Event define
+#define MOTOR_COMMAND_EVT		EVENT_MASK(0)	// new position to reach
+#define MOTOR_UPDATE_EVT		EVENT_MASK(1)	// stop or correction asked by MonitorProximity
 
 
 /*** GLOBAL VARIABLES ***/
 BSEMAPHORE_DECL(MotorReady_sem, FALSE);
-thd_metadata_t ControlMotor_MetaData = {.Sleep = 0, .ThdReference = NULL};
+thd_metadata_t ControlMotor_MetaData = {.Request = AWAKE_MODE, .Sleep = AWAKE_MODE};
 
 
 /*** STATIC VARIABLES ***/
@@ -29,74 +43,636 @@ static int16_t Position2Reach 			= 0;	// in [steps]
 static int16_t NominalSpeed = NOMINAL_SPEED;	// in [step/s]
 static int16_t SpeedLeft 				= 0;	// in [step/s]
 static int16_t SpeedRight 				= 0;	// in [step/s]
+static int16_t StepsDone 				= 0;	// in [steps], of the last command once both positions are reached
+static thread_t *ControlMotorThd 		= NULL;
+// Emergency stop, written by MonitorProximity and cleared by ControlMotor
+static volatile uint8_t CollisionDetected = 0;
+static uint16_t CollisionProx 			= 0;	// highest of IR1 and IR8
+static uint32_t CollisionTime 			= 0;	// in [cycles]
+static int32_t CollisionPos 			= 0;	// in [steps]
+// Correction of the position from a side wall edge, once per move of one cell
+static volatile uint8_t EdgeDone 		= 1;
+static volatile int16_t EdgeCorrection 	= 0;	// in [steps], added to Position2Reach
+static volatile int16_t EdgePosition 	= ONE_CELL / 2;	// in [steps], half of the cell of go_next_cell()
+// Acceleration ramp, restarted at every command and lowered after a slip
+static uint16_t Acceleration 			= ACCEL_MAX;	// in [step/s^2]
+static uint16_t RampBase 				= RAMP_START_SPEED;	// in [step/s]
+static systime_t RampStart 				= 0;
+static volatile int16_t AppliedLeft 	= 0;	// in [step/s], speed given to the motor
+static volatile int16_t AppliedRight 	= 0;	// in [step/s], speed given to the motor
+// Slip, written by MonitorProximity and cleared by ControlMotor
+static volatile uint8_t SlipDetected 	= 0;
+static uint8_t SlipInCommand 			= 0;
+static tlm_slip_t SlipData;
+// Turn closed on the fused heading (HEADING_USE_GYRO), the steps only give its limit
+static uint8_t HeadingTurn 				= 0;
+static float TurnStart 					= 0;	// in [rad], heading when the turn starts
+static float TurnTarget 				= 0;	// in [rad], counterclockwise is positive
 
 /*** INTERNAL FUNCTIONCS ***/
 
+/**
+ * @brief	Writes the motor targets and positions as a telemetry record.
+ */
+static void send_motor_telemetry(void){
+	tlm_motor_t MotorData = {
+			.SpeedLeft 		= SpeedLeft,
+			.SpeedRight 	= SpeedRight,
+			.Position2Reach = Position2Reach,
+			.NominalSpeed 	= NominalSpeed,
+			.PosLeft 		= left_motor_get_pos(),
+			.PosRight 		= right_motor_get_pos()};
+
+	telemetry_write(TLM_MOTOR, &MotorData, sizeof(MotorData));
+}
+
+/**
+ * @brief	Returns the speed limited by the acceleration ramp of the command.
+ */
+static int16_t ramp_speed(int16_t Speed, systime_t Now){
+	int32_t RampSpeed = RampBase + ((int32_t)Acceleration * ST2MS(Now - RampStart)) / 1000;
+
+	if(abs(Speed) <= RampSpeed){
+		return Speed;
+	}
+	return (Speed > 0) ? RampSpeed : -RampSpeed;
+}
+
+/**
+ * @brief	Lowers the acceleration after a slip and restarts the ramp from a lower speed
+ * 			 so that the wheels get their grip back. Called by ControlMotor only.
+ */
+static void slip_recovery(systime_t Now){
+	uint16_t Speed = abs(AppliedLeft);
+
+	SlipDetected = 0;
+	SlipInCommand = 1;
+
+	Acceleration /= 2;
+	if(Acceleration < ACCEL_MIN){
+		Acceleration = ACCEL_MIN;
+	}
+
+	RampBase = (Speed / 2 > RAMP_START_SPEED) ? Speed / 2 : RAMP_START_SPEED;
+	RampStart = Now;
+
+	SlipData.Acceleration = Acceleration;
+	telemetry_write(TLM_SLIP, &SlipData, sizeof(SlipData));
+}
+
+/**
+ * @brief	Returns the steps after which a motor stops. A turn closed on the heading
+ * 			 may need more steps than Position2Reach if the wheels slip.
+ */
+static int16_t step_limit(void){
+	if(HeadingTurn){
+		return Position2Reach + (Position2Reach * HEADING_STEP_MARGIN) / 100;
+	}
+	return Position2Reach;
+}
+
+/**
+ * @brief	Returns 1 if the fused heading has reached the target of the turn.
+ */
+static uint8_t heading_reached(void){
+	float Turned = heading_get() - TurnStart;
+
+	if(TurnTarget < 0){
+		Turned = -Turned;
+	}
+	return Turned >= (fabsf(TurnTarget) - HEADING_TOLERANCE);
+}
+
+/**
+ * @brief	Writes the target and the result of a turn closed on the heading.
+ */
+static void send_heading_telemetry(void){
+	tlm_heading_t HeadingData = {
+			.Target 	= TurnTarget * 1000,
+			.Fused 		= (heading_get() - TurnStart) * 1000,
+			.Odometry 	= ((right_motor_get_pos() - left_motor_get_pos()) * 1000) / (MM_2_STEP * WHEEL_DISTANCE),
+			.Steps 		= abs(left_motor_get_pos()),
+			.Bias 		= heading_get_bias() * 1000000};
+
+	telemetry_write(TLM_HEADING, &HeadingData, sizeof(HeadingData));
+}
+
+/**
+ * @brief	Returns the time until the next check of the positions: CONTROL_PERIOD
+ * 			 during the acceleration ramp and close to the positions,
+ * 			 otherwise just before the first motor reaches its one.
+ * 			A turn closed on the heading is checked from HEADING_STEP_MARGIN
+ * 			 before Position2Reach, the heading may be reached earlier than the steps.
+ */
+static systime_t next_check_delay(void){
+	int32_t Delay = INT32_MAX;	// in [ms]
+	int16_t Target = Position2Reach;
+
+	if((AppliedLeft != SpeedLeft) || (AppliedRight != SpeedRight)){
+		return MS2ST(CONTROL_PERIOD);
+	}
+
+	if(HeadingTurn){
+		Target -= (Position2Reach * HEADING_STEP_MARGIN) / 100;
+	}
+
+	if(!PositionLeft_Reached && SpeedLeft){
+		Delay = ((Target - abs(left_motor_get_pos())) * 1000) / abs(SpeedLeft);
+	}
+	if(!PositionRight_Reached && SpeedRight){
+		int32_t DelayRight = ((Target - abs(right_motor_get_pos())) * 1000) / abs(SpeedRight);
+		if(DelayRight < Delay){
+			Delay = DelayRight;
+		}
+	}
+
+	Delay -= CONTROL_MARGIN;
+	if(Delay < CONTROL_PERIOD){
+		Delay = CONTROL_PERIOD;
+	}
+	return MS2ST(Delay);
+}
+
+/**
+ * @brief	Stops the motors if a move forward is in progress and sends
+ * 			 the stopping distance. Called by ControlMotor only.
+ */
+static void emergency_stop(void){
+	tlm_collision_t CollisionData;
+
+	CollisionDetected = 0;
+
+	// Turns and moves backward don't go towards the front wall
+	if(PositionLeft_Reached || PositionRight_Reached || (SpeedLeft <= 0) || (SpeedRight <= 0)){
+		return;
+	}
+
+	left_motor_set_speed(STOP_SPEED);
+	right_motor_set_speed(STOP_SPEED);
+	AppliedLeft = STOP_SPEED;
+	AppliedRight = STOP_SPEED;
+	PositionLeft_Reached = POSITION_REACHED;
+	PositionRight_Reached = POSITION_REACHED;
+
+	// Steps done between the detection and the stop
+	CollisionData.ProxFront = CollisionProx;
+	CollisionData.Speed = SpeedLeft;
+	CollisionData.LatencyUs = (PROBE_NOW() - CollisionTime) / PROBE_CYCLES_PER_US;
+	CollisionData.StopSteps = left_motor_get_pos() - CollisionPos;
+	CollisionData.Remaining = Position2Reach - left_motor_get_pos();
+	telemetry_write(TLM_COLLISION, &CollisionData, sizeof(CollisionData));
+
+	SpeedLeft = STOP_SPEED;
+	SpeedRight = STOP_SPEED;
+}
+
+/**
+ * @brief	Returns 1 if the front wall found by the camera is now closer than
+ * 			 VISION_STOP_DISTANCE, with the distance travelled since the image.
+ * 			At high speed the camera sees the wall before IR1 and IR8 reach
+ * 			 COLLISION_THRESHOLD, they only have to confirm a wall is there.
+ */
+static uint8_t camera_wall_close(unsigned int ProxFront){
+#if VISION_FRONT_WALL == TRUE
+	uint32_t Age;
+	int32_t Distance = get_front_wall_distance(&Age);	// in [mm]
+
+	if((Distance == VISION_NO_WALL) || (Age > VISION_MAX_AGE) || (ProxFront < VISION_CONFIRM_PROX)){
+		return 0;
+	}
+	Distance -= (int32_t)((AppliedLeft * (int32_t)Age) / (1000 * MM_2_STEP));
+	return Distance < VISION_STOP_DISTANCE;
+#else
+	(void)ProxFront;
+	return 0;
+#endif
+}
+
+/**
+ * @brief	Returns the side walls seen by IR3 and IR6, with a hysteresis
+ * 			 around PARAM_PROX_THRESHOLD so that noise doesn't look like an edge.
+ */
+static uint8_t get_side_walls(const proximity_msg_t *ProxMsg, uint8_t LastWalls){
+	uint8_t Walls = LastWalls;
+
+	unsigned int Threshold = param_get(PARAM_PROX_THRESHOLD);
+
+	if(ProxMsg->delta[IR3] > (Threshold + EDGE_HYSTERESIS)){
+		Walls |= WALL_RIGHT_B;
+	}else if(ProxMsg->delta[IR3] < (Threshold - EDGE_HYSTERESIS)){
+		Walls &= ~WALL_RIGHT_B;
+	}
+	if(ProxMsg->delta[IR6] > (Threshold + EDGE_HYSTERESIS)){
+		Walls |= WALL_LEFT_B;
+	}else if(ProxMsg->delta[IR6] < (Threshold - EDGE_HYSTERESIS)){
+		Walls &= ~WALL_LEFT_B;
+	}
+	return Walls;
+}
+
+/**
+ * @brief	Returns the correction of the heading in [steps] to square up to
+ * 			 a front wall, and the correction of the distance to it.
+ * 			Both are 0 if there is no front wall.
+ */
+static int16_t front_wall_correction(int16_t *DistanceCorrection){
+	int16_t ProxRight = get_prox(IR1);
+	int16_t ProxLeft = get_prox(IR8);
+	int16_t HeadingCorrection;
+	tlm_align_t AlignData;
+
+	*DistanceCorrection = 0;
+	if((ProxRight < param_get(PARAM_PROX_THRESHOLD)) && (ProxLeft < param_get(PARAM_PROX_THRESHOLD))){
+		return 0;
+	}
+
+	/* Turned to the right --> the beam of IR1 is longer than the one of IR8,
+	 *  IR1 < IR8 and the correction is a turn to the left (negative).
+	 */
+	HeadingCorrection = (ProxRight - ProxLeft) / ALIGN_HEADING_DIVIDER;
+	if(abs(HeadingCorrection) > ALIGN_MAX_HEADING){
+		HeadingCorrection = (HeadingCorrection > 0) ? ALIGN_MAX_HEADING : -ALIGN_MAX_HEADING;
+	}
+
+	// Closer than the center of the cell --> moves backward (negative)
+	*DistanceCorrection = (FRONT_WALL_TARGET - ((ProxRight + ProxLeft) / 2)) / ALIGN_DISTANCE_DIVIDER;
+	if(abs(*DistanceCorrection) < ALIGN_MIN_DISTANCE){
+		*DistanceCorrection = 0;
+	}else if(abs(*DistanceCorrection) > ALIGN_MAX_DISTANCE){
+		*DistanceCorrection = (*DistanceCorrection > 0) ? ALIGN_MAX_DISTANCE : -ALIGN_MAX_DISTANCE;
+	}
+
+	AlignData = (tlm_align_t){
+			.Source 	= ALIGN_FRONT_WALL,
+			.Heading 	= HeadingCorrection,
+			.Distance 	= *DistanceCorrection,
+			.ProxLeft 	= ProxLeft,
+			.ProxRight 	= ProxRight};
+	telemetry_write(TLM_ALIGN, &AlignData, sizeof(AlignData));
+
+	return HeadingCorrection;
+}
+
+/**
+ * @brief	Signals a slip to ControlMotor, only once until it has been handled.
+ */
+static void signal_slip(uint8_t Source, int16_t Expected, int16_t Measured){
+	if(SlipDetected){
+		return;
+	}
+
+	SlipData = (tlm_slip_t){
+			.Source 	= Source,
+			.Speed 		= AppliedLeft,
+			.Pos 		= left_motor_get_pos(),
+			.Expected 	= Expected,
+			.Measured 	= Measured};
+	SlipDetected = 1;
+	chEvtSignal(ControlMotorThd, MOTOR_UPDATE_EVT);
+}
+
+#if SLIP_IMU_CHECK == TRUE
+/**
+ * @brief	Compares the rotation given by the gyro with the one of the applied speeds.
+ * 			Called at each proximity sample, the last IMU sample is read without waiting.
+ */
+static void check_gyro_slip(messagebus_topic_t *ImuTopic, uint8_t *NbOutOfTolerance){
+	imu_msg_t ImuMsg;
+	float Commanded;
+
+	if(PositionLeft_Reached || (AppliedLeft != SpeedLeft) || !messagebus_topic_read(ImuTopic, &ImuMsg, sizeof(ImuMsg))){
+		*NbOutOfTolerance = 0;
+		return;
+	}
+
+	// Counterclockwise is positive, as for the gyro
+	Commanded = (AppliedRight - AppliedLeft) / (MM_2_STEP * WHEEL_DISTANCE);
+	if(fabsf(ImuMsg.gyro_rate[Z_AXIS] - Commanded) > SLIP_GYRO_TOLERANCE){
+		if(++(*NbOutOfTolerance) >= SLIP_GYRO_SAMPLES){
+			// in [mrad/s]
+			signal_slip(SLIP_GYRO, Commanded * 1000, ImuMsg.gyro_rate[Z_AXIS] * 1000);
+			*NbOutOfTolerance = 0;
+		}
+	}else{
+		*NbOutOfTolerance = 0;
+	}
+}
+#endif
+
+/**
+ * @brief	Thread which watches the proximity sensors at the rate of the proximity driver.
+ * 			Asks ControlMotor for an emergency stop when IR1 or IR8 sees a wall about to be hit,
+ * 			 or the camera sees it earlier (VISION_FRONT_WALL).
+ * 			Asks ControlMotor to correct Position2Reach when IR3 or IR6 sees the edge of
+ * 			 a side wall, which is at the border between two cells.
+ * 			Signals a slip to ControlMotor when a front wall doesn't get closer as fast as
+ * 			 the steps imply, or when the gyro doesn't follow the command (SLIP_IMU_CHECK).
+ * 			Blocked as long as the proximity driver is stopped (GetProximity asleep).
+ */
+static THD_WORKING_AREA(waMonitorProximity, 256);
+static THD_FUNCTION(MonitorProximity, arg) {
+
+	chRegSetThreadName(__FUNCTION__);
+	(void)arg;
+
+	messagebus_topic_t *ProxTopic = messagebus_find_topic_blocking(&bus, "/proximity");
+	proximity_msg_t ProxMsg;
+	unsigned int ProxFront;
+	uint8_t SideWalls = 0, LastSideWalls = 0;
+	int32_t Pos;
+	tlm_align_t AlignData;
+	// Front wall reference of the slip check, ProxRef == 0 --> no reference
+	unsigned int ProxRef = 0;
+	int32_t PosRef = 0;
+#if SLIP_IMU_CHECK == TRUE
+	messagebus_topic_t *ImuTopic = messagebus_find_topic_blocking(&bus, "/imu");
+	uint8_t NbOutOfTolerance = 0;
+#endif
+
+	/*** INFINITE LOOP ***/
+	while(1){
+		messagebus_topic_wait(ProxTopic, &ProxMsg, sizeof(ProxMsg));
+
+		ProxFront = (ProxMsg.delta[IR1] > ProxMsg.delta[IR8]) ? ProxMsg.delta[IR1] : ProxMsg.delta[IR8];
+
+		// Only while moving forward, ControlMotor checks it again before stopping
+		if(((ProxFront > COLLISION_THRESHOLD) || camera_wall_close(ProxFront)) && !CollisionDetected &&
+				!PositionLeft_Reached && (SpeedLeft > 0) && (SpeedRight > 0)){
+			CollisionProx = ProxFront;
+			CollisionTime = PROBE_NOW();
+			CollisionPos = left_motor_get_pos();
+
+			CollisionDetected = 1;
+			chEvtSignal(ControlMotorThd, MOTOR_UPDATE_EVT);
+		}
+
+		// First edge of a side wall around the border of the cells, during a move of one cell
+		SideWalls = get_side_walls(&ProxMsg, LastSideWalls);
+		if((SideWalls != LastSideWalls) && !EdgeDone && !PositionLeft_Reached){
+			Pos = left_motor_get_pos();
+			if(abs(Pos - EdgePosition) < EDGE_WINDOW){
+				// Edge is half a cell away, the remaining steps are adjusted accordingly
+				EdgeCorrection = Pos - EdgePosition;
+				EdgeDone = 1;
+				chEvtSignal(ControlMotorThd, MOTOR_UPDATE_EVT);
+
+				AlignData = (tlm_align_t){
+						.Source 	= ALIGN_SIDE_EDGE,
+						.Side 		= SideWalls ^ LastSideWalls,
+						.Distance 	= EdgeCorrection,
+						.ProxLeft 	= ProxMsg.delta[IR6],
+						.ProxRight 	= ProxMsg.delta[IR3]};
+				telemetry_write(TLM_ALIGN, &AlignData, sizeof(AlignData));
+			}
+		}
+		LastSideWalls = SideWalls;
+
+		// Front wall in range during a move forward --> has to get closer with the steps
+		if((ProxFront > SLIP_MIN_PROX) && !PositionLeft_Reached && (AppliedLeft > 0) && (AppliedRight > 0)){
+			Pos = left_motor_get_pos();
+			if(!ProxRef){
+				ProxRef = ProxFront;
+				PosRef = Pos;
+			}else if((Pos - PosRef) >= SLIP_WINDOW){
+				if(ProxFront < (ProxRef + SLIP_MIN_PROX_CHANGE)){
+					signal_slip(SLIP_FRONT_WALL, SLIP_MIN_PROX_CHANGE, ProxFront - ProxRef);
+				}
+				ProxRef = ProxFront;
+				PosRef = Pos;
+			}
+		}else{
+			ProxRef = 0;
+		}
+
+#if SLIP_IMU_CHECK == TRUE
+		check_gyro_slip(ImuTopic, &NbOutOfTolerance);
+#endif
+	}
+	/*** END INFINITE LOOP ***/
+}
+
 /**
  * @brief	Thread which controls if the positions has been reached by the motors.
  * 			Signals semaphore MotorReady_sem when positions are reached.
  * 			Sets speed consequently to static variables SpeedLeft and SpeedRight.
+ * 			Waits for a new command when idle, sleeps until the end of a move comes
+ * 			 close and then checks the positions at 1 kHz.
+ * 			Stops a move at once when MonitorProximity asks for it.
+ * 			Stops a turn when the fused heading reaches its target (HEADING_USE_GYRO).
  */
-static THD_WORKING_AREA(waControlMotor, 128);
+// telemetry_write() of emergency_stop(), slip_recovery() and the FPU context of heading_get()
+static THD_WORKING_AREA(waControlMotor, 512);
 static THD_FUNCTION(ControlMotor, arg) {
 
 	chRegSetThreadName(__FUNCTION__);
 	(void)arg;
 
 	volatile systime_t time;
+	systime_t Delay = MS2ST(CONTROL_PERIOD);
+
+	period_monitor_init(PERIOD_CONTROL_MOTOR, 1000);
 
 	/*** INFINITE LOOP ***/
 	while(1){
 		// Enters sleep mode if asked by another thread.
-		if(ControlMotor_MetaData.Sleep){
+		if(park_requested(&ControlMotor_MetaData)){
+			// Stops a move in progress, it goes on after the wakeup
+			left_motor_set_speed(STOP_SPEED);
+			right_motor_set_speed(STOP_SPEED);
+			AppliedLeft = STOP_SPEED;
+			AppliedRight = STOP_SPEED;
+			park_self(&ControlMotor_MetaData);
+			period_monitor_restart(PERIOD_CONTROL_MOTOR);
+		}
+
+		// Both positions reached --> nothing to do until the next command
+		if(PositionLeft_Reached && PositionRight_Reached){
+			// Park request --> back to the beginning to enter sleep mode
+			if(!(chEvtWaitAny(MOTOR_COMMAND_EVT | PARK_EVT) & MOTOR_COMMAND_EVT)){
+				continue;
+			}
+			period_monitor_restart(PERIOD_CONTROL_MOTOR);
+
+			// New command --> new acceleration ramp
+			RampBase = RAMP_START_SPEED;
+			RampStart = chVTGetSystemTime();
+			SlipInCommand = 0;
+			if(HeadingTurn){
+				TurnStart = heading_get();
+			}
+		}else if(Delay > MS2ST(CONTROL_PERIOD)){
+			// Woken up before the end of the move, not a 1 kHz period
+			period_monitor_restart(PERIOD_CONTROL_MOTOR);
+		}
+
+		time = chVTGetSystemTime();
+		period_monitor_tick(PERIOD_CONTROL_MOTOR);
+
+		if(CollisionDetected){
+			emergency_stop();
+		}
+
+		if(SlipDetected){
+			slip_recovery(time);
+		}
+
+		// Edge of a side wall seen --> new position to reach, the delay is computed again
+		if(EdgeCorrection){
 			chSysLock();
-			ControlMotor_MetaData.Sleep = chThdSuspendS(&ControlMotor_MetaData.ThdReference);
+			Position2Reach += EdgeCorrection;
+			EdgeCorrection = 0;
 			chSysUnlock();
 		}
 
-		time = chVTGetSystemTime();
+		// Turn closed on the heading --> both motors stop together
+		if(HeadingTurn && !PositionLeft_Reached && !PositionRight_Reached && heading_reached()){
+			PositionLeft_Reached = POSITION_REACHED;
+			PositionRight_Reached = POSITION_REACHED;
+			SpeedLeft = STOP_SPEED;
+			SpeedRight = STOP_SPEED;
+			AppliedLeft = STOP_SPEED;
+			AppliedRight = STOP_SPEED;
+			left_motor_set_speed(STOP_SPEED);
+			right_motor_set_speed(STOP_SPEED);
+		}
 
 		// Checks if position left has been reached
 		if(!PositionLeft_Reached){
 
 			// Action when position left has been reached
-			if(abs(left_motor_get_pos()) >= Position2Reach){
+			if(abs(left_motor_get_pos()) >= step_limit()){
 				PositionLeft_Reached = POSITION_REACHED;
 				SpeedLeft = STOP_SPEED;
 			}
 
-			left_motor_set_speed(SpeedLeft);
+			AppliedLeft = ramp_speed(SpeedLeft, time);
+			left_motor_set_speed(AppliedLeft);
 		}
 
 		// Checks if position right has been reached
 		if(!PositionRight_Reached){
 
 			// Action when position right has been reached
-			if(abs(right_motor_get_pos()) >= Position2Reach){
+			if(abs(right_motor_get_pos()) >= step_limit()){
 				PositionRight_Reached = POSITION_REACHED;
 				SpeedRight = STOP_SPEED;
 			}
 
-			right_motor_set_speed(SpeedRight);
+			AppliedRight = ramp_speed(SpeedRight, time);
+			right_motor_set_speed(AppliedRight);
 		}
 
 		// Signals semaphore when both positions have been reached
 		if(PositionLeft_Reached && PositionRight_Reached){
+			// Command without slip --> the acceleration goes back to the nominal profile
+			if(!SlipInCommand){
+				Acceleration = (Acceleration + ACCEL_RECOVERY < ACCEL_MAX) ? Acceleration + ACCEL_RECOVERY : ACCEL_MAX;
+			}
+			if(HeadingTurn){
+				send_heading_telemetry();
+			}
+			// Fewer steps than Position2Reach if the command has been stopped
+			StepsDone = abs(left_motor_get_pos());
 			chBSemSignal(&MotorReady_sem);
+			send_motor_telemetry();
+			continue;
 		}
 
-		// 1 kHz cycle because at high speed, position has to be checked faster
-		chThdSleepUntilWindowed(time, time + MS2ST(1));
+		// 1 kHz cycle at the end of a move because at high speed, position has to be checked faster
+		Delay = next_check_delay();
+		park_sleep_until(MOTOR_UPDATE_EVT, time, time + Delay);
 	}
 	/*** END INFINITE LOOP ***/
 }
 
+/**
+ * @brief	Sets the position to reach for each motor at the given speed
+ * 			 for the e-puck to move of a certain distance.
+ */
+static void start_move(int16_t DistanceVal, int16_t Speed){
+	// Waits that the motors have reached their previous position before setting a new command.
+	chBSemWait(&MotorReady_sem);
+
+	// Resets left and right motors position
+	left_motor_set_pos(0);
+	right_motor_set_pos(0);
+
+	// Sets position to reach
+	Position2Reach = abs(DistanceVal);
+	HeadingTurn = 0;
+
+	if(DistanceVal > 0){				// go forward
+		SpeedLeft = Speed;
+		SpeedRight = Speed;
+	}else{								// go backward
+		SpeedLeft = -Speed;
+		SpeedRight = -Speed;
+	}
+
+	/* Resets position reached (condition for Thd ControlMotor),
+	 *  while in locked to start both motors at the same time
+	 */
+	chSysLock();
+	PositionLeft_Reached = POSITION_NOT_REACHED;
+	PositionRight_Reached = POSITION_NOT_REACHED;
+	// No edge correction unless go_next_cell() asks for it after its move of one cell
+	EdgeDone = 1;
+	EdgeCorrection = 0;
+	chSysUnlock();
+	chEvtSignal(ControlMotorThd, MOTOR_COMMAND_EVT);
+
+	send_motor_telemetry();
+}
+
+/**
+ * @brief	Returns the steps of the turn of a direction (LEFT_TURN, ...)
+ * 			 with the turn parameters latched by latch_geometry().
+ */
+static int16_t direction_steps(int16_t DirectionVal){
+	switch (DirectionVal) {
+	case LEFT_TURN:
+		return -param_get(PARAM_LEFT_TURN);
+	case RIGHT_TURN:
+		return param_get(PARAM_RIGHT_TURN);
+	case BACKWARD_TURN:
+		return param_get(PARAM_BACKWARD_TURN);
+	default:	// MOVE_FORWARD
+		return 0;
+	}
+}
+
+/**
+ * @brief	Waits for the motors to be idle, then applies the geometry set from the host.
+ * 			The steps of a command are computed from it after the call, so a command
+ * 			 never ends with values it didn't start with.
+ */
+static void latch_geometry(void){
+	motor_wait_ready();
+	parameters_update(PARAM_MOTION_B);
+}
+
 /*** END INTERNAL FUNCTIONCS ***/
 
 /*** PUBLIC FUNCTIONCS ***/
 
 void control_motor_start(void){
-	chThdCreateStatic(waControlMotor, sizeof(waControlMotor), NORMALPRIO+1, ControlMotor, NULL);
+	ControlMotorThd = chThdCreateStatic(waControlMotor, sizeof(waControlMotor), NORMALPRIO+1, ControlMotor, NULL);
+	park_init(&ControlMotor_MetaData, ControlMotorThd);
+	chThdCreateStatic(waMonitorProximity, sizeof(waMonitorProximity), NORMALPRIO+2, MonitorProximity, NULL);
+}
+
+int16_t motor_wait_ready(void){
+	// Gives the semaphore back so that the next command does not wait
+	chBSemWait(&MotorReady_sem);
+	chBSemSignal(&MotorReady_sem);
+	return StepsDone;
+}
+
+void motor_get_speed(int16_t *Left, int16_t *Right){
+	chSysLock();
+	*Left = AppliedLeft;
+	*Right = AppliedRight;
+	chSysUnlock();
 }
 
 void correction_nominal_speed(int16_t SpeedCorrection){
@@ -119,6 +695,9 @@ void turn(int16_t AngleVal){
 
 	// Sets position to reach
 	Position2Reach = abs(AngleVal);
+	// Turn right --> clockwise --> negative heading
+	HeadingTurn = (HEADING_USE_GYRO == TRUE);
+	TurnTarget = -(AngleVal / DEGREE_2_STEP) * (M_PI / 180);
 
 	if(AngleVal > 0){					// turn right
 		SpeedLeft = NominalSpeed;
@@ -134,45 +713,51 @@ void turn(int16_t AngleVal){
 	chSysLock();
 	PositionLeft_Reached = POSITION_NOT_REACHED;
 	PositionRight_Reached = POSITION_NOT_REACHED;
+	// No edge correction unless go_next_cell() asks for it after its move of one cell
+	EdgeDone = 1;
+	EdgeCorrection = 0;
 	chSysUnlock();
+	chEvtSignal(ControlMotorThd, MOTOR_COMMAND_EVT);
+
+	send_motor_telemetry();
 }
 
 void move(int16_t DistanceVal){
-	// Waits that the motors have reached their previous position before setting a new command.
-	chBSemWait(&MotorReady_sem);
+	start_move(DistanceVal, NominalSpeed);
+}
 
-	// Resets left and right motors position
-	left_motor_set_pos(0);
-	right_motor_set_pos(0);
+void go_next_cell(int16_t DirectionVal){
+	int16_t DistanceCorrection;
+	int16_t HeadingCorrection;
+	int16_t CellSteps;
 
-	// Sets position to reach
-	Position2Reach = abs(DistanceVal);
+	latch_geometry();
+	CellSteps = param_get(PARAM_ONE_CELL);
 
-	if(DistanceVal > 0){				// go forward
-		SpeedLeft = NominalSpeed;
-		SpeedRight = NominalSpeed;
-	}else{								// go backward
-		SpeedLeft = -NominalSpeed;
-		SpeedRight = -NominalSpeed;
-	}
+	// No edge correction during the turn and the distance correction
+	EdgeDone = 1;
 
-	/* Resets position reached (condition for Thd ControlMotor),
-	 *  while in locked to start both motors at the same time
-	 */
-	chSysLock();
-	PositionLeft_Reached = POSITION_NOT_REACHED;
-	PositionRight_Reached = POSITION_NOT_REACHED;
-	chSysUnlock();
-}
+	// Squares up to a front wall during the turn, snaps the distance to it before
+	HeadingCorrection = front_wall_correction(&DistanceCorrection);
+	if(DistanceCorrection){
+		move(DistanceCorrection);
+	}
 
-void go_next_cell(int16_t DirectionVal){
 	// turn if necessary
-	if(!(DirectionVal == MOVE_FORWARD)){
-		turn(DirectionVal);
+	if(!(DirectionVal == MOVE_FORWARD) || HeadingCorrection){
+		turn(direction_steps(DirectionVal) + HeadingCorrection);
 	}
 
-	// move to next cell
-	move(ONE_CELL);
+	// move to next cell, its position is corrected by the first edge of a side wall
+	EdgePosition = CellSteps / 2;
+	move(CellSteps);
+	EdgeDone = 0;
+}
+
+void go_straight(uint8_t NbCells){
+	latch_geometry();
+	// Edges of the side walls are at every border of the cells, none of them is used (start_move())
+	start_move(NbCells * param_get(PARAM_ONE_CELL), CRUISE_SPEED);
 }
 
 /*** END PUBLIC FUNCTIONCS ***/
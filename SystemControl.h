@@ -20,6 +20,7 @@
 #define STOP_SPEED				0		// in [step/s]
 #define SPEED_LIMIT_SUP			800		// in [step/s]
 #define SPEED_LIMIT_INF			200		// in [step/s]
+#define CRUISE_SPEED			800		// in [step/s], straights of several cells
 // Movement define
 #define NSTEP_ONE_REVOLUTION	1000	// steps for a complete revolution
 #define MOVE_FORWARD			0		// continue forward, no turn
@@ -29,18 +30,71 @@
 #define LEFT_TURN				-324	// steps for 90 degree turn left (experimental)
 #define RIGHT_TURN				324 	// steps for 90 degree turn right (experimental)
 #define BACKWARD_TURN			648 	// steps for 180 degree turn (experimental)
-#define ONE_TURN				-1298 	// steps for 180 degree turn (experimental)
+#define ONE_TURN				-1298 	// steps for 360 degree turn (experimental)
 // State define
 #define POSITION_NOT_REACHED	0
 #define POSITION_REACHED       	1
+// Control define
+#define CONTROL_PERIOD			1		// in [ms], checks of the position at the end of a move
+#define CONTROL_MARGIN			2		// in [ms], wakes up before the predicted end of a move
+// Collision define
+#define COLLISION_THRESHOLD		1000	// IR1 or IR8 above --> emergency stop (experimental value)
+#define VISION_STOP_DISTANCE	50		// in [mm] from the center, wall seen by the camera closer --> emergency stop
+#define VISION_CONFIRM_PROX		150		// IR1 or IR8 above --> wall of the camera confirmed (not the floor)
+// Alignment define
+#define FRONT_WALL_TARGET		400		// IR1 and IR8 at the center of a cell (experimental value)
+#define ALIGN_HEADING_DIVIDER	8		// IR1-IR8 difference --> heading correction in [steps] (experimental)
+#define ALIGN_DISTANCE_DIVIDER	10		// IR1+IR8 error --> distance correction in [steps] (experimental)
+#define ALIGN_MAX_HEADING		20		// in [steps], about 5.5 degrees
+#define ALIGN_MIN_DISTANCE		8		// in [steps], about 1 mm
+#define ALIGN_MAX_DISTANCE		60		// in [steps], about 8 mm
+#define ALIGN_FRONT_WALL		0		// correction source: front wall before a turn
+#define ALIGN_SIDE_EDGE			1		// correction source: edge of a side wall while moving
+#define EDGE_WINDOW				100		// in [steps], edges further from half a cell are ignored
+#define EDGE_HYSTERESIS			20		// around PROXIMITY_THRESHOLD for IR3 and IR6
+// Acceleration define
+#define RAMP_START_SPEED		100		// in [step/s], first speed of a command
+#define ACCEL_MAX				8000	// in [step/s^2], nominal profile
+#define ACCEL_MIN				1000	// in [step/s^2], lowest after repeated slips
+#define ACCEL_RECOVERY			500		// in [step/s^2], increase after a command without slip
+// Slip define
+#define SLIP_IMU_CHECK			FALSE	// TRUE --> gyro also checked, needs the IMU started
+#define SLIP_FRONT_WALL			0		// slip source: front wall doesn't get closer
+#define SLIP_GYRO				1		// slip source: rotation differs from the command
+#define SLIP_MIN_PROX			150		// IR1 or IR8 above --> front wall close enough to check
+#define SLIP_WINDOW				40		// in [steps], about 5 mm between two front wall checks
+#define SLIP_MIN_PROX_CHANGE	5		// IR1/IR8 increase expected over SLIP_WINDOW (experimental)
+#define WHEEL_DISTANCE			53		// in [mm], between the wheels
+#define SLIP_GYRO_TOLERANCE		0.5f	// in [rad/s], between command and gyro
+#define SLIP_GYRO_SAMPLES		3		// consecutive samples out of tolerance
 
 
 /**
  * @brief	Starts thread to control if the position has been reached with
- * 			NORMALPRIO+1
+ * 			NORMALPRIO+1 to ControlMotor
+ * 			Starts thread to stop a move forward before a collision with
+ * 			NORMALPRIO+2 to MonitorProximity
  */
 void control_motor_start(void);
 
+/**
+ * @brief	Waits until the motors have reached their positions.
+ * 			Unlike turn() and move(), does not take the semaphore MotorReady_sem,
+ * 			 the next command can start without waiting.
+ *
+ * @return	Steps done by the last command, fewer than asked if the collision
+ * 			 stop cut a move short
+ */
+int16_t motor_wait_ready(void);
+
+/**
+ * @brief	Gives the speeds applied to the motors, limited by the acceleration ramp.
+ *
+ * @param Left		Speed of the left motor in [step/s]
+ * @param Right		Speed of the right motor in [step/s]
+ */
+void motor_get_speed(int16_t *Left, int16_t *Right);
+
 /**
  * @brief	Increases or decreases the nominal speed.
  *
@@ -74,6 +128,8 @@ void move(int16_t DistanceVal);
  * @brief	Sets the position to reach for each motor at nominal speed,
  * 			 for the e-puck to turn and then move forward or only move forward
  * 			 for a fixed distance of one cell of the maze.
+ * 			Waits for the previous command, then applies the geometry set from the host
+ * 			 (PARAM_MOTION_B) for the whole cell.
  *
  * @param DirectionVal	Value in steps corresponding to the number needed to do the turn,
  * 						 Positive value to turn right then move forward.
@@ -82,4 +138,14 @@ void move(int16_t DistanceVal);
  */
 void go_next_cell(int16_t DirectionVal);
 
+/**
+ * @brief	Sets the position to reach for each motor at CRUISE_SPEED,
+ * 			 for the e-puck to move forward of several cells at once.
+ * 			No correction from the side wall edges, the collision stop still applies.
+ * 			Waits for the previous command, then applies the geometry set from the host.
+ *
+ * @param NbCells		Number of cells, not more than the free corridor ahead.
+ */
+void go_straight(uint8_t NbCells);
+
 #endif /* SYSTEMCONTROL_H_ */
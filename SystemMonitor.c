@@ -0,0 +1,353 @@
+/**
+ * @file	SystemMonitor.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Thread to report the load and the stack usage of every thread.
+ * 			Based on the kernel debug options of chconf.h:
+ * 				CH_DBG_STATISTICS 			--> cycles and context switches per thread
+ * 				CH_DBG_THREADS_PROFILING 	--> ticks per thread (if no statistics)
+ * 				CH_DBG_FILL_THREADS 		--> unused stack still filled with a pattern
+ */
+
+#include <string.h>
+#if !defined(HOST_BUILD)
+#include <selector.h>
+#endif
+
+#include <main.h>
+#include <SystemMonitor.h>
+#include <Telemetry.h>
+#include <LatencyProbe.h>
+
+#if defined(HOST_BUILD)
+// The scheduler model of the host tools ticks and reports the periods in one thread
+#define chSysLock()
+#define chSysUnlock()
+#endif
+
+// Event define
+#define LOAD_CHANGED_EVT		EVENT_MASK(0)	// new LoadLevel
+
+
+/*** STATIC VARIABLES ***/
+// Activations of each periodic thread since the last report
+typedef struct period_stats_s{
+	uint32_t NominalUs;
+	uint32_t Last;				// in [cycles], 0 --> next activation starts the measurement
+	uint32_t Count;
+	uint32_t Misses;
+	uint32_t MinUs;
+	uint32_t MaxUs;
+	uint64_t SumUs;
+	uint64_t SumSqUs;			// sum of the squared deviations to the nominal period
+} period_stats_t;
+
+static period_stats_t PeriodStats[PERIOD_NB];
+
+#if !defined(HOST_BUILD)
+// Values of each thread at the previous report
+typedef struct thd_usage_s{
+	thread_t *Thd;				// NULL if the entry is free
+	uint64_t LastTime;			// in [cycles] (statistics) or [ticks] (profiling)
+	uint64_t LastSwitches;
+} thd_usage_t;
+
+static thd_usage_t ThdUsage[MONITOR_MAX_THREADS];
+
+// Share of CPU used by thread GenerateLoad, in [%]
+static uint8_t LoadLevel = 0;
+static thread_t *GenerateLoadThd = NULL;
+#endif
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Integer square root (bit by bit).
+ */
+static uint32_t isqrt(uint64_t Value){
+	uint64_t Root = 0;
+	uint64_t Bit = 1ULL << 62;
+
+	while(Bit > Value){
+		Bit >>= 2;
+	}
+	while(Bit){
+		if(Value >= Root + Bit){
+			Value -= Root + Bit;
+			Root = (Root >> 1) + Bit;
+		}else{
+			Root >>= 1;
+		}
+		Bit >>= 2;
+	}
+	return (uint32_t)Root;
+}
+
+/**
+ * @brief	Converts a duration in [us] to the unit of TLM_PERIOD, saturated to 16 bits.
+ */
+static uint16_t period_units(uint32_t Us){
+	uint32_t Units = (Us + TLM_PERIOD_UNIT / 2) / TLM_PERIOD_UNIT;
+
+	return (Units < UINT16_MAX) ? Units : UINT16_MAX;
+}
+
+#if !defined(HOST_BUILD)
+/**
+ * @brief	Returns the values of the previous report for a thread,
+ * 			 or a free entry (Thd == NULL) if it is seen for the first time.
+ */
+static thd_usage_t* get_usage(thread_t *Thd){
+	for(uint8_t i = 0 ; i < MONITOR_MAX_THREADS ; i++){
+		if(ThdUsage[i].Thd == Thd){
+			return &ThdUsage[i];
+		}
+	}
+	for(uint8_t i = 0 ; i < MONITOR_MAX_THREADS ; i++){
+		if(ThdUsage[i].Thd == NULL){
+			return &ThdUsage[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief	Counts the bytes of the stack which have never been written.
+ * 			The stack grows down to p_stklimit, which is where the count starts.
+ */
+static uint16_t get_unused_stack(thread_t *Thd){
+	uint8_t *Ptr = (uint8_t*)Thd->p_stklimit;
+	uint16_t Unused = 0;
+
+	while((*Ptr++ == CH_DBG_STACK_FILL_VALUE) && (Unused < UINT16_MAX)){
+		Unused++;
+	}
+	return Unused;
+}
+
+/**
+ * @brief	Increases the load generated by thread GenerateLoad, back to 0 after the maximum.
+ */
+static void increase_load(void){
+	LoadLevel += LOAD_STEP;
+	if(LoadLevel >= 100){
+		LoadLevel = 0;
+	}
+	chEvtSignal(GenerateLoadThd, LOAD_CHANGED_EVT);
+}
+
+/**
+ * @brief	Thread which keeps the CPU busy for LoadLevel percent of each LOAD_PERIOD,
+ * 			 to check that the periodic threads keep their deadlines under overload.
+ * 			Waits for a new LoadLevel when there is no load to generate.
+ */
+static THD_WORKING_AREA(waGenerateLoad, 128);
+static THD_FUNCTION(GenerateLoad, arg){
+	chRegSetThreadName(__FUNCTION__);
+	(void)arg;
+
+	systime_t Time;
+
+	/*** INFINITE LOOP ***/
+	while(1){
+		if(!LoadLevel){
+			chEvtWaitAny(LOAD_CHANGED_EVT);
+		}
+
+		Time = chVTGetSystemTime();
+
+		/* Busy loop, only preempted by higher priorities and by round robin.
+		 *  Yields to the threads of same priority in tickless mode, which has no round robin.
+		 */
+		while((chVTGetSystemTime() - Time) < US2ST((LOAD_PERIOD * 1000 * LoadLevel) / 100)){
+#if defined(EPUCK_TICKLESS)
+			chThdYield();
+#endif
+		}
+
+		chThdSleepUntilWindowed(Time, Time + MS2ST(LOAD_PERIOD));
+	}
+	/*** END INFINITE LOOP ***/
+}
+
+/**
+ * @brief	Thread which reports every MONITOR_PERIOD the CPU share (in permille),
+ * 			 the number of context switches and the unused stack of every thread.
+ * 			Reports then the idle share and the wakeups of the whole system
+ * 			 with the selector position, to compare the modes of operation.
+ */
+static THD_WORKING_AREA(waMonitorThreads, 256);
+static THD_FUNCTION(MonitorThreads, arg){
+	chRegSetThreadName(__FUNCTION__);
+	(void)arg;
+
+	tlm_thread_t ThreadData;
+	tlm_load_t LoadData;
+	thd_usage_t *Usage;
+	thread_t *Thd;
+	uint64_t Time, Switches, Period;
+#if CH_DBG_STATISTICS == TRUE
+	rtcnt_t Now, Last = chSysGetRealtimeCounterX();
+	uint32_t LastCtxSwitches = ch.kernel_stats.n_ctxswc;
+	uint32_t LastIrqs = ch.kernel_stats.n_irq;
+#else
+	systime_t Now, Last = chVTGetSystemTime();
+#endif
+
+	/*** INFINITE LOOP ***/
+	while(1){
+		chThdSleepMilliseconds(MONITOR_PERIOD);
+
+		// Duration of the report period, same unit as the time of the threads
+#if CH_DBG_STATISTICS == TRUE
+		Now = chSysGetRealtimeCounterX();
+#else
+		Now = chVTGetSystemTime();
+#endif
+		Period = Now - Last;
+		Last = Now;
+
+		LoadData = (tlm_load_t){.Selector = get_selector()};
+#if CH_DBG_STATISTICS == TRUE
+		LoadData.CtxSwitches = ((ch.kernel_stats.n_ctxswc - LastCtxSwitches) * 1000) / MONITOR_PERIOD;
+		LoadData.Irqs = ((ch.kernel_stats.n_irq - LastIrqs) * 1000) / MONITOR_PERIOD;
+		LastCtxSwitches = ch.kernel_stats.n_ctxswc;
+		LastIrqs = ch.kernel_stats.n_irq;
+#endif
+
+		// Walks through the registry, every thread is reported
+		Thd = chRegFirstThread();
+		while(Thd != NULL){
+#if CH_DBG_STATISTICS == TRUE
+			Time = Thd->p_stats.cumulative;
+			Switches = Thd->p_stats.n;
+#elif CH_DBG_THREADS_PROFILING == TRUE
+			Time = Thd->p_time;
+			Switches = 0;
+#endif
+
+			Usage = get_usage(Thd);
+			if(Usage == NULL){
+				// Too many threads --> not reported
+			}else if(Usage->Thd == NULL){
+				// First time seen --> reported from the next period on
+				Usage->Thd = Thd;
+				Usage->LastTime = Time;
+				Usage->LastSwitches = Switches;
+			}else{
+				memset(ThreadData.Name, 0, sizeof(ThreadData.Name));
+				if(Thd->p_name != NULL){
+					strncpy(ThreadData.Name, Thd->p_name, sizeof(ThreadData.Name));
+				}
+				ThreadData.CpuShare = ((Time - Usage->LastTime) * 1000) / Period;
+				ThreadData.Switches = Switches - Usage->LastSwitches;
+				ThreadData.UnusedStack = get_unused_stack(Thd);
+				telemetry_write(TLM_THREAD, &ThreadData, sizeof(ThreadData));
+
+				// Every time the idle thread is left, a thread has been woken up
+				if(Thd == chSysGetIdleThreadX()){
+					LoadData.IdleShare = ThreadData.CpuShare;
+					LoadData.Wakeups = (ThreadData.Switches * 1000) / MONITOR_PERIOD;
+				}
+
+				Usage->LastTime = Time;
+				Usage->LastSwitches = Switches;
+			}
+
+			Thd = chRegNextThread(Thd);
+		}
+
+		telemetry_write(TLM_LOAD, &LoadData, sizeof(LoadData));
+	}
+	/*** END INFINITE LOOP ***/
+}
+
+#endif
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** PUBLIC FUNCTIONS ***/
+
+#if !defined(HOST_BUILD)
+void system_monitor_start(void){
+	telemetry_set_command(PERIOD_REPORT_KEY, period_monitor_report);
+	telemetry_set_command(LOAD_KEY, increase_load);
+
+	chThdCreateStatic(waMonitorThreads, sizeof(waMonitorThreads), NORMALPRIO, MonitorThreads, NULL);
+	GenerateLoadThd = chThdCreateStatic(waGenerateLoad, sizeof(waGenerateLoad), NORMALPRIO, GenerateLoad, NULL);
+}
+#endif
+
+void period_monitor_init(uint8_t Id, uint32_t NominalUs){
+	chSysLock();
+	PeriodStats[Id] = (period_stats_t){.NominalUs = NominalUs, .MinUs = UINT32_MAX};
+	chSysUnlock();
+}
+
+void period_monitor_restart(uint8_t Id){
+	PeriodStats[Id].Last = 0;
+}
+
+void period_monitor_tick(uint8_t Id){
+	period_stats_t *Stats = &PeriodStats[Id];
+	uint32_t Now = PROBE_NOW();
+	uint32_t PeriodUs;
+	int32_t Deviation;
+
+	chSysLock();
+	if(Stats->Last){
+		PeriodUs = (Now - Stats->Last) / PROBE_CYCLES_PER_US;
+		Deviation = (int32_t)PeriodUs - (int32_t)Stats->NominalUs;
+
+		Stats->Count++;
+		Stats->SumUs += PeriodUs;
+		Stats->SumSqUs += (int64_t)Deviation * Deviation;
+		if(PeriodUs < Stats->MinUs){
+			Stats->MinUs = PeriodUs;
+		}
+		if(PeriodUs > Stats->MaxUs){
+			Stats->MaxUs = PeriodUs;
+		}
+		if(Deviation > (int32_t)((Stats->NominalUs * PERIOD_MISS_MARGIN) / 100)){
+			Stats->Misses++;
+		}
+	}
+	// 0 is kept for "no previous activation"
+	Stats->Last = Now ? Now : 1;
+	chSysUnlock();
+}
+
+void period_monitor_report(void){
+	period_stats_t Stats;
+	tlm_period_t PeriodData;
+	int32_t MeanDeviation;
+	int64_t Variance;
+
+	for(uint8_t Id = 0 ; Id < PERIOD_NB ; Id++){
+		// Copies and clears the statistics, keeps the running measurement
+		chSysLock();
+		Stats = PeriodStats[Id];
+		PeriodStats[Id] = (period_stats_t){.NominalUs = Stats.NominalUs, .Last = Stats.Last, .MinUs = UINT32_MAX};
+		chSysUnlock();
+
+		PeriodData = (tlm_period_t){.Id = Id, .Count = Stats.Count};
+		if(Stats.Count){
+			MeanDeviation = (int32_t)(Stats.SumUs / Stats.Count) - (int32_t)Stats.NominalUs;
+			PeriodData.Misses = (Stats.Misses < UINT16_MAX) ? Stats.Misses : UINT16_MAX;
+			PeriodData.Min = period_units(Stats.MinUs);
+			PeriodData.Max = period_units(Stats.MaxUs);
+			PeriodData.Mean = period_units(Stats.NominalUs + MeanDeviation);
+			// Jitter: standard deviation of the period around its mean
+			Variance = (int64_t)(Stats.SumSqUs / Stats.Count) - ((int64_t)MeanDeviation * MeanDeviation);
+			PeriodData.Jitter = period_units(isqrt((Variance > 0) ? Variance : 0));
+		}
+		telemetry_write(TLM_PERIOD, &PeriodData, sizeof(PeriodData));
+	}
+}
+
+/*** END PUBLIC FUNCTIONS ***/
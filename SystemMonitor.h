@@ -0,0 +1,69 @@
+/**
+ * @file	SystemMonitor.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of functions to monitor the load and the stack
+ * 			 usage of every thread, and the period of the periodic threads.
+ */
+
+#ifndef SYSTEMMONITOR_H_
+#define SYSTEMMONITOR_H_
+
+// Monitor define
+#define MONITOR_PERIOD			1000	// in [ms]
+#define MONITOR_MAX_THREADS		16		// threads followed between two reports
+// Periodic thread define
+#define PERIOD_CONTROL_MOTOR	0
+#define PERIOD_GET_PROXIMITY	1
+#define PERIOD_NB				2
+#define PERIOD_MISS_MARGIN		50		// in [%] of the period, later activations are missed deadlines
+#define PERIOD_REPORT_KEY		'j'		// telemetry command to report the periods
+// Load generator define
+#define LOAD_KEY				'o'		// telemetry command to increase the load (0, 25, 50, 75 %)
+#define LOAD_STEP				25		// in [%] of CPU
+#define LOAD_PERIOD				10		// in [ms]
+
+
+/**
+ * @brief	Starts thread to report CPU share, context switches and unused stack
+ * 			 of every thread as TLM_THREAD records, and the idle share and wakeups
+ * 			 per selector position as TLM_LOAD records with NORMALPRIO to MonitorThreads.
+ * 			Starts thread to load the CPU on demand with NORMALPRIO to GenerateLoad.
+ */
+void system_monitor_start(void);
+
+/**
+ * @brief	Sets the expected period of a periodic thread and clears its statistics.
+ *
+ * @param Id			Periodic thread (PERIOD_CONTROL_MOTOR, ...)
+ * @param NominalUs		Expected period in [us]
+ */
+void period_monitor_init(uint8_t Id, uint32_t NominalUs);
+
+/**
+ * @brief	Forgets the last activation, to be called when a thread wakes up
+ * 			 so that the time spent asleep is not counted as a period.
+ *
+ * @param Id			Periodic thread (PERIOD_CONTROL_MOTOR, ...)
+ */
+void period_monitor_restart(uint8_t Id);
+
+/**
+ * @brief	Saves an activation of a periodic thread, to be called once per cycle.
+ * 			Updates period min/max/mean, jitter and missed deadlines.
+ *
+ * @param Id			Periodic thread (PERIOD_CONTROL_MOTOR, ...)
+ */
+void period_monitor_tick(uint8_t Id);
+
+/**
+ * @brief	Sends the statistics of every periodic thread as TLM_PERIOD records
+ * 			 and clears them, each report holds the activations since the previous one.
+ */
+void period_monitor_report(void);
+
+#endif /* SYSTEMMONITOR_H_ */
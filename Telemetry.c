@@ -0,0 +1,200 @@
+/**
+ * @file	Telemetry.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Lock-free buffer of binary records written by every thread.
+ * 			Thread to send the records over USB serial (SDU1),
+ * 			 then the blocks of data of the stream handler (images).
+ */
+
+#include <string.h>
+#include <usbcfg.h>
+
+#include <main.h>
+#include <Telemetry.h>
+
+// Sending define
+#define TLM_SEND_PERIOD		20		// in [ms]
+#define TLM_SEND_RECORDS	8		// records sent in one write
+#define TLM_STATUS_PERIOD	1000	// in [ms]
+#define TLM_IDLE_PERIOD		500		// in [ms], when no host is connected
+#define TLM_BLOCK_TIMEOUT	100		// in [ms], to send a record and its block
+
+
+/*** STATIC VARIABLES ***/
+/* Slot of the buffer. Turn is set to (index + 1) once the record of the writer
+ *  holding this index is complete, so the reader never sends a half written record.
+ */
+typedef struct tlm_slot_s{
+	volatile uint32_t Turn;
+	tlm_record_t Record;
+} tlm_slot_t;
+
+static tlm_slot_t Buffer[TLM_BUFFER_SIZE];
+static volatile uint32_t WriteIdx 	= 0;	// next index to reserve (all writers)
+static volatile uint32_t ReadIdx 	= 0;	// next index to send (thread SendTelemetry only)
+static volatile uint32_t Dropped 	= 0;
+static uint32_t BytesSent 			= 0;
+static uint16_t BlockSeq 			= 0;	// blocks aren't in the buffer, numbered apart
+
+// Commands received from the host
+static char CommandKey[TLM_MAX_COMMANDS];
+static tlm_command_t CommandHandler[TLM_MAX_COMMANDS];
+static uint8_t NbCommands 			= 0;
+static tlm_stream_t StreamHandler 	= NULL;
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Calls the handlers of the commands received since the last call.
+ */
+static void receive_commands(void){
+	uint8_t RxBuff[TLM_MAX_COMMANDS];
+	size_t NbKeys = chnReadTimeout(&SDU1, RxBuff, sizeof(RxBuff), TIME_IMMEDIATE);
+
+	for(size_t k = 0 ; k < NbKeys ; k++){
+		for(uint8_t i = 0 ; i < NbCommands ; i++){
+			if(CommandKey[i] == (char)RxBuff[k]){
+				CommandHandler[i]();
+			}
+		}
+	}
+}
+
+/**
+ * @brief	Thread which sends the completed records over USB serial
+ * 			 and executes the commands of the host.
+ * 			Records are discarded when no host is connected.
+ */
+static THD_WORKING_AREA(waSendTelemetry, 512);
+static THD_FUNCTION(SendTelemetry, arg){
+	chRegSetThreadName(__FUNCTION__);
+	(void)arg;
+
+	tlm_record_t TxBuff[TLM_SEND_RECORDS];
+	tlm_slot_t *Slot;
+	tlm_status_t Status;
+	uint8_t NbRecords;
+	systime_t Time;
+	systime_t LastStatus = chVTGetSystemTime();
+
+	/*** INFINITE LOOP ***/
+	while(1){
+		Time = chVTGetSystemTime();
+
+		// Sends the status of the telemetry once per second
+		if((Time - LastStatus) >= MS2ST(TLM_STATUS_PERIOD)){
+			LastStatus = Time;
+			Status.Dropped = Dropped;
+			Status.BytesSent = BytesSent;
+			telemetry_write(TLM_STATUS, &Status, sizeof(Status));
+		}
+
+		if(SDU1.config->usbp->state == USB_ACTIVE){
+			receive_commands();
+		}
+
+		// Sends records by packets until the buffer is empty
+		do{
+			NbRecords = 0;
+			Slot = &Buffer[ReadIdx & (TLM_BUFFER_SIZE-1)];
+			while((NbRecords < TLM_SEND_RECORDS) &&
+					(__atomic_load_n(&Slot->Turn, __ATOMIC_ACQUIRE) == (ReadIdx + 1))){
+				TxBuff[NbRecords++] = Slot->Record;
+				// Frees the slot for the writers
+				__atomic_store_n(&ReadIdx, ReadIdx + 1, __ATOMIC_RELEASE);
+				Slot = &Buffer[ReadIdx & (TLM_BUFFER_SIZE-1)];
+			}
+
+			if(NbRecords && (SDU1.config->usbp->state == USB_ACTIVE)){
+				BytesSent += chnWriteTimeout(&SDU1, (uint8_t*)TxBuff,
+						NbRecords * sizeof(tlm_record_t), MS2ST(TLM_SEND_PERIOD));
+			}
+		}while(NbRecords == TLM_SEND_RECORDS);
+
+		// Blocks once the records are sent, so that a long block doesn't fill the buffer
+		if((StreamHandler != NULL) && (SDU1.config->usbp->state == USB_ACTIVE)){
+			StreamHandler();
+		}
+
+		// Wakes up less often when records are only discarded
+		if(SDU1.config->usbp->state == USB_ACTIVE){
+			chThdSleepUntilWindowed(Time, Time + MS2ST(TLM_SEND_PERIOD));
+		}else{
+			chThdSleepUntilWindowed(Time, Time + MS2ST(TLM_IDLE_PERIOD));
+		}
+	}
+	/*** END INFINITE LOOP ***/
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** PUBLIC FUNCTIONS ***/
+
+void telemetry_start(void){
+	chThdCreateStatic(waSendTelemetry, sizeof(waSendTelemetry), NORMALPRIO, SendTelemetry, NULL);
+}
+
+void telemetry_write(uint8_t Type, const void* Payload, uint8_t Size){
+	uint32_t Idx = __atomic_load_n(&WriteIdx, __ATOMIC_RELAXED);
+	tlm_slot_t *Slot;
+
+	// Reserves an index (LDREX/STREX), gives up if the reader is a whole buffer behind
+	do{
+		if((Idx - __atomic_load_n(&ReadIdx, __ATOMIC_ACQUIRE)) >= TLM_BUFFER_SIZE){
+			__atomic_fetch_add(&Dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+	}while(!__atomic_compare_exchange_n(&WriteIdx, &Idx, Idx + 1, true,
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+	// Fills the reserved slot then publishes it
+	Slot = &Buffer[Idx & (TLM_BUFFER_SIZE-1)];
+	Slot->Record.Sync = TLM_SYNC;
+	Slot->Record.Type = Type;
+	Slot->Record.Seq = (uint16_t)Idx;
+	Slot->Record.Time = chVTGetSystemTimeX();
+	memset(Slot->Record.Payload, 0, TLM_PAYLOAD_SIZE);
+	memcpy(Slot->Record.Payload, Payload, (Size < TLM_PAYLOAD_SIZE) ? Size : TLM_PAYLOAD_SIZE);
+	__atomic_store_n(&Slot->Turn, Idx + 1, __ATOMIC_RELEASE);
+}
+
+void telemetry_set_command(char Key, tlm_command_t Handler){
+	// Entry is complete before being counted, so the thread can already read the table
+	if(NbCommands < TLM_MAX_COMMANDS){
+		CommandKey[NbCommands] = Key;
+		CommandHandler[NbCommands] = Handler;
+		NbCommands++;
+	}
+}
+
+void telemetry_set_stream(tlm_stream_t Handler){
+	StreamHandler = Handler;
+}
+
+uint8_t telemetry_write_block(uint8_t Type, const void* Payload, uint8_t Size, const uint8_t* Data, uint16_t Length){
+	tlm_record_t Record;
+	size_t Sent;
+
+	Record.Sync = TLM_SYNC;
+	Record.Type = Type;
+	Record.Seq = BlockSeq++;
+	Record.Time = chVTGetSystemTime();
+	memset(Record.Payload, 0, TLM_PAYLOAD_SIZE);
+	memcpy(Record.Payload, Payload, (Size < TLM_PAYLOAD_SIZE) ? Size : TLM_PAYLOAD_SIZE);
+
+	Sent = chnWriteTimeout(&SDU1, (uint8_t*)&Record, sizeof(Record), MS2ST(TLM_BLOCK_TIMEOUT));
+	if(Sent == sizeof(Record)){
+		Sent += chnWriteTimeout(&SDU1, Data, Length, MS2ST(TLM_BLOCK_TIMEOUT));
+	}
+	BytesSent += Sent;
+
+	return (Sent == sizeof(Record) + Length);
+}
+
+/*** END PUBLIC FUNCTIONS ***/
@@ -0,0 +1,342 @@
+/**
+ * @file	Telemetry.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of functions to stream binary records over USB serial.
+ * 			Layout of the records, shared with the host decoder (tools/TelemetryDecoder.c).
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+
+// Record define
+#define TLM_SYNC			0xA5	// first byte of every record
+#define TLM_PAYLOAD_SIZE	16		// in [bytes]
+#define TLM_BUFFER_SIZE		64		// in [records], has to be a power of two
+// Record type define
+#define TLM_CELL			1
+#define TLM_PROX			2
+#define TLM_COLOR			3
+#define TLM_MOTOR			4
+#define TLM_POSE			5
+#define TLM_STATUS			6
+#define TLM_THREAD			7
+#define TLM_HISTOGRAM		8
+#define TLM_PERIOD			9
+#define TLM_LOAD			10
+#define TLM_POWER			11
+#define TLM_MODE			12
+#define TLM_COLLISION		13
+#define TLM_ALIGN			14
+#define TLM_SLIP			15
+#define TLM_HEADING			16
+#define TLM_CORRIDOR		17
+#define TLM_PARAM			18
+#define TLM_DECISION		19
+#define TLM_VISION			20
+#define TLM_CALIBRATION		21
+#define TLM_CAMERA			22
+#define TLM_FRAME			23
+#define TLM_IMAGE			24		// followed by Length bytes of data (block)
+#define TLM_NB_TYPES		25
+// Command define
+#define TLM_MAX_COMMANDS	12		// single character commands received from the host
+#define TLM_HISTOGRAM_BUCKETS	7	// buckets in one TLM_HISTOGRAM record
+#define TLM_PERIOD_UNIT		10		// in [us], of the periods of TLM_PERIOD (up to 655 ms)
+
+/*** Structure ***/
+// Record as sent on the serial link (24 bytes, little endian)
+typedef struct __attribute__((packed)) tlm_record_s{
+	uint8_t Sync;
+	uint8_t Type;
+	uint16_t Seq;			// incremented for each record written in the buffer
+	uint32_t Time;			// in [system ticks]
+	uint8_t Payload[TLM_PAYLOAD_SIZE];
+} tlm_record_t;
+
+// TLM_CELL: ActualCell when read or updated
+typedef struct __attribute__((packed)) tlm_cell_s{
+	uint8_t Cell;
+} tlm_cell_t;
+
+// TLM_PROX: raw values of the 8 IR sensors
+typedef struct __attribute__((packed)) tlm_prox_s{
+	uint16_t Prox[8];
+} tlm_prox_t;
+
+// TLM_COLOR: sums of one camera row (scaled to green size) and resulting color bits
+typedef struct __attribute__((packed)) tlm_color_s{
+	uint32_t RedVal;
+	uint32_t GreenVal;
+	uint32_t BlueVal;
+	uint8_t Color;			// colors of this frame
+	uint8_t Confidence;		// in [%], distance of the closest color to the threshold
+	uint8_t Published;		// colors saved in ActualCell after the vote
+} tlm_color_t;
+
+// TLM_MOTOR: motor targets when a command starts or ends
+typedef struct __attribute__((packed)) tlm_motor_s{
+	int16_t SpeedLeft;		// in [step/s]
+	int16_t SpeedRight;		// in [step/s]
+	int16_t Position2Reach;	// in [steps]
+	int16_t NominalSpeed;	// in [step/s]
+	int32_t PosLeft;		// in [steps]
+	int32_t PosRight;		// in [steps]
+} tlm_motor_t;
+
+// TLM_POSE: position of the e-puck in the maze map
+typedef struct __attribute__((packed)) tlm_pose_s{
+	uint8_t X;
+	uint8_t Y;
+	uint8_t Heading;
+	uint8_t Cell;			// ActualCell when the pose was updated
+	uint8_t Waypoints;		// colored cells recorded as waypoints
+	uint8_t Dropped;		// colored cells beyond MAX_WAYPOINTS, not visited by the route
+} tlm_pose_t;
+
+// TLM_STATUS: state of the telemetry itself, sent once per second
+typedef struct __attribute__((packed)) tlm_status_s{
+	uint32_t Dropped;		// records lost because the buffer was full
+	uint32_t BytesSent;
+} tlm_status_t;
+
+// TLM_THREAD: usage of one thread over the last report period
+typedef struct __attribute__((packed)) tlm_thread_s{
+	char Name[8];			// truncated, not null terminated if 8 characters long
+	uint16_t CpuShare;		// in [permille]
+	uint16_t UnusedStack;	// in [bytes], never written since the thread started
+	uint32_t Switches;		// times the thread has been switched in
+} tlm_thread_t;
+
+// TLM_HISTOGRAM: part of the latency histogram of one probe
+typedef struct __attribute__((packed)) tlm_histogram_s{
+	uint8_t Probe;
+	uint8_t FirstBucket;	// index of the bucket of Counts[0]
+	uint16_t Counts[TLM_HISTOGRAM_BUCKETS];
+} tlm_histogram_t;
+
+// TLM_PERIOD: activations of one periodic thread since the last report
+typedef struct __attribute__((packed)) tlm_period_s{
+	uint8_t Id;
+	uint8_t Reserved;
+	uint16_t Misses;		// activations later than the margin
+	uint16_t Min;			// in [TLM_PERIOD_UNIT]
+	uint16_t Max;			// in [TLM_PERIOD_UNIT]
+	uint16_t Mean;			// in [TLM_PERIOD_UNIT]
+	uint16_t Jitter;		// standard deviation of the period in [TLM_PERIOD_UNIT]
+	uint32_t Count;			// number of periods measured
+} tlm_period_t;
+
+// TLM_LOAD: activity of the whole system since the last report
+typedef struct __attribute__((packed)) tlm_load_s{
+	uint8_t Selector;		// mode of operation during the report
+	uint8_t Reserved;
+	uint16_t IdleShare;		// in [permille] of CPU
+	uint32_t Wakeups;		// in [1/s], idle thread left for another thread
+	uint32_t CtxSwitches;	// in [1/s]
+	uint32_t Irqs;			// in [1/s]
+} tlm_load_t;
+
+// TLM_POWER: change of the power state of a peripheral
+typedef struct __attribute__((packed)) tlm_power_s{
+	uint8_t Peripheral;		// POWER_DCMI, POWER_PROXIMITY, POWER_TOF
+	uint8_t State;			// new state, POWER_OFF or POWER_ON
+	uint16_t Reserved;
+	uint32_t ReadyUs;		// time-to-ready in [us], 0 when switched off
+	uint32_t StateMs;		// time spent in the previous state in [ms]
+} tlm_power_t;
+
+// TLM_MODE: change of the mode of operation
+typedef struct __attribute__((packed)) tlm_mode_s{
+	uint8_t Previous;		// selector position of the previous mode, 0xFF at start
+	uint8_t Selector;		// selector position of the new mode
+	uint16_t ThreadsMs;		// requests to the threads --> all acknowledged
+	uint32_t DebounceMs;	// first sample of the new position --> position accepted
+	uint32_t StepMs;		// position accepted --> previous mode left its Step hook
+	uint32_t LatencyMs;		// first sample of the new position --> new mode entered
+} tlm_mode_t;
+
+// TLM_COLLISION: emergency stop before a front wall
+typedef struct __attribute__((packed)) tlm_collision_s{
+	uint16_t ProxFront;		// highest of IR1 and IR8 at the detection
+	int16_t Speed;			// in [step/s] at the detection
+	uint32_t LatencyUs;		// detection --> motors stopped in [us]
+	int32_t StopSteps;		// steps done between the detection and the stop
+	int32_t Remaining;		// steps of the move not done
+} tlm_collision_t;
+
+// TLM_ALIGN: correction of the heading or of the position
+typedef struct __attribute__((packed)) tlm_align_s{
+	uint8_t Source;			// ALIGN_FRONT_WALL or ALIGN_SIDE_EDGE
+	uint8_t Side;			// WALL_RIGHT_B or WALL_LEFT_B for an edge
+	int16_t Heading;		// correction added to the turn in [steps]
+	int16_t Distance;		// correction of the position in [steps]
+	uint16_t ProxLeft;		// IR8 (front wall) or IR6 (edge)
+	uint16_t ProxRight;		// IR1 (front wall) or IR3 (edge)
+} tlm_align_t;
+
+// TLM_SLIP: wheel slip or stall during a command
+typedef struct __attribute__((packed)) tlm_slip_s{
+	uint8_t Source;			// SLIP_FRONT_WALL or SLIP_GYRO
+	uint8_t Reserved;
+	uint16_t Acceleration;	// lowered acceleration in [step/s^2]
+	int16_t Speed;			// applied speed of the left motor in [step/s]
+	int16_t Pos;			// left motor position in the command in [steps]
+	int16_t Expected;		// IR1/IR8 increase or rotation in [mrad/s]
+	int16_t Measured;		// IR1/IR8 increase or rotation in [mrad/s]
+} tlm_slip_t;
+
+// TLM_HEADING: end of a turn closed on the fused heading
+typedef struct __attribute__((packed)) tlm_heading_s{
+	int16_t Target;			// rotation asked in [mrad], counterclockwise is positive
+	int16_t Fused;			// rotation given by the fused heading in [mrad]
+	int16_t Odometry;		// rotation given by the steps in [mrad]
+	int16_t Steps;			// left motor position at the end in [steps]
+	int32_t Bias;			// estimated gyro bias in [urad/s]
+} tlm_heading_t;
+
+// TLM_CORRIDOR: free cells ahead measured by the time of flight sensor
+typedef struct __attribute__((packed)) tlm_corridor_s{
+	uint16_t Distance;		// median distance to the front wall in [mm]
+	uint8_t Cells;			// free cells ahead of the cell of the e-puck
+	uint8_t Reserved;
+} tlm_corridor_t;
+
+// TLM_PARAM: value of a runtime parameter, new or reported
+typedef struct __attribute__((packed)) tlm_param_s{
+	uint8_t Id;				// PARAM_ONE_CELL, ...
+	uint8_t Result;			// PARAM_ACCEPTED or PARAM_REJECTED (out of range)
+	uint16_t Reserved;
+	int32_t Value;
+	int32_t Min;
+	int32_t Max;
+} tlm_param_t;
+
+// TLM_DECISION: input and result of one step of the maze solving modes
+typedef struct __attribute__((packed)) tlm_decision_s{
+	uint8_t Selector;		// mode of the decision
+	uint8_t Cell;			// ActualCell used for the decision
+	int16_t Direction;		// given to go_next_cell() (LEFT_TURN, ...)
+	uint8_t NbCells;		// cells of a go_straight(), 0 if go_next_cell()
+	uint8_t Corridor;		// free cells ahead given by the time of flight, 0 if not used
+} tlm_decision_t;
+
+// TLM_VISION: front wall found by the camera, when it changes
+typedef struct __attribute__((packed)) tlm_vision_s{
+	uint16_t Distance;		// in [mm] from the center of the e-puck, VISION_NO_WALL if none
+	int8_t Row;				// bottom of the wall in the image, -1 if none
+	uint8_t Reserved;
+	uint32_t DurationUs;	// wall search of the frame in [us]
+} tlm_vision_t;
+
+// TLM_CALIBRATION: end of the calibration of the camera gains
+typedef struct __attribute__((packed)) tlm_calibration_s{
+	uint8_t Result;			// CALIB_CONVERGED, ...
+	uint8_t Iterations;
+	uint16_t DurationMs;	// start --> result in [ms]
+	uint8_t RedGain;		// gains and contrast in use at the end
+	uint8_t GreenGain;
+	uint8_t BlueGain;
+	uint8_t Contrast;
+	uint16_t RedVal;		// sums of the color row of the last image (scaled to green size)
+	uint16_t GreenVal;
+	uint16_t BlueVal;
+} tlm_calibration_t;
+
+// TLM_CAMERA: frames given to ProcessImage during CAMERA_RATE_PERIOD
+typedef struct __attribute__((packed)) tlm_camera_s{
+	uint8_t Preset;			// CAMERA_PRESET_AUTO, ...
+	uint8_t AutoExposure;
+	uint16_t Exposure;		// in [lines], fixed exposure
+	uint16_t FrameHeight;	// in [lines]
+	uint16_t Frames;		// during the period
+	uint16_t Rate;			// in [0.1 frame/s]
+	uint16_t Travel;		// in [0.1 mm], distance driven between two frames
+} tlm_camera_t;
+
+// TLM_FRAME: image streamed to the host, sent before its TLM_IMAGE blocks
+typedef struct __attribute__((packed)) tlm_frame_s{
+	uint16_t Frame;			// incremented for each streamed image
+	uint16_t Width;			// in [pxl]
+	uint16_t Height;		// in [pxl]
+	uint8_t NbChunks;		// TLM_IMAGE blocks of the image
+	uint8_t Selector;		// mode running when the image was captured
+	uint8_t Cell;			// ActualCell when the image was captured
+	uint8_t X;				// pose of the e-puck in the maze map
+	uint8_t Y;
+	uint8_t Heading;
+} tlm_frame_t;
+
+/* TLM_IMAGE: header of one chunk of a streamed image, in RGB565 (two bytes per pixel, big endian),
+ *  followed by Length bytes. With IMAGE_RLE, the bytes are (count, pixel high, pixel low) triplets.
+ */
+typedef struct __attribute__((packed)) tlm_image_s{
+	uint16_t Length;		// in [bytes], data after the record, always the first field
+	uint16_t Frame;
+	uint8_t Chunk;
+	uint8_t Encoding;		// IMAGE_RAW or IMAGE_RLE
+	uint16_t RawLength;		// in [bytes], once decoded
+	uint16_t Checksum;		// sum of the Length bytes of data
+} tlm_image_t;
+
+// Function called when a command is received
+typedef void (*tlm_command_t)(void);
+// Function called after the records, sends blocks with telemetry_write_block()
+typedef void (*tlm_stream_t)(void);
+
+
+/**
+ * @brief	Starts thread to send the records and receive the commands
+ * 			 over USB serial (SDU1) with NORMALPRIO to SendTelemetry
+ */
+void telemetry_start(void);
+
+/**
+ * @brief	Copies a record in the buffer. Lock-free, can be called from any thread.
+ * 			The record is dropped if the buffer is full.
+ *
+ * @param Type		Type of record (TLM_CELL, TLM_PROX, ...)
+ * @param Payload	Structure corresponding to the type
+ * @param Size		Size of the structure, at most TLM_PAYLOAD_SIZE
+ */
+void telemetry_write(uint8_t Type, const void* Payload, uint8_t Size);
+
+/**
+ * @brief	Registers a function called by thread SendTelemetry
+ * 			 each time the host sends a given character.
+ *
+ * @param Key		Character of the command
+ * @param Handler	Function to call, usually writing records
+ */
+void telemetry_set_command(char Key, tlm_command_t Handler);
+
+/**
+ * @brief	Registers the function called by thread SendTelemetry once the records
+ * 			 of each cycle are sent, while a host is connected. Only one.
+ *
+ * @param Handler	Function to call, sending blocks
+ */
+void telemetry_set_stream(tlm_stream_t Handler);
+
+/**
+ * @brief	Sends a record followed by a block of data, at once.
+ * 			Only called by thread SendTelemetry (stream and command handlers),
+ * 			 the records are never cut by a block.
+ *
+ * @param Type		Type of record (TLM_IMAGE), its payload starts with the length of the block
+ * @param Payload	Structure corresponding to the type
+ * @param Size		Size of the structure, at most TLM_PAYLOAD_SIZE
+ * @param Data		Block sent after the record
+ * @param Length	Size of the block in [bytes]
+ *
+ * @return			1 if all was sent, 0 if the host didn't read it in time
+ */
+uint8_t telemetry_write_block(uint8_t Type, const void* Payload, uint8_t Size, const uint8_t* Data, uint16_t Length);
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,91 @@
+/**
+ * @file	ThreadPark.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Park and unpark of a thread with acknowledged transitions.
+ * 			Request and acknowledged state are only changed while in lock,
+ * 			 the events only wake the threads up, so none can be missed.
+ */
+
+#include <main.h>
+#include <ThreadPark.h>
+
+
+/*** PUBLIC FUNCTIONS ***/
+
+void park_init(thd_metadata_t *ThdMetaData, thread_t *Thd){
+	chSysLock();
+	ThdMetaData->Thd = Thd;
+	chSysUnlock();
+}
+
+void park_request(thd_metadata_t *ThdMetaData, uint8_t Request){
+	chSysLock();
+	ThdMetaData->Requester = chThdGetSelfX();
+	// Already in this state and nothing pending --> no need to interrupt the thread
+	if((ThdMetaData->Request == Request) && (ThdMetaData->Sleep == Request)){
+		chSysUnlock();
+		return;
+	}
+	ThdMetaData->Request = Request;
+	// Interrupts the waits of the thread, it checks its request right after
+	if(ThdMetaData->Thd != NULL){
+		chEvtSignalI(ThdMetaData->Thd, PARK_EVT);
+		chSchRescheduleS();
+	}
+	chSysUnlock();
+}
+
+msg_t park_wait_ack(thd_metadata_t *ThdMetaData, systime_t Timeout){
+	systime_t Start = chVTGetSystemTime();
+	systime_t Elapsed;
+
+	// Acknowledges of other threads also wake up, the state tells which one arrived
+	while(ThdMetaData->Sleep != ThdMetaData->Request){
+		Elapsed = chVTGetSystemTime() - Start;
+		if(Elapsed >= Timeout){
+			return MSG_TIMEOUT;
+		}
+		chEvtWaitAnyTimeout(PARK_ACK_EVT, Timeout - Elapsed);
+	}
+	return MSG_OK;
+}
+
+uint8_t park_requested(const thd_metadata_t *ThdMetaData){
+	return (ThdMetaData->Request == SLEEP_MODE) && (ThdMetaData->Sleep == AWAKE_MODE);
+}
+
+void park_self(thd_metadata_t *ThdMetaData){
+	chSysLock();
+	ThdMetaData->Sleep = SLEEP_MODE;
+	chEvtSignalI(ThdMetaData->Requester, PARK_ACK_EVT);
+	chSchRescheduleS();
+
+	// A wakeup requested meanwhile has already signalled PARK_EVT, the wait returns at once
+	while(ThdMetaData->Request == SLEEP_MODE){
+		chSysUnlock();
+		chEvtWaitAny(PARK_EVT);
+		chSysLock();
+	}
+
+	ThdMetaData->Sleep = AWAKE_MODE;
+	chEvtSignalI(ThdMetaData->Requester, PARK_ACK_EVT);
+	chSchRescheduleS();
+	chSysUnlock();
+}
+
+eventmask_t park_sleep_until(eventmask_t Events, systime_t Prev, systime_t Next){
+	systime_t Now = chVTGetSystemTime();
+
+	// Same test as chThdSleepUntilWindowed(), Next already passed --> no wait
+	if((systime_t)(Now - Prev) < (systime_t)(Next - Prev)){
+		return chEvtWaitAnyTimeout(Events | PARK_EVT, Next - Now);
+	}
+	return 0;
+}
+
+/*** END PUBLIC FUNCTIONS ***/
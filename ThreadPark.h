@@ -0,0 +1,78 @@
+/**
+ * @file	ThreadPark.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of the service to park (send to sleep) and unpark
+ * 			 a thread from another one, based on the thd_metadata_t of the thread.
+ * 			The request wakes the thread up with PARK_EVT, the thread acknowledges
+ * 			 the new state with PARK_ACK_EVT once it has been reached.
+ */
+
+#ifndef THREADPARK_H_
+#define THREADPARK_H_
+
+// Park define
+#define PARK_TIMEOUT	100		// in [ms], maximum time of a transition
+
+
+/**
+ * @brief	Saves the thread to park or unpark. Called by the thread itself
+ * 			 or by the one creating it, before any request.
+ *
+ * @param ThdMetaData	Metadata of the thread
+ * @param Thd			Thread
+ */
+void park_init(thd_metadata_t *ThdMetaData, thread_t *Thd);
+
+/**
+ * @brief	Asks a thread to sleep or to wake up, without waiting for it.
+ * 			The acknowledge will be sent to the calling thread.
+ *
+ * @param ThdMetaData	Metadata of the thread
+ * @param Request		SLEEP_MODE or AWAKE_MODE
+ */
+void park_request(thd_metadata_t *ThdMetaData, uint8_t Request);
+
+/**
+ * @brief	Waits until a thread has acknowledged the last request.
+ *
+ * @param ThdMetaData	Metadata of the thread
+ * @param Timeout		Maximum time to wait (MS2ST(PARK_TIMEOUT), ...)
+ *
+ * @return				MSG_OK if acknowledged, MSG_TIMEOUT otherwise
+ */
+msg_t park_wait_ack(thd_metadata_t *ThdMetaData, systime_t Timeout);
+
+/**
+ * @brief	Returns 1 if the thread has been asked to sleep and still runs.
+ * 			Called by the thread itself, to stop its peripherals before park_self().
+ *
+ * @param ThdMetaData	Metadata of the calling thread
+ */
+uint8_t park_requested(const thd_metadata_t *ThdMetaData);
+
+/**
+ * @brief	Acknowledges the sleep request and waits to be woken up,
+ * 			 then acknowledges the wakeup. Called by the thread itself.
+ *
+ * @param ThdMetaData	Metadata of the calling thread
+ */
+void park_self(thd_metadata_t *ThdMetaData);
+
+/**
+ * @brief	Replaces chThdSleepUntilWindowed() in a parkable thread:
+ * 			 sleeps until Next or until a request or one of Events arrives.
+ *
+ * @param Events		Other events ending the sleep (0 for none)
+ * @param Prev			Start of the current period
+ * @param Next			End of the current period
+ *
+ * @return				Events received, 0 if Next has been reached
+ */
+eventmask_t park_sleep_until(eventmask_t Events, systime_t Prev, systime_t Next);
+
+#endif /* THREADPARK_H_ */
@@ -28,6 +28,9 @@
 #ifndef _CHCONF_H_
 #define _CHCONF_H_
 
+/* EPUCK_TICKLESS switch is defined with the system timer in mcuconf.h */
+#include "mcuconf.h"
+
 /*===========================================================================*/
 /**
  * @name System timers settings
@@ -56,7 +59,11 @@
  *          The value one is not valid, timeouts are rounded up to
  *          this value.
  */
+#if defined(EPUCK_TICKLESS)
+#define CH_CFG_ST_TIMEDELTA                 2
+#else
 #define CH_CFG_ST_TIMEDELTA                 0
+#endif
 
 /** @} */
 
@@ -79,7 +86,11 @@
  * @note    The round robin preemption is not supported in tickless mode and
  *          must be set to zero in that case.
  */
+#if defined(EPUCK_TICKLESS)
+#define CH_CFG_TIME_QUANTUM                 0
+#else
 #define CH_CFG_TIME_QUANTUM                 20
+#endif
 
 /**
  * @brief   Managed RAM size.
@@ -394,7 +405,11 @@
  * @note    This debug option is not currently compatible with the
  *          tickless mode.
  */
+#if defined(EPUCK_TICKLESS)
+#define CH_DBG_THREADS_PROFILING            FALSE
+#else
 #define CH_DBG_THREADS_PROFILING            TRUE
+#endif
 
 /** @} */
 
@@ -336,6 +336,18 @@
 #define SPI_USE_MUTUAL_EXCLUSION    TRUE
 #endif
 
+/*===========================================================================*/
+/* Tickless mode checks.                                                     */
+/*===========================================================================*/
+
+/* TIM5 is the system timer with EPUCK_TICKLESS (mcuconf.h). Checked here and
+   not in mcuconf.h: it is first read by chconf.h, before TRUE is defined. */
+#if defined(EPUCK_TICKLESS)
+#if STM32_PWM_USE_TIM5 || STM32_GPT_USE_TIM5 || STM32_ICU_USE_TIM5
+#error "EPUCK_TICKLESS: TIM5 is the system timer, PWMD5, GPTD5 and ICUD5 can't be enabled"
+#endif
+#endif
+
 #endif /* _HALCONF_H_ */
 
 /** @} */
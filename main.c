@@ -23,57 +23,291 @@
 #include <leds.h>
 #include <selector.h>
 #include <spi_comm.h>
+#include <usbcfg.h>
+#include <i2c_bus.h>
+#include <sensors/imu.h>
 
 #include <main.h>
 #include <DataAcquisition.h>
 #include <DataProcess.h>
 #include <SystemControl.h>
+#include <MazeMap.h>
+#include <Telemetry.h>
+#include <SystemMonitor.h>
+#include <LatencyProbe.h>
+#include <ModeManager.h>
+#include <HeadingEstimator.h>
+#include <MazeParameters.h>
+#include <CameraCalibration.h>
+#include <ImageStream.h>
 
 
 /*** GLOBAL VARIABLES ***/
 messagebus_t bus;
 MUTEX_DECL(bus_lock);
 CONDVAR_DECL(bus_condvar);
+parameter_namespace_t parameter_root;
 
-/*** EXTERN VARIABLES ***/
-extern binary_semaphore_t MotorReady_sem;
-extern thd_metadata_t ControlMotor_MetaData;
-extern thd_metadata_t GetProximity_MetaData;
-extern thd_metadata_t CaptureImage_MetaData;
+/*** STATIC VARIABLES ***/
+static uint8_t EPuckCell 		= 0;
+static int8_t ExitStatus 		= SEARCHING;
+static tlm_pose_t PoseData;
+static tlm_decision_t DecisionData;
+static uint8_t CalibrationDone 	= 0;
+static uint8_t NewCell 			= 1;	// the last move reached the next cell, its floor action is due
 
 
 /*** INTERNAL FUNCTIONS ***/
 
 /**
- * @brief	Send a thread to sleep. Can be called from another thread.
- * 			 The thread in question has to check his Sleep variable
- * 			 before entering in sleep mode.
- *
- * @param	ThdMetaData		Variable containing thread metadata
+ * @brief	Clears all LEDs, at the start and at the end of every mode.
  */
-void make_thread_sleep(thd_metadata_t* ThdMetaData){
-	ThdMetaData->Sleep = SLEEP_MODE;
+static void clear_all_leds(void){
+	set_body_led(LED_OFF);
+	set_front_led(LED_OFF);
+	clear_leds();
 }
 
+/**
+ * @brief	Blinks a LED once, returns early if the selector changes.
+ */
+static void blink_led(void (*SetLed)(unsigned int)){
+	SetLed(TOGGLE_LED);
+	mode_wait_events(0, MS2ST(BLINK_PERIOD));
+}
 
 /**
- * @brief	Wake a thread up.
- *
- * @param	ThdMetaData		Variable containing thread metadata
+ * @brief	Lets the time to remove hands from the selector before moving.
+ */
+static void wait_hands_removed(void){
+	mode_wait_events(0, MS2ST(MODE_START_DELAY));
+}
+
+/**
+ * @brief	Writes the input and the result of a decision, replayed on the host
+ * 			 by tools/TraceReplay.c.
+ */
+static void send_decision(uint8_t Cell, int16_t Direction, uint8_t NbCells, uint8_t Corridor){
+	DecisionData.Selector = mode_get_selector();
+	DecisionData.Cell = Cell;
+	DecisionData.Direction = Direction;
+	DecisionData.NbCells = NbCells;
+	DecisionData.Corridor = Corridor;
+	telemetry_write(TLM_DECISION, &DecisionData, sizeof(DecisionData));
+}
+
+/**
+ * @brief	Returns the cells completed by a move of the given steps (motor_wait_ready()),
+ * 			 rounded as the edge of a side wall moves the end of a cell.
+ */
+static uint8_t cells_done(int16_t Steps){
+	int32_t CellSteps = param_get(PARAM_ONE_CELL);
+
+	return (Steps + CellSteps / 2) / CellSteps;
+}
+
+/**
+ * @brief	One cell of maze solving with the given algorithm.
  */
-void make_thread_wakeup(thd_metadata_t* ThdMetaData){
-	if(ThdMetaData->Sleep){
-		chSysLock();
-		chThdResumeS(&(ThdMetaData->ThdReference), AWAKE_MODE);
-		chSysUnlock();
+static void solve_maze_step(int16_t (*Algorithm)(uint8_t)){
+	int16_t Direction;
+
+	// Updates the EPuckCell with the most recent one
+	EPuckCell = get_actual_cell();
+
+	// Sets LEDs
+	set_wall_leds(EPuckCell);
+	set_floor_leds(EPuckCell);
+
+	/* Updates ExitStatus and searches for an exit
+	 *		SEARCHING: 	algorithm of the mode.
+	 *		FOUND: 		blink body LED green.
+	 *		BLOCKED: 	blink front LED red.
+	 */
+	check_exit(EPuckCell, &ExitStatus);
+	switch (ExitStatus) {
+	case SEARCHING:
+		// Still in the same cell after a collision stop --> its action has been done
+		if(NewCell){
+			floor_color_action(EPuckCell);
+		}
+		Direction = Algorithm(EPuckCell);
+		send_decision(EPuckCell, Direction, 0, 0);
+		go_next_cell(Direction);
+		NewCell = (cells_done(motor_wait_ready()) > 0);
+		break;
+	case FOUND:
+		blink_led(set_body_led);
+		break;
+	case BLOCKED:
+		blink_led(set_front_led);
+	default:
+		break;
 	}
 }
 
+/*** MODE HOOKS ***/
+
+// Selector = 0: maze solving with left wall follower algorithm.
+static void left_wall_follower_step(void){
+	solve_maze_step(left_wall_follower);
+}
+
+// Selector = 1: maze solving with Pledge algorithm.
+static void pledge_enter(void){
+	// Resets orientation so that Pledge algorithm is usable without a total reset
+	reset_orientation();
+	wait_hands_removed();
+}
+
+static void pledge_step(void){
+	solve_maze_step(pledge_algorithm);
+}
+
+// Selector = 2: demonstration walls detection.
+static void walls_demo_step(void){
+	EPuckCell = get_actual_cell();
+	set_wall_leds(EPuckCell);
+	mode_wait_events(CELL_CHANGED_EVT, TIME_INFINITE);
+}
+
+// Selector = 3: demonstration colors detection.
+static void colors_demo_step(void){
+	EPuckCell = get_actual_cell();
+	set_floor_leds(EPuckCell);
+	mode_wait_events(CELL_CHANGED_EVT, TIME_INFINITE);
+}
+
+// Selector = 4: walls detection and color detection.
+static void detection_demo_step(void){
+	EPuckCell = get_actual_cell();
+	set_wall_leds(EPuckCell);
+	set_floor_leds(EPuckCell);
+	mode_wait_events(CELL_CHANGED_EVT, TIME_INFINITE);
+}
+
+// Selector = 5: maze exploration then route through the colored cells.
+static void route_enter(void){
+	// Restarts the map from the cell where the e-puck stands
+	reset_orientation();
+	map_reset();
+	wait_hands_removed();
+}
+
+static void route_step(void){
+	int16_t Direction = MOVE_FORWARD;
+	uint8_t NbCells = 0;
+	uint8_t Corridor = 0;
+
+	// Updates the EPuckCell with the most recent one and saves it in the map
+	EPuckCell = get_actual_cell();
+	map_record_cell(EPuckCell);
+
+	// Sends the pose of the e-puck in the map
+	map_get_pose(&PoseData.X, &PoseData.Y, &PoseData.Heading);
+	PoseData.Cell = EPuckCell;
+	PoseData.Waypoints = map_get_waypoint_count();
+	PoseData.Dropped = map_get_waypoint_dropped();
+	telemetry_write(TLM_POSE, &PoseData, sizeof(PoseData));
+
+	// Sets LEDs
+	set_wall_leds(EPuckCell);
+	set_floor_leds(EPuckCell);
+
+	/* Colored cells are waypoints, no floor action
+	 *		Exploring: 	left wall follower algorithm, colored cells are recorded.
+	 *		Routing: 	shortest tour through the colored cells.
+	 *		Done: 		blink body LED green.
+	 */
+	if(!map_exploration_done()){
+		// Left wall follower until it loops, out of the exit --> back into the maze
+		if(!map_frontier_direction(&Direction)){
+			Direction = left_wall_follower(EPuckCell);
+		}
+	}else if(route_next_direction(&Direction) == ROUTE_DONE){
+		blink_led(set_body_led);
+		return;
+	}else if(Direction == MOVE_FORWARD){
+		NbCells = route_straight_cells();
+	}
+
+	// Straight of several cells --> as far as the time of flight sees the corridor free
+	if(NbCells > 1){
+		mode_wait_events(0, MS2ST(TOF_SETTLE_TIME));
+		Corridor = get_corridor_length();
+		if(Corridor < NbCells){
+			NbCells = Corridor;
+		}
+	}
+	send_decision(EPuckCell, Direction, (NbCells > 1) ? NbCells : 0, Corridor);
+
+	if(NbCells > 1){
+		go_straight(NbCells);
+	}else{
+		go_next_cell(Direction);
+	}
+	/* The turn is done even if a collision stop cuts the move short, only the completed
+	 *  cells are mapped: a wall the time of flight missed stops the straight before it.
+	 */
+	map_advance(Direction, cells_done(motor_wait_ready()));
+}
+
+// Selector = 6: calibration of the camera gains on a white cell.
+static void calibration_enter(void){
+	CalibrationDone = 0;
+	wait_hands_removed();
+}
+
+static void calibration_step(void){
+	/* Once per selection, then the result stays on until the selector changes
+	 *		Converged and saved: 	body LED on.
+	 *		Otherwise: 				front LED on, the previous gains are kept.
+	 */
+	if(!CalibrationDone){
+		if(camera_calibrate() == CALIB_CONVERGED){
+			set_body_led(LED_ON);
+		}else{
+			set_front_led(LED_ON);
+		}
+		CalibrationDone = 1;
+	}
+	mode_wait_events(0, TIME_INFINITE);
+}
+
+// Default: own threads sleep, nothing to do until the selector changes
+static void idle_step(void){
+	mode_wait_events(0, TIME_INFINITE);
+}
+
+/*** END MODE HOOKS ***/
+
+/*** E-PUCK MODES OF OPERATION
+ *		Selector = 0: maze solving with left wall follower algorithm.
+ *		Selector = 1: maze solving with Pledge algorithm.
+ *		Selector = 2: demonstration walls detection.
+ *		Selector = 3: demonstration colors detection.
+ *		Selector = 4: walls detection and color detection.
+ *		Selector = 5: maze exploration then route through the colored cells.
+ *						Straights of the route in one move where the time of flight sees free.
+ *		Selector = 6: calibration of the camera gains on a white cell, saved in flash.
+ *		Default		: send own threads to sleep, they stop their peripherals
+ ***/
+static const selector_mode_t Modes[] = {
+	[POS_SEL_0] = {MODE_SOLVER_THREADS, 	wait_hands_removed, left_wall_follower_step, 	clear_all_leds},
+	[POS_SEL_1] = {MODE_SOLVER_THREADS, 	pledge_enter, 		pledge_step, 				clear_all_leds},
+	[POS_SEL_2] = {MODE_GET_PROXIMITY_B, 	NULL, 				walls_demo_step, 			clear_all_leds},
+	[POS_SEL_3] = {MODE_CAPTURE_IMAGE_B, 	NULL, 				colors_demo_step, 			clear_all_leds},
+	[POS_SEL_4] = {MODE_GET_PROXIMITY_B | MODE_CAPTURE_IMAGE_B,
+											NULL, 				detection_demo_step, 		clear_all_leds},
+	[POS_SEL_5] = {MODE_ALL_THREADS, 		route_enter, 		route_step, 				clear_all_leds},
+	[POS_SEL_6] = {MODE_CAPTURE_IMAGE_B, 	calibration_enter, 	calibration_step, 			clear_all_leds}};
+
+static const selector_mode_t IdleMode = {MODE_NO_THREAD, NULL, idle_step, NULL};
+
 /*** MAIN ***/
 int main(void){
 	/*** INTERNAL VARIABLES ***/
-	uint8_t EPuckCell = 0;
-	int8_t ExitStatus = SEARCHING;
+	event_listener_t CellListener;
 
 	/*** INITIALIZATION ***/
 	// inits ChibiOS + mcu
@@ -83,6 +317,9 @@ int main(void){
 
 	// inits intern communication protocol
 	messagebus_init(&bus, &bus_lock, &bus_condvar);
+	// inits runtime parameters, read by the threads from their start
+	parameter_namespace_declare(&parameter_root, NULL, NULL);
+	parameters_init();
 
 	// inits peripherals
 	dcmi_start();
@@ -90,203 +327,40 @@ int main(void){
 	motors_init();
 	proximity_start();
 	spi_comm_start();
+	usb_start();
+	i2c_start();
+#if (SLIP_IMU_CHECK == TRUE) || (HEADING_USE_GYRO == TRUE)
+	imu_start();
+#endif
 
 	// inits threads
+	probe_init();
+	image_stream_init();
 	control_motor_start();
 	proximity_acquisition_start();
 	color_acquisition_start();
+	distance_acquisition_start();
+	telemetry_start();
+	system_monitor_start();
+#if HEADING_USE_GYRO == TRUE
+	heading_estimator_start();
+#endif
+
+	// Modes without motion wait for a change of the cell instead of polling it
+	register_cell_listener(&CellListener, CELL_CHANGED_EVT);
 
 	// sleeps to get everything correctly initialized
 	chThdSleepMilliseconds(2000);
+#if (SLIP_IMU_CHECK == TRUE) || (HEADING_USE_GYRO == TRUE)
+	// Gyro offsets measured while the e-puck stands still
+	calibrate_gyro();
+#endif
 
-	/*** INFINITE LOOP ***/
-	while(1){
-		/*** E-PUCK MODES OF OPERATION
-		 *		Selector = 0: maze solving with left wall follower algorithm.
-		 *		Selector = 1: maze solving with Pledge algorithm.
-		 *		Selector = 2: demonstration walls detection.
-		 *		Selector = 3: demonstration colors detection.
-		 *		Selector = 4: walls detection and color detection.
-		 *		Default		: send own threads to sleep
-		 ***/
-		switch(get_selector()){
-		case POS_SEL_0:	// Selector = 0: maze solving with left wall follower algorithm.
-			// Clears all LEDs
-			set_body_led(LED_OFF);
-			set_front_led(LED_OFF);
-			clear_leds();
-
-			// Wakes necessary threads up
-			make_thread_wakeup(&ControlMotor_MetaData);
-			make_thread_wakeup(&GetProximity_MetaData);
-			make_thread_wakeup(&CaptureImage_MetaData);
-
-			do{
-				// Updates the EPuckCell with the most recent one
-				EPuckCell = get_actual_cell();
-
-				// Sets LEDs
-				set_wall_leds(EPuckCell);
-				set_floor_leds(EPuckCell);
-
-				/* Updates ExitStatus and searches for an exit
-				 *		SEARCHING: 	left wall follower algorithm.
-				 *		FOUND: 		blink body LED green.
-				 *		BLOCKED: 	blink front LED red.
-				 */
-				check_exit(EPuckCell, &ExitStatus);
-				switch (ExitStatus) {
-				case SEARCHING:
-					floor_color_action(EPuckCell);
-					go_next_cell(left_wall_follower(EPuckCell));
-					chBSemWait(&MotorReady_sem);
-					break;
-				case FOUND:
-					set_body_led(TOGGLE_LED);
-					chThdSleepMilliseconds(500);
-					break;
-				case BLOCKED:
-					set_front_led(TOGGLE_LED);
-					chThdSleepMilliseconds(500);
-				default:
-					break;
-				}
-			}while(get_selector() == POS_SEL_0);
-			break;
-
-		case POS_SEL_1:	// Selector = 1: maze solving with Pledge algorithm.
-			// Resets orientation so that Pledge algorithm is usable without a total reset
-			reset_orientation();
-
-			// Clears all LEDs
-			set_body_led(LED_OFF);
-			set_front_led(LED_OFF);
-			clear_leds();
-
-			// Wakes necessary threads up
-			make_thread_wakeup(&ControlMotor_MetaData);
-			make_thread_wakeup(&GetProximity_MetaData);
-			make_thread_wakeup(&CaptureImage_MetaData);
-
-			do{
-				// Updates the EPuckCell with the most recent one
-				EPuckCell = get_actual_cell();
-
-				// Sets LEDs
-				set_wall_leds(EPuckCell);
-				set_floor_leds(EPuckCell);
-
-				/* Updates ExitStatus and searches for an exit
-				 *		SEARCHING: 	left wall follower algorithm.
-				 *		FOUND: 		blink body LED green.
-				 *		BLOCKED: 	blink front LED red.
-				 */
-				check_exit(EPuckCell, &ExitStatus);
-				switch (ExitStatus) {
-				case SEARCHING:
-					floor_color_action(EPuckCell);
-					go_next_cell(pledge_algorithm(EPuckCell));
-					chBSemWait(&MotorReady_sem);
-					break;
-				case FOUND:
-					set_body_led(TOGGLE_LED);
-					chThdSleepMilliseconds(500);
-					break;
-				case BLOCKED:
-					set_front_led(TOGGLE_LED);
-					chThdSleepMilliseconds(500);
-				default:
-					break;
-				}
-			}while(get_selector() == POS_SEL_1);
-			break;
-
-		case POS_SEL_2:	// Selector = 2: demonstration walls detection.
-			// Sends unnecessary thread to sleep
-			make_thread_sleep(&ControlMotor_MetaData);
-			make_thread_sleep(&CaptureImage_MetaData);
-
-			// Clear all LEDs
-			set_body_led(LED_OFF);
-			set_front_led(LED_OFF);
-			clear_leds();
-
-			// Wakes necessary threads up
-			make_thread_wakeup(&GetProximity_MetaData);
-
-			do{
-				// Set wall LEDs
-				EPuckCell = get_actual_cell();
-				set_wall_leds(EPuckCell);
-				chThdYield();
-			}while(get_selector() == POS_SEL_2);
-			break;
-
-		case POS_SEL_3:	// Selector = 3: demonstration colors detection.
-			// Sends unnecessary thread to sleep
-			make_thread_sleep(&ControlMotor_MetaData);
-			make_thread_sleep(&GetProximity_MetaData);
-
-			// Clear all LEDs
-			set_body_led(LED_OFF);
-			set_front_led(LED_OFF);
-			clear_leds();
-
-			// Wakes necessary threads up
-			make_thread_wakeup(&CaptureImage_MetaData);
-
-			do{
-				// Set floor LEDs
-				EPuckCell = get_actual_cell();
-				set_floor_leds(EPuckCell);
-				chThdYield();
-			}while(get_selector() == POS_SEL_3);
-			break;
-
-		case POS_SEL_4:	// Selector = 4: walls detection and color detection.
-			// Sends unnecessary thread to sleep
-			make_thread_sleep(&ControlMotor_MetaData);
-
-			// Clear body + front LEDs
-			set_body_led(LED_OFF);
-			set_front_led(LED_OFF);
-
-			// Wakes necessary threads up
-			make_thread_wakeup(&GetProximity_MetaData);
-			make_thread_wakeup(&CaptureImage_MetaData);
-
-			do{
-				// Set wall + floor LEDs
-				EPuckCell = get_actual_cell();
-				set_wall_leds(EPuckCell);
-				set_floor_leds(EPuckCell);
-				chThdYield();
-			}while(get_selector() == POS_SEL_4);
-			break;
-
-		default: 		// Default: send own threads to sleep
-			// Only once
-			if(	!ControlMotor_MetaData.Sleep ||
-					!GetProximity_MetaData.Sleep ||
-					!CaptureImage_MetaData.Sleep ){
-
-				// Sends unnecessary thread to sleep
-				make_thread_sleep(&ControlMotor_MetaData);
-				make_thread_sleep(&GetProximity_MetaData);
-				make_thread_sleep(&CaptureImage_MetaData);
-
-				// Clears all LEDs
-				set_body_led(LED_OFF);
-				set_front_led(LED_OFF);
-				clear_leds();
-			}
-			break;
-		}
+	// LEDs are cleared once, then by the exit hook of every mode
+	clear_all_leds();
 
-		// Sleeps to be able to remove hands before a switch of selector
-		chThdSleepMilliseconds(1500);
-	}
-	/*** END INFINITE LOOP ***/
+	// Runs the mode of the selector position, never returns
+	mode_manager_run(Modes, sizeof(Modes) / sizeof(Modes[0]), &IdleMode);
 }
 /*** END MAIN ***/
 
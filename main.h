@@ -7,9 +7,20 @@ extern "C" {
 
 #include <stdint.h>
 
+// HOST_BUILD --> only the defines, for the host tools (trace replay, ...)
+#if !defined(HOST_BUILD)
 #include <camera/dcmi_camera.h>
 #include <msgbus/messagebus.h>
 #include <parameter/parameter.h>
+#else
+// Values of the compile-time switches (X == TRUE), given by ChibiOS on the e-puck
+#define FALSE				0
+#define TRUE				1
+// HOST_KERNEL --> also the metadata of the parked threads, on the kernel of tools/host/ch.h
+#if defined(HOST_KERNEL)
+#include <ch.h>
+#endif
+#endif
 
 // Selector define
 #define POS_SEL_0	0
@@ -17,6 +28,8 @@ extern "C" {
 #define POS_SEL_2	2
 #define POS_SEL_3	3
 #define POS_SEL_4	4
+#define POS_SEL_5	5
+#define POS_SEL_6	6
 
 // LEDs define
 #define LED_OFF		0
@@ -59,17 +72,32 @@ extern "C" {
 // Thread define
 #define SLEEP_MODE		1
 #define AWAKE_MODE		0
+// Event define
+#define CELL_CHANGED_EVT		EVENT_MASK(0)	// ActualCell changed (walls or color)
+#define MODE_CHANGED_EVT		EVENT_MASK(1)	// selector changed (debounced)
+#define PARK_ACK_EVT			EVENT_MASK(6)	// parked thread reached the requested state
+#define PARK_EVT				EVENT_MASK(7)	// new park request, reserved in every parkable thread
+
+// Mode define
+#define MODE_START_DELAY		1000	// in [ms], to remove hands before a mode with motion
+#define BLINK_PERIOD			500		// in [ms]
 
+#if !defined(HOST_BUILD) || defined(HOST_KERNEL)
 /*** Structure ***/
 typedef struct thd_metadata_s{
-    uint8_t Sleep;
-    thread_reference_t ThdReference;
+    volatile uint8_t Request;		// state asked by another thread, SLEEP_MODE or AWAKE_MODE
+    volatile uint8_t Sleep;			// state acknowledged by the thread itself
+    thread_t *Thd;
+    thread_t *Requester;			// thread waiting for the acknowledge
 } thd_metadata_t;
+#endif
 
+#if !defined(HOST_BUILD)
 /*** EXTERN VARIABLES ***/
 //Robot wide IPC bus
 extern messagebus_t bus;
 extern parameter_namespace_t parameter_root;
+#endif
 
 #ifdef __cplusplus
 }
@@ -130,6 +130,14 @@
 #define STM32_EXT_EXTI21_IRQ_PRIORITY       15
 #define STM32_EXT_EXTI22_IRQ_PRIORITY       15
 
+/*
+ * Tickless mode switch.
+ * Define EPUCK_TICKLESS to run the kernel without periodic tick (see chconf.h).
+ * The system timer is then TIM5 (32 bits), which is taken from the PWM driver
+ *  (see the ST driver settings, checked in halconf.h).
+ */
+//#define EPUCK_TICKLESS
+
 /*
  * GPT driver system settings.
  */
@@ -216,7 +224,11 @@
 #define STM32_PWM_USE_TIM2                  TRUE
 #define STM32_PWM_USE_TIM3                  TRUE
 #define STM32_PWM_USE_TIM4                  TRUE
+#if defined(EPUCK_TICKLESS)
+#define STM32_PWM_USE_TIM5                  FALSE
+#else
 #define STM32_PWM_USE_TIM5                  TRUE
+#endif
 #define STM32_PWM_USE_TIM8                  FALSE
 #define STM32_PWM_USE_TIM9                  FALSE
 #define STM32_PWM_TIM1_IRQ_PRIORITY         7
@@ -276,9 +288,14 @@
 
 /*
  * ST driver system settings.
+ * The timer is only used in tickless mode, TIM2 to TIM4 are used by the PWM driver.
  */
 #define STM32_ST_IRQ_PRIORITY               8
+#if defined(EPUCK_TICKLESS)
+#define STM32_ST_USE_TIMER                  5
+#else
 #define STM32_ST_USE_TIMER                  2
+#endif
 
 /*
  * UART driver system settings.
@@ -0,0 +1,632 @@
+/**
+ * @file	ColorTrain.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which trains the colors of the floor on labelled images of ImageReceiver
+ * 			 and writes the lookup table of classify_row() (DataProcess.c) as a header on stdout,
+ * 			 used by ProcessImage with COLOR_CLASSIFIER TRUE (DataAcquisition.h).
+ * 			A pixel is quantised to COLOR_LUT_BITS bits per color, the table gives the colors
+ * 			 of every quantised pixel, fitted on the pixels of the rows around the color row:
+ * 				centroid:	nearest mean of the colors of the floor
+ * 				tree:		decision tree on the quantised red, green and blue (Gini), depth -d
+ * 			One image out of -t of each color isn't trained and tests the table, the accuracy of the pixels
+ * 			 and of the rows (colors of ProcessImage) is written on stderr with the threshold
+ * 			 of extract_color() as reference, then the cost of a row on the host.
+ * 			Labels: one line per image "<file.ppm>,<color>[,<row>]", colors black, blue, green,
+ * 			 cyan, red, magenta, yellow or white, row IMAGE_COLOR_ROW by default.
+ *
+ * 			Build:	make ColorTrain		(gcc -O2 -DHOST_BUILD -I.. -Ihost -o ColorTrain ColorTrain.c ../DataProcess.c)
+ * 			Usage:	./ImageReceiver -n 40 venue < /dev/ttyACM0			(images of every color)
+ * 					./ColorTrain [-m centroid|tree] [-d depth] [-r rows] [-t share] labels.csv > ../ColorLut.h
+ * 					make lut											(labels.csv of the makefile)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <leds.h>
+
+#include <main.h>
+#include <DataAcquisition.h>
+#include <DataProcess.h>
+#include <ImageStream.h>
+
+// Training define
+#define NB_CLASSES			8		// combinations of bits 4 to 6 of ActualCell
+#define LEVELS				(1 << COLOR_LUT_BITS)	// values of a quantised color
+#define MAX_IMAGES			1024
+#define MAX_LINE			256
+#define MAX_WIDTH			640		// in [pixels]
+#define MAX_SPAN			8		// rows trained on each side of the color row
+#define DEFAULT_SPAN		2
+#define MAX_DEPTH			12
+#define DEFAULT_DEPTH		6
+#define MIN_SPLIT			20		// pixels of a node of the tree, fewer --> leaf
+#define DEFAULT_TEST_SHARE	5		// one image out of 5 tests the table, 0 --> none
+// Cost define
+#define BENCH_ROWS			200000	// rows classified to time a row
+
+enum train_model_e{
+	MODEL_CENTROID,
+	MODEL_TREE
+};
+
+
+/*** STATIC VARIABLES ***/
+typedef struct train_image_s{
+	char Name[MAX_LINE];
+	uint8_t Class;			// colors of the floor >> BLUE_BIT
+	uint8_t Test;			// 1 --> not trained
+	uint16_t Width;			// in [pixels]
+	uint8_t NbRows;
+	uint8_t* Rows;			// RGB565, two bytes per pixel, the color row in the middle
+} train_image_t;
+
+// Region of the quantised colors, bounds included
+typedef struct train_box_s{
+	uint8_t Lo[3];
+	uint8_t Hi[3];
+} train_box_t;
+
+static const char* ClassName[NB_CLASSES] = {"black", "blue", "green", "cyan", "red", "magenta", "yellow", "white"};
+
+static train_image_t Image[MAX_IMAGES];
+static uint16_t NbImages = 0;
+static uint32_t Histogram[COLOR_LUT_SIZE][NB_CLASSES];	// trained pixels per quantised color
+static uint8_t ColorLut[COLOR_LUT_SIZE];
+static uint8_t MaxDepth = DEFAULT_DEPTH;
+static uint16_t NbLeaves = 0;
+
+
+/*** FIRMWARE FUNCTIONS ***/
+// Actions of DataProcess.c, nothing to drive on the host
+
+void set_led(led_name_t led_number, unsigned int value){
+	(void)led_number;
+	(void)value;
+}
+
+void set_rgb_led(rgb_led_name_t led_number, uint8_t red_val, uint8_t green_val, uint8_t blue_val){
+	(void)led_number;
+	(void)red_val;
+	(void)green_val;
+	(void)blue_val;
+}
+
+void set_body_led(unsigned int value){
+	(void)value;
+}
+
+void set_front_led(unsigned int value){
+	(void)value;
+}
+
+void turn(int16_t AngleVal){
+	(void)AngleVal;
+}
+
+int16_t motor_wait_ready(void){
+	return 0;
+}
+
+void correction_nominal_speed(int16_t SpeedCorrection){
+	(void)SpeedCorrection;
+}
+
+int32_t param_get(uint8_t Id){
+	(void)Id;
+	return 0;
+}
+
+/*** END FIRMWARE FUNCTIONS ***/
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Reads the next number of the header of a PPM image, after the comments.
+ *
+ * @return	1 if read, 0 otherwise
+ */
+static uint8_t read_ppm_number(FILE* File, unsigned* Value){
+	int Char;
+
+	while((Char = fgetc(File)) != EOF){
+		if(Char == '#'){
+			while(((Char = fgetc(File)) != EOF) && (Char != '\n'));
+		}else if((Char != ' ') && (Char != '\t') && (Char != '\r') && (Char != '\n')){
+			ungetc(Char, File);
+			return fscanf(File, "%u", Value) == 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief	Loads the rows around the color row of a PPM image (P6) in RGB565,
+ * 			 as sent by the camera to ProcessImage.
+ *
+ * @return	1 if valid, 0 otherwise
+ */
+static uint8_t load_image(train_image_t* Train, unsigned ColorRow, uint8_t Span){
+	FILE* File = fopen(Train->Name, "rb");
+	uint8_t Pixel[3 * MAX_WIDTH];
+	unsigned Width, Height, MaxVal;
+	unsigned First, Last;
+	uint8_t* Out;
+
+	if(File == NULL){
+		perror(Train->Name);
+		return 0;
+	}
+	if((fgetc(File) != 'P') || (fgetc(File) != '6') || !read_ppm_number(File, &Width)
+			|| !read_ppm_number(File, &Height) || !read_ppm_number(File, &MaxVal)
+			|| (MaxVal != 255) || !Width || (Width > MAX_WIDTH) || (ColorRow >= Height)){
+		fprintf(stderr, "%s: not a P6 image of at most %u pixels of 8 bits with row %u\n", Train->Name, MAX_WIDTH, ColorRow);
+		fclose(File);
+		return 0;
+	}
+	fgetc(File);	// single whitespace before the pixels
+
+	First = (ColorRow > Span) ? ColorRow - Span : 0;
+	Last = (ColorRow + Span < Height) ? ColorRow + Span : Height - 1;
+	Train->Width = Width;
+	Train->NbRows = Last - First + 1;
+	Train->Rows = malloc(2 * Width * Train->NbRows);
+	if(Train->Rows == NULL){
+		perror("malloc");
+		fclose(File);
+		return 0;
+	}
+
+	Out = Train->Rows;
+	for(unsigned Row = 0 ; Row <= Last ; Row++){
+		if(fread(Pixel, 3, Width, File) != Width){
+			fprintf(stderr, "%s: truncated image\n", Train->Name);
+			fclose(File);
+			return 0;
+		}
+		if(Row < First){
+			continue;
+		}
+		// RGB888 --> RGB565, big endian as in the buffer of the camera
+		for(unsigned i = 0 ; i < Width ; i++){
+			*Out++ = (Pixel[3*i] & 0xF8) | (Pixel[3*i+1] >> 5);
+			*Out++ = ((Pixel[3*i+1] << 3) & 0xE0) | (Pixel[3*i+2] >> 3);
+		}
+	}
+	fclose(File);
+	return 1;
+}
+
+/**
+ * @brief	Reads the labels "<file.ppm>,<color>[,<row>]" and loads the images.
+ *
+ * @return	1 if all the images are valid, 0 otherwise
+ */
+static uint8_t load_labels(const char* Name, uint8_t Span, uint8_t TestShare){
+	FILE* Labels = fopen(Name, "r");
+	char Line[MAX_LINE];
+	char Color[MAX_LINE];
+	uint16_t PerClass[NB_CLASSES] = {0};	// images of each color, the test images are spread over the colors
+	unsigned ColorRow, LineNb = 0;
+	uint8_t Class;
+	int NbRead;
+
+	if(Labels == NULL){
+		perror(Name);
+		return 0;
+	}
+	while(fgets(Line, sizeof(Line), Labels)){
+		LineNb++;
+		if((Line[0] == '#') || (Line[0] == '\n') || (Line[0] == '\r')){
+			continue;
+		}
+		if(NbImages == MAX_IMAGES){
+			fprintf(stderr, "%s: more than %u images\n", Name, MAX_IMAGES);
+			fclose(Labels);
+			return 0;
+		}
+
+		ColorRow = IMAGE_COLOR_ROW;
+		NbRead = sscanf(Line, "%255[^,],%255[^,\r\n],%u", Image[NbImages].Name, Color, &ColorRow);
+		for(Class = 0 ; (NbRead >= 2) && (Class < NB_CLASSES) ; Class++){
+			if(!strcmp(Color, ClassName[Class])){
+				break;
+			}
+		}
+		if((NbRead < 2) || (Class == NB_CLASSES)){
+			fprintf(stderr, "%s:%u: expected <file.ppm>,<color>[,<row>]\n", Name, LineNb);
+			fclose(Labels);
+			return 0;
+		}
+
+		Image[NbImages].Class = Class;
+		Image[NbImages].Test = TestShare && ((PerClass[Class]++ % TestShare) == (unsigned)(TestShare - 1));
+		if(!load_image(&Image[NbImages], ColorRow, Span)){
+			fclose(Labels);
+			return 0;
+		}
+		NbImages++;
+	}
+	fclose(Labels);
+
+	if(!NbImages){
+		fprintf(stderr, "%s: no image\n", Name);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief	Adds the pixels of the trained images to the histogram of the quantised colors.
+ *
+ * @return	Number of trained pixels
+ */
+static uint32_t fill_histogram(void){
+	uint32_t NbPixels = 0;
+
+	for(uint16_t n = 0 ; n < NbImages ; n++){
+		if(Image[n].Test){
+			continue;
+		}
+		for(uint32_t i = 0 ; i < 2u * Image[n].Width * Image[n].NbRows ; i+=2){
+			Histogram[color_lut_index(Image[n].Rows[i], Image[n].Rows[i+1])][Image[n].Class]++;
+			NbPixels++;
+		}
+	}
+	return NbPixels;
+}
+
+/**
+ * @brief	Returns the quantised red (0), green (1) or blue (2) of an index of the table.
+ */
+static uint8_t lut_channel(uint16_t Index, uint8_t Channel){
+	return (Index >> ((2 - Channel) * COLOR_LUT_BITS)) & (LEVELS - 1);
+}
+
+/**
+ * @brief	Nearest centroid: every quantised color takes the class with the closest mean.
+ */
+static void train_centroid(void){
+	double Sum[NB_CLASSES][3] = {{0}};
+	double Count[NB_CLASSES] = {0};
+	double Distance, Best, Delta;
+
+	for(uint16_t Index = 0 ; Index < COLOR_LUT_SIZE ; Index++){
+		for(uint8_t c = 0 ; c < NB_CLASSES ; c++){
+			for(uint8_t Channel = 0 ; Channel < 3 ; Channel++){
+				Sum[c][Channel] += Histogram[Index][c] * (lut_channel(Index, Channel) + 0.5);
+			}
+			Count[c] += Histogram[Index][c];
+		}
+	}
+
+	for(uint16_t Index = 0 ; Index < COLOR_LUT_SIZE ; Index++){
+		Best = -1;
+		for(uint8_t c = 0 ; c < NB_CLASSES ; c++){
+			if(!Count[c]){
+				continue;
+			}
+			Distance = 0;
+			for(uint8_t Channel = 0 ; Channel < 3 ; Channel++){
+				Delta = lut_channel(Index, Channel) + 0.5 - Sum[c][Channel] / Count[c];
+				Distance += Delta * Delta;
+			}
+			if((Best < 0) || (Distance < Best)){
+				Best = Distance;
+				ColorLut[Index] = c << BLUE_BIT;
+			}
+		}
+	}
+	NbLeaves = 0;
+	for(uint8_t c = 0 ; c < NB_CLASSES ; c++){
+		NbLeaves += (Count[c] > 0);
+	}
+}
+
+/**
+ * @brief	Grows a node of the decision tree over a box of the quantised colors,
+ * 			 split on the threshold of one color with the lowest Gini impurity.
+ * 			A leaf sets its class in the table for the whole box.
+ */
+static void grow_tree(const train_box_t* Box, uint8_t Depth, uint8_t ParentClass){
+	uint32_t Margin[3][LEVELS][NB_CLASSES] = {{{0}}};
+	uint32_t Total[NB_CLASSES] = {0};
+	uint32_t Left[NB_CLASSES];
+	uint32_t NbPixels = 0, NbLeft;
+	uint8_t Class = ParentClass;
+	uint8_t Split = 0, SplitChannel = 0, SplitLevel = 0;
+	double Score, BestScore = 0, SumLeft, SumRight;
+	uint16_t Index;
+	train_box_t Side;
+
+	for(uint8_t Red = Box->Lo[0] ; Red <= Box->Hi[0] ; Red++){
+		for(uint8_t Green = Box->Lo[1] ; Green <= Box->Hi[1] ; Green++){
+			for(uint8_t Blue = Box->Lo[2] ; Blue <= Box->Hi[2] ; Blue++){
+				Index = (Red << (2 * COLOR_LUT_BITS)) | (Green << COLOR_LUT_BITS) | Blue;
+				for(uint8_t c = 0 ; c < NB_CLASSES ; c++){
+					Margin[0][Red][c] += Histogram[Index][c];
+					Margin[1][Green][c] += Histogram[Index][c];
+					Margin[2][Blue][c] += Histogram[Index][c];
+					Total[c] += Histogram[Index][c];
+				}
+			}
+		}
+	}
+
+	// Majority of the box, the class of the parent if the box is empty
+	for(uint8_t c = 0 ; c < NB_CLASSES ; c++){
+		NbPixels += Total[c];
+		BestScore += (double)Total[c] * Total[c];
+		if(Total[c] > Total[Class]){
+			Class = c;
+		}
+	}
+
+	// Sum of (pixels of a class)^2 / pixels of the side, the highest --> lowest impurity
+	if((Depth < MaxDepth) && (NbPixels >= MIN_SPLIT) && (Total[Class] < NbPixels)){
+		BestScore /= NbPixels;
+		for(uint8_t Channel = 0 ; Channel < 3 ; Channel++){
+			memset(Left, 0, sizeof(Left));
+			NbLeft = 0;
+			for(uint8_t Level = Box->Lo[Channel] ; Level < Box->Hi[Channel] ; Level++){
+				SumLeft = 0;
+				SumRight = 0;
+				for(uint8_t c = 0 ; c < NB_CLASSES ; c++){
+					Left[c] += Margin[Channel][Level][c];
+					NbLeft += Margin[Channel][Level][c];
+					SumLeft += (double)Left[c] * Left[c];
+					SumRight += (double)(Total[c] - Left[c]) * (Total[c] - Left[c]);
+				}
+				if(!NbLeft || (NbLeft == NbPixels)){
+					continue;
+				}
+				Score = SumLeft / NbLeft + SumRight / (NbPixels - NbLeft);
+				if(Score > BestScore * (1 + 1e-9)){
+					BestScore = Score;
+					Split = 1;
+					SplitChannel = Channel;
+					SplitLevel = Level;
+				}
+			}
+		}
+	}
+
+	if(!Split){
+		for(uint8_t Red = Box->Lo[0] ; Red <= Box->Hi[0] ; Red++){
+			for(uint8_t Green = Box->Lo[1] ; Green <= Box->Hi[1] ; Green++){
+				for(uint8_t Blue = Box->Lo[2] ; Blue <= Box->Hi[2] ; Blue++){
+					ColorLut[(Red << (2 * COLOR_LUT_BITS)) | (Green << COLOR_LUT_BITS) | Blue] = Class << BLUE_BIT;
+				}
+			}
+		}
+		NbLeaves++;
+		return;
+	}
+
+	Side = *Box;
+	Side.Hi[SplitChannel] = SplitLevel;
+	grow_tree(&Side, Depth + 1, Class);
+	Side = *Box;
+	Side.Lo[SplitChannel] = SplitLevel + 1;
+	grow_tree(&Side, Depth + 1, Class);
+}
+
+/**
+ * @brief	Decision tree over all the quantised colors.
+ */
+static void train_tree(void){
+	train_box_t Box = {{0, 0, 0}, {LEVELS - 1, LEVELS - 1, LEVELS - 1}};
+
+	NbLeaves = 0;
+	grow_tree(&Box, 0, 0);
+}
+
+/**
+ * @brief	Accuracy of the table and of the threshold on the images of a set,
+ * 			 written on stderr with the confusion of the rows.
+ *
+ * @return	Accuracy of the rows with the table in [%]
+ */
+static double evaluate(uint8_t Test, double* PixelAccuracy, double* ThresholdAccuracy){
+	unsigned long Confusion[NB_CLASSES][NB_CLASSES] = {{0}};
+	unsigned long NbPixels = 0, GoodPixels = 0;
+	unsigned long NbRows = 0, GoodRows = 0, GoodThreshold = 0;
+	unsigned long SumConfidence = 0, NbLabelled;
+	uint32_t RedVal, GreenVal, BlueVal;
+	const uint8_t* Row;
+	uint8_t Color, Confidence;
+
+	for(uint16_t n = 0 ; n < NbImages ; n++){
+		if(Image[n].Test != Test){
+			continue;
+		}
+		for(uint8_t r = 0 ; r < Image[n].NbRows ; r++){
+			Row = Image[n].Rows + 2 * Image[n].Width * r;
+			for(uint16_t i = 0 ; i < 2 * Image[n].Width ; i+=2){
+				GoodPixels += (ColorLut[color_lut_index(Row[i], Row[i+1])] >> BLUE_BIT) == Image[n].Class;
+			}
+			NbPixels += Image[n].Width;
+
+			// Colors of ProcessImage, from the whole row
+			Color = classify_row(Row, Image[n].Width, ColorLut, &Confidence);
+			Confusion[Image[n].Class][Color >> BLUE_BIT]++;
+			GoodRows += (Color >> BLUE_BIT) == Image[n].Class;
+			SumConfidence += Confidence;
+
+			sum_row_colors(Row, Image[n].Width, &RedVal, &GreenVal, &BlueVal);
+			GoodThreshold += (extract_color(&RedVal, &GreenVal, &BlueVal, COLOR_THRESHOLD) >> BLUE_BIT) == Image[n].Class;
+			NbRows++;
+		}
+	}
+
+	fprintf(stderr, "%s: %lu rows, confidence %.1f %%\n", Test ? "test" : "training", NbRows,
+			(double)SumConfidence / NbRows);
+	fprintf(stderr, "%-8s", "label");
+	for(uint8_t c = 0 ; c < NB_CLASSES ; c++){
+		fprintf(stderr, " %7s", ClassName[c]);
+	}
+	fprintf(stderr, "\n");
+	for(uint8_t c = 0 ; c < NB_CLASSES ; c++){
+		NbLabelled = 0;
+		for(uint8_t k = 0 ; k < NB_CLASSES ; k++){
+			NbLabelled += Confusion[c][k];
+		}
+		if(!NbLabelled){
+			continue;
+		}
+		fprintf(stderr, "%-8s", ClassName[c]);
+		for(uint8_t k = 0 ; k < NB_CLASSES ; k++){
+			fprintf(stderr, " %7lu", Confusion[c][k]);
+		}
+		fprintf(stderr, "\n");
+	}
+
+	*PixelAccuracy = 100.0 * GoodPixels / NbPixels;
+	*ThresholdAccuracy = 100.0 * GoodThreshold / NbRows;
+	return 100.0 * GoodRows / NbRows;
+}
+
+/**
+ * @brief	Time of one row of the images with the table and with the threshold, on the host.
+ */
+static void measure_cost(double* LutNs, double* ThresholdNs){
+	struct timespec Start, End;
+	volatile uint8_t Sink = 0;
+	uint32_t RedVal, GreenVal, BlueVal;
+	const train_image_t* Train;
+	uint8_t Confidence;
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for(uint32_t n = 0 ; n < BENCH_ROWS ; n++){
+		Train = &Image[n % NbImages];
+		Sink += classify_row(Train->Rows, Train->Width, ColorLut, &Confidence);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	*LutNs = ((End.tv_sec - Start.tv_sec) * 1e9 + (End.tv_nsec - Start.tv_nsec)) / BENCH_ROWS;
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for(uint32_t n = 0 ; n < BENCH_ROWS ; n++){
+		Train = &Image[n % NbImages];
+		sum_row_colors(Train->Rows, Train->Width, &RedVal, &GreenVal, &BlueVal);
+		Sink += extract_color(&RedVal, &GreenVal, &BlueVal, COLOR_THRESHOLD);
+		Sink += color_confidence(RedVal, GreenVal, BlueVal, COLOR_THRESHOLD);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	*ThresholdNs = ((End.tv_sec - Start.tv_sec) * 1e9 + (End.tv_nsec - Start.tv_nsec)) / BENCH_ROWS;
+	(void)Sink;
+}
+
+/**
+ * @brief	Writes the table as the header ColorLut.h of the firmware.
+ */
+static void write_header(FILE* Out, const char* Model, uint32_t NbPixels, uint16_t NbTrained, double RowAccuracy, double ThresholdAccuracy){
+	fprintf(Out, "/**\n"
+			" * @file\tColorLut.h\n"
+			" *\n"
+			" * @brief\tColors of the quantised pixels for classify_row(), used with COLOR_CLASSIFIER TRUE.\n"
+			" * \t\t\tGenerated by tools/ColorTrain, trained again for a new floor or light.\n"
+			" * \t\t\tModel: %s (%u leaves), %u pixels of %u images\n"
+			" * \t\t\tRows: %.1f %% right (threshold %.1f %%)\n"
+			" */\n\n"
+			"#ifndef COLORLUT_H_\n"
+			"#define COLORLUT_H_\n\n"
+			"// Bits 4 to 6 of ActualCell, index from color_lut_index()\n"
+			"static const uint8_t ColorLut[COLOR_LUT_SIZE] = {\n",
+			Model, NbLeaves, NbPixels, NbTrained, RowAccuracy, ThresholdAccuracy);
+	for(uint16_t Index = 0 ; Index < COLOR_LUT_SIZE ; Index++){
+		fprintf(Out, "%s0x%02X%s", (Index % LEVELS) ? " " : "\t", ColorLut[Index],
+				(Index == COLOR_LUT_SIZE - 1) ? "\n" : (((Index % LEVELS) == LEVELS - 1) ? ",\n" : ","));
+	}
+	fprintf(Out, "};\n\n#endif /* COLORLUT_H_ */\n");
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** MAIN ***/
+int main(int argc, char* argv[]){
+	uint8_t Model = MODEL_TREE;
+	unsigned Span = DEFAULT_SPAN;
+	unsigned TestShare = DEFAULT_TEST_SHARE;
+	unsigned Depth = DEFAULT_DEPTH;
+	uint16_t NbTrained = 0, NbTested = 0;
+	uint32_t NbPixels;
+	double RowAccuracy, PixelAccuracy, ThresholdAccuracy, LutNs, ThresholdNs;
+	char ModelName[32];
+	int Option, Valid = 1;
+
+	while((Option = getopt(argc, argv, "m:d:r:t:")) != -1){
+		switch (Option) {
+		case 'm':
+			if(!strcmp(optarg, "centroid")){
+				Model = MODEL_CENTROID;
+			}else if(!strcmp(optarg, "tree")){
+				Model = MODEL_TREE;
+			}else{
+				Valid = 0;
+			}
+			break;
+		case 'd':
+			Depth = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			Span = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			TestShare = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			Valid = 0;
+			break;
+		}
+	}
+	if(!Valid || (optind != argc - 1) || (Depth < 1) || (Depth > MAX_DEPTH) || (Span > MAX_SPAN) || (TestShare == 1) || (TestShare > MAX_IMAGES)){
+		fprintf(stderr, "usage: %s [-m centroid|tree] [-d depth 1-%u] [-r rows 0-%u] [-t share, 0 or 2-%u] labels.csv > ColorLut.h\n",
+				argv[0], MAX_DEPTH, MAX_SPAN, MAX_IMAGES);
+		return 1;
+	}
+	MaxDepth = Depth;
+
+	if(!load_labels(argv[optind], Span, TestShare)){
+		return 1;
+	}
+	for(uint16_t n = 0 ; n < NbImages ; n++){
+		NbTested += Image[n].Test;
+	}
+	NbTrained = NbImages - NbTested;
+
+	NbPixels = fill_histogram();
+	if(Model == MODEL_CENTROID){
+		train_centroid();
+		snprintf(ModelName, sizeof(ModelName), "nearest centroid");
+	}else{
+		train_tree();
+		snprintf(ModelName, sizeof(ModelName), "tree of depth %u", Depth);
+	}
+	fprintf(stderr, "%s, %u leaves, %u pixels of %u images\n", ModelName, NbLeaves, NbPixels, NbTrained);
+
+	RowAccuracy = evaluate(0, &PixelAccuracy, &ThresholdAccuracy);
+	fprintf(stderr, "training: pixels %.1f %%, rows %.1f %%, threshold %.1f %%\n", PixelAccuracy, RowAccuracy, ThresholdAccuracy);
+	// Without images to test, the header gives the accuracy of the training
+	if(NbTested){
+		RowAccuracy = evaluate(1, &PixelAccuracy, &ThresholdAccuracy);
+		fprintf(stderr, "test: pixels %.1f %%, rows %.1f %%, threshold %.1f %%\n", PixelAccuracy, RowAccuracy, ThresholdAccuracy);
+	}else{
+		fprintf(stderr, "no image to test, accuracy of the training in the header\n");
+	}
+
+	measure_cost(&LutNs, &ThresholdNs);
+	fprintf(stderr, "cost of a row of %u pixels: table %.0f ns, threshold %.0f ns (host), table of %u bytes\n",
+			Image[0].Width, LutNs, ThresholdNs, COLOR_LUT_SIZE);
+
+	write_header(stdout, ModelName, NbPixels, NbTrained, RowAccuracy, ThresholdAccuracy);
+	return 0;
+}
+/*** END MAIN ***/
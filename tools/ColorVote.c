@@ -0,0 +1,316 @@
+/**
+ * @file	ColorVote.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which measures the vote of the colors of ProcessImage (vote_color()
+ * 			 of DataProcess.c) on the frames of recorded telemetry streams (TLM_COLOR),
+ * 			 for every window and minimum confidence: false actions against latency.
+ * 			The colors are computed again from the sums with the threshold of the stream
+ * 			 (as recorded with COLOR_CLASSIFIER, the pixels aren't in the stream).
+ * 			The reference of a frame is the last color kept by at least STABLE_FRAMES
+ * 			 frames in a row, shorter runs are misclassifications (edges of the cells).
+ * 				changes:		changes of the saved color
+ * 				false_actions:	saved color (red, green, blue) being neither the reference
+ * 								 nor the next stable color, a floor action by mistake
+ * 				missed:			stable colors never saved
+ * 				latency:		first frame of a stable color --> color saved, in frames and [ms]
+ *
+ * 			Build:	make ColorVote		(gcc -O2 -DHOST_BUILD -I.. -Ihost -o ColorVote ColorVote.c ../DataProcess.c)
+ * 			Usage:	cat /dev/ttyACM0 > run1.bin								(record on the floor)
+ * 					./ColorVote run1.bin [run2.bin ...] > vote.csv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <leds.h>
+
+#include <main.h>
+#include <Telemetry.h>
+#include <SystemControl.h>
+#include <DataAcquisition.h>
+#include <DataProcess.h>
+#include <MazeParameters.h>
+
+// Reference define
+#define STABLE_FRAMES		8		// frames of the same color in a row --> real color of the floor
+#define MAX_STREAMS			16
+// Sweep define
+#define NB_CONFIDENCES		5
+static const uint8_t Confidences[NB_CONFIDENCES] = {0, 2, 5, 10, 20};	// in [%]
+
+
+/*** STATIC VARIABLES ***/
+typedef struct vote_frame_s{
+	uint32_t Time;			// in [ms], system ticks of 1 ms
+	uint8_t Color;			// colors of the frame alone
+	uint8_t Confidence;		// in [%]
+	uint8_t Reference;		// last stable color
+	uint8_t Next;			// next stable color
+} vote_frame_t;
+
+typedef struct vote_stream_s{
+	vote_frame_t* Frame;
+	uint32_t NbFrames;
+} vote_stream_t;
+
+typedef struct vote_stat_s{
+	unsigned long Changes;
+	unsigned long FalseActions;
+	unsigned long Missed;
+	unsigned long NbLatencies;
+	unsigned long LatencyFrames;	// sum
+	unsigned long MaxLatencyFrames;
+	unsigned long LatencyMs;		// sum
+} vote_stat_t;
+
+static vote_stream_t Stream[MAX_STREAMS];
+static uint8_t NbStreams = 0;
+
+
+/*** FIRMWARE FUNCTIONS ***/
+// Actions of DataProcess.c, nothing to drive on the host
+
+void set_led(led_name_t led_number, unsigned int value){
+	(void)led_number;
+	(void)value;
+}
+
+void set_rgb_led(rgb_led_name_t led_number, uint8_t red_val, uint8_t green_val, uint8_t blue_val){
+	(void)led_number;
+	(void)red_val;
+	(void)green_val;
+	(void)blue_val;
+}
+
+void set_body_led(unsigned int value){
+	(void)value;
+}
+
+void set_front_led(unsigned int value){
+	(void)value;
+}
+
+void turn(int16_t AngleVal){
+	(void)AngleVal;
+}
+
+int16_t motor_wait_ready(void){
+	return 0;
+}
+
+void correction_nominal_speed(int16_t SpeedCorrection){
+	(void)SpeedCorrection;
+}
+
+int32_t param_get(uint8_t Id){
+	(void)Id;
+	return 0;
+}
+
+/*** END FIRMWARE FUNCTIONS ***/
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Reads the frames of a telemetry stream, with the resynchronisation of TelemetryDecoder.
+ *
+ * @return	1 if the stream has frames, 0 otherwise
+ */
+static uint8_t load_stream(const char* Name, vote_stream_t* Frames){
+	tlm_record_t Record;
+	uint8_t* Window = (uint8_t*)&Record;
+	size_t Filled = 0;
+	uint32_t Capacity = 0;
+	int32_t Threshold = COLOR_THRESHOLD;
+	FILE* Input = fopen(Name, "rb");
+	int Byte;
+
+	if(Input == NULL){
+		perror(Name);
+		return 0;
+	}
+
+	while((Byte = fgetc(Input)) != EOF){
+		Window[Filled++] = (uint8_t)Byte;
+
+		if((Filled >= 2) && ((Record.Sync != TLM_SYNC) || (Record.Type == 0) || (Record.Type >= TLM_NB_TYPES))){
+			memmove(Window, Window + 1, --Filled);
+			while(Filled && (Window[0] != TLM_SYNC)){
+				memmove(Window, Window + 1, --Filled);
+			}
+			continue;
+		}
+		if(Filled < sizeof(tlm_record_t)){
+			continue;
+		}
+		Filled = 0;
+
+		// Data of a block of the image stream isn't a record
+		if(Record.Type == TLM_IMAGE){
+			for(uint16_t Length = ((const tlm_image_t*)Record.Payload)->Length ; Length && (fgetc(Input) != EOF) ; Length--){
+			}
+			continue;
+		}
+
+		if(Record.Type == TLM_PARAM){
+			const tlm_param_t* Data = (const void*)Record.Payload;
+			if((Data->Result == PARAM_ACCEPTED) && (Data->Id == PARAM_COLOR_THRESHOLD)){
+				Threshold = Data->Value;
+			}
+		}else if(Record.Type == TLM_COLOR){
+			const tlm_color_t* Data = (const void*)Record.Payload;
+			if(Frames->NbFrames == Capacity){
+				Capacity = Capacity ? 2 * Capacity : 1024;
+				Frames->Frame = realloc(Frames->Frame, Capacity * sizeof(vote_frame_t));
+				if(Frames->Frame == NULL){
+					perror("realloc");
+					fclose(Input);
+					return 0;
+				}
+			}
+			Frames->Frame[Frames->NbFrames].Time = Record.Time;
+#if COLOR_CLASSIFIER == TRUE
+			// Pixels not recorded --> colors of the frame as recorded
+			Frames->Frame[Frames->NbFrames].Color = Data->Color;
+			Frames->Frame[Frames->NbFrames].Confidence = Data->Confidence;
+			(void)Threshold;
+#else
+			uint32_t RedVal = Data->RedVal;
+			uint32_t GreenVal = Data->GreenVal;
+			uint32_t BlueVal = Data->BlueVal;
+			Frames->Frame[Frames->NbFrames].Color = extract_color(&RedVal, &GreenVal, &BlueVal, Threshold);
+			Frames->Frame[Frames->NbFrames].Confidence = color_confidence(RedVal, GreenVal, BlueVal, Threshold);
+#endif
+			Frames->NbFrames++;
+		}
+	}
+	fclose(Input);
+
+	if(!Frames->NbFrames){
+		fprintf(stderr, "%s: no TLM_COLOR record\n", Name);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief	Sets the last and the next stable color of every frame.
+ */
+static void set_references(vote_stream_t* Frames){
+	uint8_t Stable = Frames->Frame[0].Color;
+	uint32_t RunStart = 0;
+	uint32_t Last = 0;		// first frame without its next stable color
+
+	for(uint32_t i = 1 ; i <= Frames->NbFrames ; i++){
+		if((i < Frames->NbFrames) && (Frames->Frame[i].Color == Frames->Frame[RunStart].Color)){
+			continue;
+		}
+		// Run [RunStart, i[ long enough --> stable from its first frame
+		if((i - RunStart) >= STABLE_FRAMES){
+			for( ; Last < RunStart ; Last++){
+				Frames->Frame[Last].Next = Frames->Frame[RunStart].Color;
+			}
+			Stable = Frames->Frame[RunStart].Color;
+		}
+		for(uint32_t n = RunStart ; n < i ; n++){
+			Frames->Frame[n].Reference = Stable;
+		}
+		RunStart = i;
+	}
+	for( ; Last < Frames->NbFrames ; Last++){
+		Frames->Frame[Last].Next = Frames->Frame[Last].Reference;
+	}
+}
+
+/**
+ * @brief	Runs the vote over a stream and adds its results.
+ */
+static void evaluate(const vote_stream_t* Frames, uint8_t Window, uint8_t MinConfidence, vote_stat_t* Stat){
+	color_vote_t Vote;
+	const vote_frame_t* Frame;
+	uint8_t Saved, Previous = 0;
+	uint32_t StableStart = 0;
+	uint8_t Waiting = 0;	// stable color not saved yet
+
+	memset(&Vote, 0, sizeof(Vote));
+
+	for(uint32_t i = 0 ; i < Frames->NbFrames ; i++){
+		Frame = &Frames->Frame[i];
+		Saved = vote_color(&Vote, Frame->Color, Frame->Confidence, Window, MinConfidence);
+
+		// New stable color of the floor
+		if(i && (Frame->Reference != Frames->Frame[i-1].Reference)){
+			if(Waiting){
+				Stat->Missed++;
+			}
+			StableStart = i;
+			Waiting = (Saved != Frame->Reference);
+		}
+
+		if(Saved != Previous){
+			Stat->Changes++;
+			if(Saved && (Saved != Frame->Reference) && (Saved != Frame->Next)){
+				Stat->FalseActions++;
+			}
+		}
+
+		if(Waiting && (Saved == Frame->Reference)){
+			Waiting = 0;
+			Stat->NbLatencies++;
+			Stat->LatencyFrames += i - StableStart;
+			Stat->LatencyMs += Frame->Time - Frames->Frame[StableStart].Time;
+			if(i - StableStart > Stat->MaxLatencyFrames){
+				Stat->MaxLatencyFrames = i - StableStart;
+			}
+		}
+		Previous = Saved;
+	}
+	if(Waiting){
+		Stat->Missed++;
+	}
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** MAIN ***/
+int main(int argc, char* argv[]){
+	vote_stat_t Stat;
+	unsigned long NbFrames = 0;
+
+	if((argc < 2) || (argc - 1 > MAX_STREAMS)){
+		fprintf(stderr, "usage: %s <stream> ... (at most %u) > vote.csv\n", argv[0], MAX_STREAMS);
+		return 1;
+	}
+
+	for(int Arg = 1 ; Arg < argc ; Arg++){
+		if(!load_stream(argv[Arg], &Stream[NbStreams])){
+			return 1;
+		}
+		set_references(&Stream[NbStreams]);
+		NbFrames += Stream[NbStreams++].NbFrames;
+	}
+
+	printf("window,confidence,frames,changes,false_actions,missed,mean_latency_frames,max_latency_frames,mean_latency_ms\n");
+	for(uint8_t Window = 1 ; Window <= COLOR_MAX_WINDOW ; Window++){
+		for(uint8_t c = 0 ; c < NB_CONFIDENCES ; c++){
+			memset(&Stat, 0, sizeof(Stat));
+			for(uint8_t s = 0 ; s < NbStreams ; s++){
+				evaluate(&Stream[s], Window, Confidences[c], &Stat);
+			}
+			printf("%u,%u,%lu,%lu,%lu,%lu,%.2f,%lu,%.1f\n", Window, Confidences[c], NbFrames,
+					Stat.Changes, Stat.FalseActions, Stat.Missed,
+					Stat.NbLatencies ? (double)Stat.LatencyFrames / Stat.NbLatencies : 0,
+					Stat.MaxLatencyFrames,
+					Stat.NbLatencies ? (double)Stat.LatencyMs / Stat.NbLatencies : 0);
+		}
+	}
+
+	return 0;
+}
+/*** END MAIN ***/
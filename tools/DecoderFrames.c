@@ -0,0 +1,142 @@
+/**
+ * @file	DecoderFrames.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which writes a telemetry stream of TLM_THREAD, TLM_LOAD and TLM_PERIOD
+ * 			 records on stdout, assembled byte by byte from the layout documented in
+ * 			 Telemetry.h (little endian) and not from its structures: a change of the
+ * 			 layout of a record makes the decoder disagree with testdata/decoder_*.
+ * 			Two bytes of garbage before a record check the resynchronisation.
+ *
+ * 			Build:	make DecoderFrames
+ * 			Usage:	./DecoderFrames > decoder.bin
+ * 					./TelemetryDecoder decoder.bin decoder		(compared with testdata/ by make check)
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+// Layout define, as on the serial link
+#define FRAME_SYNC			0xA5	// TLM_SYNC
+#define FRAME_PAYLOAD		16		// in [bytes], TLM_PAYLOAD_SIZE
+#define FRAME_THREAD		7		// TLM_THREAD
+#define FRAME_LOAD			10		// TLM_LOAD
+#define FRAME_PERIOD		9		// TLM_PERIOD
+
+
+/*** STATIC VARIABLES ***/
+static uint8_t Payload[FRAME_PAYLOAD];
+static uint8_t Length = 0;
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+static void put8(uint8_t Value){
+	Payload[Length++] = Value;
+}
+
+static void put16(uint16_t Value){
+	put8(Value & 0xFF);
+	put8(Value >> 8);
+}
+
+static void put32(uint32_t Value){
+	put16(Value & 0xFFFF);
+	put16(Value >> 16);
+}
+
+/**
+ * @brief	Writes the header of a record: sync, type, sequence (16 bits), time (32 bits).
+ * 			The payload is then filled with put8(), put16() and put32().
+ */
+static void begin_frame(uint8_t Type, uint16_t Seq, uint32_t Time){
+	uint8_t Header[] = {FRAME_SYNC, Type, Seq & 0xFF, Seq >> 8,
+			Time & 0xFF, (Time >> 8) & 0xFF, (Time >> 16) & 0xFF, Time >> 24};
+
+	fwrite(Header, 1, sizeof(Header), stdout);
+	memset(Payload, 0, sizeof(Payload));
+	Length = 0;
+}
+
+/**
+ * @brief	Writes the payload of the record, padded with 0 to FRAME_PAYLOAD bytes.
+ */
+static void end_frame(void){
+	fwrite(Payload, 1, sizeof(Payload), stdout);
+}
+
+/**
+ * @brief	TLM_THREAD: name (8 characters), CPU share, unused stack, switches.
+ */
+static void thread_frame(uint16_t Seq, uint32_t Time, const char* Name, uint16_t CpuShare,
+		uint16_t UnusedStack, uint32_t Switches){
+	begin_frame(FRAME_THREAD, Seq, Time);
+	for(uint8_t i = 0 ; i < 8 ; i++){
+		put8((i < strlen(Name)) ? Name[i] : 0);
+	}
+	put16(CpuShare);
+	put16(UnusedStack);
+	put32(Switches);
+	end_frame();
+}
+
+/**
+ * @brief	TLM_LOAD: selector, reserved, idle share, wakeups, context switches, interrupts.
+ */
+static void load_frame(uint16_t Seq, uint32_t Time, uint8_t Selector, uint16_t IdleShare,
+		uint32_t Wakeups, uint32_t CtxSwitches, uint32_t Irqs){
+	begin_frame(FRAME_LOAD, Seq, Time);
+	put8(Selector);
+	put8(0);
+	put16(IdleShare);
+	put32(Wakeups);
+	put32(CtxSwitches);
+	put32(Irqs);
+	end_frame();
+}
+
+/**
+ * @brief	TLM_PERIOD: id, reserved, misses, min, max, mean and jitter in [10 us], count.
+ */
+static void period_frame(uint16_t Seq, uint32_t Time, uint8_t Id, uint16_t Misses, uint16_t Min,
+		uint16_t Max, uint16_t Mean, uint16_t Jitter, uint32_t Count){
+	begin_frame(FRAME_PERIOD, Seq, Time);
+	put8(Id);
+	put8(0);
+	put16(Misses);
+	put16(Min);
+	put16(Max);
+	put16(Mean);
+	put16(Jitter);
+	put32(Count);
+	end_frame();
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+
+/*** MAIN ***/
+int main(void){
+	const uint8_t Garbage[] = {0x00, 0x13};
+
+	// One report of MonitorThreads, a name of 8 characters isn't null terminated
+	thread_frame(1, 1000, "main", 125, 312, 4021);
+	thread_frame(2, 1000, "ControlMotor", 40, 96, 1000);
+	thread_frame(3, 1000, "idle", 800, 48, 1500);
+	load_frame(4, 1000, 0, 800, 1500, 3200, 2500);
+
+	fwrite(Garbage, 1, sizeof(Garbage), stdout);
+	load_frame(8, 2000, 5, 600, 2000, 4100, 3000);
+	load_frame(12, 3000, 5, 700, 1800, 3900, 2800);
+
+	// GetProximity 50 ms, a late period of 70 ms (over the 65.5 ms of 16 bits in [us])
+	period_frame(13, 3000, 1, 2, 499, 7000, 5000, 15, 199);
+
+	return 0;
+}
+/*** END MAIN ***/
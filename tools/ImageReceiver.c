@@ -0,0 +1,359 @@
+/**
+ * @file	ImageReceiver.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which receives the full images streamed by the e-puck (ImageStream.c)
+ * 			 and writes them as PPM files, with their metadata in a CSV file:
+ * 			 selector, ActualCell and pose in the maze map when the image was captured.
+ * 			Every chunk is acknowledged (IMAGE_ACK_KEY), the e-puck sends at most
+ * 			 IMAGE_CREDITS chunks ahead. The other records of the telemetry are ignored.
+ * 			The throughput is written every second and at the end on stderr.
+ * 			A stream saved with cat is decoded as well, without acknowledgements
+ * 			 (the e-puck stops streaming after IMAGE_ACK_TIMEOUT).
+ *
+ * 			Build:	make ImageReceiver
+ * 			Usage:	./ImageReceiver [-z] [-n frames] <device|stream> <prefix>
+ * 					./ImageReceiver -n 200 /dev/ttyACM0 run1		(run1_0001.ppm, ..., run1_frames.csv)
+ * 					./ImageReceiver -z /dev/ttyACM0 run1			(RLE, until Ctrl+C)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include <Telemetry.h>
+#include <ImageStream.h>
+
+// Report define
+#define REPORT_PERIOD		1.0		// in [s]
+
+
+/*** STATIC VARIABLES ***/
+// Image being received
+typedef struct rx_frame_s{
+	tlm_frame_t Info;
+	uint32_t Time;						// in [ms], system ticks of the e-puck
+	uint8_t Valid;						// TLM_FRAME received
+	uint8_t Received[IMAGE_NB_CHUNKS];
+	uint8_t Pixels[IMAGE_FRAME_SIZE];	// RGB565, big endian
+	unsigned long EncodedBytes;
+} rx_frame_t;
+
+typedef struct rx_stat_s{
+	unsigned long Frames;			// written
+	unsigned long Incomplete;		// chunk missing or bad
+	unsigned long Chunks;
+	unsigned long BadChunks;		// checksum or length
+	unsigned long LinkBytes;		// records and blocks
+	unsigned long ImageBytes;		// once decoded
+} rx_stat_t;
+
+static rx_frame_t Frame;
+static rx_stat_t Total, Period;
+static volatile sig_atomic_t Stop = 0;
+static int Device = -1;				// -1 for a saved stream
+static FILE* Metadata;
+static const char* Prefix;
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Ends the reception at the next record (Ctrl+C).
+ */
+static void stop_reception(int Signal){
+	(void)Signal;
+	Stop = 1;
+}
+
+/**
+ * @brief	Returns the time of the host in [s].
+ */
+static double now(void){
+	struct timespec Time;
+
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return Time.tv_sec + Time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief	Sends a command to the e-puck, if connected.
+ */
+static void send_key(char Key){
+	if((Device >= 0) && (write(Device, &Key, 1) != 1)){
+		perror("write");
+	}
+}
+
+/**
+ * @brief	Decodes (count, pixel high, pixel low) triplets.
+ *
+ * @return	1 if exactly Size bytes are decoded, 0 otherwise
+ */
+static uint8_t decode_rle(const uint8_t* Encoded, uint16_t Length, uint8_t* Raw, uint16_t Size){
+	uint16_t Out = 0;
+
+	if(Length % 3){
+		return 0;
+	}
+	for(uint16_t i = 0 ; i < Length ; i += 3){
+		if(!Encoded[i] || (Out + 2 * Encoded[i] > Size)){
+			return 0;
+		}
+		for(uint8_t n = 0 ; n < Encoded[i] ; n++){
+			Raw[Out++] = Encoded[i + 1];
+			Raw[Out++] = Encoded[i + 2];
+		}
+	}
+	return Out == Size;
+}
+
+/**
+ * @brief	Writes the image being received as a PPM file and its metadata,
+ * 			 or counts it as incomplete. The next image starts empty.
+ */
+static void end_frame(void){
+	char FileName[256];
+	FILE* Image;
+	uint8_t Complete = Frame.Valid;
+	uint8_t NbReceived = 0;
+	const uint8_t* Pixel;
+	uint8_t Red, Green, Blue;
+
+	for(uint8_t c = 0 ; c < IMAGE_NB_CHUNKS ; c++){
+		NbReceived += Frame.Received[c];
+	}
+	if(!Frame.Valid && !NbReceived){
+		return;
+	}
+	Complete &= (NbReceived == IMAGE_NB_CHUNKS);
+
+	if(!Complete){
+		Total.Incomplete++;
+		Period.Incomplete++;
+	}else{
+		snprintf(FileName, sizeof(FileName), "%s_%04u.ppm", Prefix, Frame.Info.Frame);
+		Image = fopen(FileName, "wb");
+		if(Image == NULL){
+			perror(FileName);
+		}else{
+			// RGB565 --> 8 bits per color, the low bits repeat the high ones
+			fprintf(Image, "P6\n%u %u\n255\n", IMAGE_FRAME_WIDTH, IMAGE_FRAME_HEIGHT);
+			for(uint32_t p = 0 ; p < IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT ; p++){
+				Pixel = &Frame.Pixels[2 * p];
+				Red = Pixel[0] >> 3;
+				Green = ((Pixel[0] & 0x07) << 3) | (Pixel[1] >> 5);
+				Blue = Pixel[1] & 0x1F;
+				fputc((Red << 3) | (Red >> 2), Image);
+				fputc((Green << 2) | (Green >> 4), Image);
+				fputc((Blue << 3) | (Blue >> 2), Image);
+			}
+			fclose(Image);
+
+			fprintf(Metadata, "%u,%u,%u,0x%02X,%u,%u,%u,%u,%u,%lu,%s\n", Frame.Info.Frame, (unsigned)Frame.Time,
+					Frame.Info.Selector, Frame.Info.Cell, Frame.Info.X, Frame.Info.Y, Frame.Info.Heading,
+					IMAGE_FRAME_WIDTH, IMAGE_FRAME_HEIGHT, Frame.EncodedBytes, FileName);
+			fflush(Metadata);
+			Total.Frames++;
+			Period.Frames++;
+		}
+	}
+
+	memset(&Frame, 0, sizeof(Frame));
+}
+
+/**
+ * @brief	Reads the data of a chunk, checks it and copies it in the image.
+ */
+static void receive_chunk(FILE* Input, const tlm_image_t* Header){
+	static uint8_t Data[IMAGE_CHUNK_SIZE];
+	uint16_t Checksum = 0;
+	uint8_t Valid;
+
+	if(fread(Data, 1, Header->Length, Input) != Header->Length){
+		return;
+	}
+	// Acknowledged even if bad, the e-puck goes on with the next one
+	send_key(IMAGE_ACK_KEY);
+	Total.Chunks++;
+	Period.Chunks++;
+	Total.LinkBytes += Header->Length;
+	Period.LinkBytes += Header->Length;
+
+	// Chunk of a new image --> its TLM_FRAME was lost
+	if(Frame.Valid ? (Header->Frame != Frame.Info.Frame) : (Header->Chunk == 0)){
+		end_frame();
+	}
+
+	for(uint16_t i = 0 ; i < Header->Length ; i++){
+		Checksum += Data[i];
+	}
+	Valid = (Checksum == Header->Checksum) && (Header->Chunk < IMAGE_NB_CHUNKS) && (Header->RawLength == IMAGE_CHUNK_SIZE);
+	if(Valid){
+		if(Header->Encoding == IMAGE_RLE){
+			Valid = decode_rle(Data, Header->Length, &Frame.Pixels[Header->Chunk * IMAGE_CHUNK_SIZE], IMAGE_CHUNK_SIZE);
+		}else{
+			Valid = (Header->Length == IMAGE_CHUNK_SIZE);
+			memcpy(&Frame.Pixels[Header->Chunk * IMAGE_CHUNK_SIZE], Data, IMAGE_CHUNK_SIZE);
+		}
+	}
+	if(!Valid){
+		Total.BadChunks++;
+		Period.BadChunks++;
+		return;
+	}
+
+	Frame.Received[Header->Chunk] = 1;
+	Frame.EncodedBytes += Header->Length;
+	Total.ImageBytes += IMAGE_CHUNK_SIZE;
+	Period.ImageBytes += IMAGE_CHUNK_SIZE;
+
+	if(Header->Chunk == IMAGE_NB_CHUNKS - 1){
+		end_frame();
+	}
+}
+
+/**
+ * @brief	Writes the throughput of a period on stderr.
+ */
+static void print_throughput(const char* Name, const rx_stat_t* Stat, double Duration){
+	fprintf(stderr, "%s: %lu images (%.1f/s), %lu incomplete, %lu/%lu bad chunks, %.1f kB/s on the link, %.1f kB/s of images",
+			Name, Stat->Frames, Stat->Frames / Duration, Stat->Incomplete, Stat->BadChunks, Stat->Chunks,
+			Stat->LinkBytes / Duration / 1000, Stat->ImageBytes / Duration / 1000);
+	if(Stat->ImageBytes){
+		fprintf(stderr, ", %.2f image bytes per link byte", (double)Stat->ImageBytes / Stat->LinkBytes);
+	}
+	fprintf(stderr, "\n");
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** MAIN ***/
+int main(int argc, char* argv[]){
+	tlm_record_t Record;
+	uint8_t* Window = (uint8_t*)&Record;
+	size_t Filled = 0;
+	unsigned long MaxFrames = 0;	// 0 --> until Ctrl+C or the end of the stream
+	uint8_t Rle = 0;
+	struct termios Tty;
+	char FileName[256];
+	double Start, LastReport;
+	FILE* Input;
+	int Byte, Option;
+
+	while((Option = getopt(argc, argv, "zn:")) != -1){
+		switch (Option) {
+		case 'z':
+			Rle = 1;
+			break;
+		case 'n':
+			MaxFrames = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			argc = 0;
+			break;
+		}
+	}
+	if(argc - optind != 2){
+		fprintf(stderr, "usage: %s [-z] [-n frames] <device|stream> <prefix>\n", argv[0]);
+		return 1;
+	}
+	Prefix = argv[optind + 1];
+
+	Input = fopen(argv[optind], "rb");
+	if(Input == NULL){
+		perror(argv[optind]);
+		return 1;
+	}
+	// Serial device --> raw mode, commands sent on the same device
+	if(isatty(fileno(Input))){
+		Device = open(argv[optind], O_WRONLY | O_NOCTTY);
+		if((Device < 0) || tcgetattr(fileno(Input), &Tty)){
+			perror(argv[optind]);
+			return 1;
+		}
+		cfmakeraw(&Tty);
+		tcsetattr(fileno(Input), TCSANOW, &Tty);
+	}
+
+	snprintf(FileName, sizeof(FileName), "%s_frames.csv", Prefix);
+	Metadata = fopen(FileName, "w");
+	if(Metadata == NULL){
+		perror(FileName);
+		return 1;
+	}
+	fprintf(Metadata, "frame,time,selector,cell,x,y,heading,width,height,encoded_bytes,file\n");
+
+	signal(SIGINT, stop_reception);
+	if(Rle){
+		send_key(IMAGE_RLE_KEY);
+	}
+	send_key(IMAGE_STREAM_KEY);
+	Start = LastReport = now();
+
+	// Slides a window of one record over the stream until sync byte and type are valid
+	while(!Stop && ((Byte = fgetc(Input)) != EOF)){
+		Window[Filled++] = (uint8_t)Byte;
+
+		if((Filled >= 2) && ((Record.Sync != TLM_SYNC) || (Record.Type == 0) || (Record.Type >= TLM_NB_TYPES))){
+			memmove(Window, Window + 1, --Filled);
+			while(Filled && (Window[0] != TLM_SYNC)){
+				memmove(Window, Window + 1, --Filled);
+			}
+			continue;
+		}
+		if(Filled < sizeof(tlm_record_t)){
+			continue;
+		}
+		Filled = 0;
+		Total.LinkBytes += sizeof(tlm_record_t);
+		Period.LinkBytes += sizeof(tlm_record_t);
+
+		if(Record.Type == TLM_FRAME){
+			end_frame();
+			memcpy(&Frame.Info, Record.Payload, sizeof(tlm_frame_t));
+			Frame.Time = Record.Time;
+			Frame.Valid = (Frame.Info.Width == IMAGE_FRAME_WIDTH) && (Frame.Info.Height == IMAGE_FRAME_HEIGHT);
+		}else if(Record.Type == TLM_IMAGE){
+			const tlm_image_t* Header = (const void*)Record.Payload;
+			// Longer than a chunk --> false record inside the data of a cut chunk
+			if(Header->Length <= IMAGE_CHUNK_SIZE){
+				receive_chunk(Input, Header);
+			}
+		}
+
+		if(now() - LastReport >= REPORT_PERIOD){
+			print_throughput("last second", &Period, now() - LastReport);
+			memset(&Period, 0, sizeof(Period));
+			LastReport = now();
+		}
+		if(MaxFrames && (Total.Frames >= MaxFrames)){
+			break;
+		}
+	}
+	end_frame();
+
+	// Stream stopped, the e-puck captures the color row again
+	send_key(IMAGE_STREAM_KEY);
+	if(Rle){
+		send_key(IMAGE_RLE_KEY);
+	}
+
+	print_throughput("total", &Total, now() - Start);
+	fclose(Metadata);
+	fclose(Input);
+	if(Device >= 0){
+		close(Device);
+	}
+	return 0;
+}
+/*** END MAIN ***/
@@ -0,0 +1,111 @@
+/**
+ * @file	MazeBench.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which runs every solving mode over a corpus of MazeGen and
+ * 			 writes a CSV summary per mode and per kind of maze on stdout:
+ * 			 success rate, then cells travelled, turns and simulated time-to-exit
+ * 			 as means over the successful runs, the mean error of their turns,
+ * 			 then the count of every failure.
+ * 			The noise of the simulation is seeded by the seed of the maze (0 by default),
+ * 			 the same corpus gives the same summary: a change of the solving is compared
+ * 			 with the summary of the last commit.
+ *
+ * 			Build:	make MazeBench		(gcc -O2 -DHOST_BUILD -I.. -Ihost -o MazeBench MazeBench.c MazeSim.c ../DataProcess.c ../MazeMap.c ../HeadingEstimator.c -lm)
+ * 			Usage:	./MazeBench corpus.maz > summary.csv
+ * 					./MazeBench corpus.maz runs.csv > summary.csv		(also one line per run)
+ * 					make bench											(corpus of the makefile)
+ */
+
+#include <stdio.h>
+
+#include "MazeSim.h"
+
+// Summary define
+#define ALL_KINDS		MAZE_NB_KINDS	// line of every kind of maze
+
+
+/*** STATIC VARIABLES ***/
+static sim_stat_t Stat[SIM_NB_SOLVERS][MAZE_NB_KINDS + 1];
+
+
+/*** MAIN ***/
+int main(int argc, char* argv[]){
+	maze_t Maze;
+	sim_result_t Result;
+	unsigned long NbMazes = 0;
+	FILE* Corpus;
+	FILE* Runs = NULL;
+
+	if((argc != 2) && (argc != 3)){
+		fprintf(stderr, "usage: %s <corpus> [runs csv] > summary.csv\n", argv[0]);
+		return 1;
+	}
+
+	Corpus = fopen(argv[1], "rb");
+	if(Corpus == NULL){
+		perror(argv[1]);
+		return 1;
+	}
+	if(argc == 3){
+		Runs = fopen(argv[2], "w");
+		if(Runs == NULL){
+			perror(argv[2]);
+			fclose(Corpus);
+			return 1;
+		}
+		fprintf(Runs, "maze,seed,kind,width,height,solver,outcome,cells,turns,decisions,time_s,turn_error_mrad\n");
+	}
+
+	while(maze_read(Corpus, &Maze)){
+		for(uint8_t Solver = 0 ; Solver < SIM_NB_SOLVERS ; Solver++){
+			sim_run(&Maze, Solver, Maze.Header.Seed, &Result);
+			sim_stat_add(&Stat[Solver][Maze.Header.Kind], &Result);
+			sim_stat_add(&Stat[Solver][ALL_KINDS], &Result);
+
+			if(Runs){
+				fprintf(Runs, "%lu,%u,%s,%u,%u,%s,%s,%u,%u,%u,%.2f,%.2f\n", NbMazes, (unsigned)Maze.Header.Seed,
+						maze_kind_name(Maze.Header.Kind), Maze.Header.Width, Maze.Header.Height,
+						sim_solver_name(Solver), sim_outcome_name(Result.Outcome),
+						Result.Cells, Result.Turns, Result.Decisions, Result.Time,
+						Result.Turns ? 1000 * Result.TurnError / Result.Turns : 0.0f);
+			}
+		}
+		NbMazes++;
+	}
+
+	// Stopped before the end --> invalid maze, the summary would be misleading
+	if(!feof(Corpus) || !NbMazes){
+		fprintf(stderr, "%s: invalid maze %lu\n", argv[1], NbMazes);
+		fclose(Corpus);
+		if(Runs){
+			fclose(Runs);
+		}
+		return 1;
+	}
+	fclose(Corpus);
+	if(Runs){
+		fclose(Runs);
+	}
+
+	printf("solver,kind");
+	sim_stat_print_header(stdout);
+	printf("\n");
+
+	for(uint8_t Solver = 0 ; Solver < SIM_NB_SOLVERS ; Solver++){
+		for(uint8_t Kind = 0 ; Kind <= ALL_KINDS ; Kind++){
+			if(Stat[Solver][Kind].Runs){
+				printf("%s,%s", sim_solver_name(Solver), (Kind == ALL_KINDS) ? "all" : maze_kind_name(Kind));
+				sim_stat_print(stdout, &Stat[Solver][Kind]);
+				printf("\n");
+			}
+		}
+	}
+
+	return 0;
+}
+/*** END MAIN ***/
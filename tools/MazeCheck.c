@@ -0,0 +1,172 @@
+/**
+ * @file	MazeCheck.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which runs the solving modes on small mazes built by hand,
+ * 			 each case checks one behaviour of the firmware in the simulator.
+ * 			Writes one line per case and returns 1 if a case fails.
+ *
+ * 			Build:	make MazeCheck		(gcc -O2 -DHOST_BUILD -I.. -Ihost -o MazeCheck MazeCheck.c MazeSim.c ../DataProcess.c ../MazeMap.c ../HeadingEstimator.c -lm)
+ * 			Usage:	./MazeCheck
+ * 					make check
+ */
+
+#include <stdio.h>
+
+#include <main.h>
+#include <MazeMap.h>
+
+#include "MazeSim.h"
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Builds a maze with all the walls, the start at (0, 0) heading NORTH.
+ */
+static void maze_closed(maze_t* Maze, uint8_t Width, uint8_t Height){
+	Maze->Header.Magic = MAZE_MAGIC;
+	Maze->Header.Kind = MAZE_PERFECT;
+	Maze->Header.Width = Width;
+	Maze->Header.Height = Height;
+	Maze->Header.StartX = 0;
+	Maze->Header.StartY = 0;
+	Maze->Header.StartHeading = NORTH;
+	Maze->Header.NbColors = 0;
+	Maze->Header.Seed = 0;
+	for(uint8_t i = 0 ; i < (Width * Height) ; i++){
+		Maze->Cell[i] = WALL_B;
+	}
+}
+
+/**
+ * @brief	Case of a blue cell in front of a wall: the spin must be over
+ * 			 before the front wall squares the e-puck up.
+ *
+ * 			+---+---+
+ * 			|     ^ |	exit to the north of (1, 1)
+ * 			+---+   +
+ * 			| B     |	start (0, 0) on a blue cell, heading NORTH
+ * 			+---+---+
+ *
+ * @return	1 if the case passes, 0 otherwise
+ */
+static uint8_t check_blue_before_wall(void){
+	maze_t Maze;
+	sim_result_t Result;
+	uint8_t Pass = 1;
+
+	maze_closed(&Maze, 2, 2);
+	maze_open(&Maze, 0, 0, EAST);
+	maze_open(&Maze, 1, 0, NORTH);
+	maze_open(&Maze, 1, 1, NORTH);
+	Maze.Cell[0] |= BLUE_B;
+	Maze.Header.NbColors = 1;
+
+	for(uint8_t Solver = SIM_LEFT_WALL ; Solver <= SIM_PLEDGE ; Solver++){
+		sim_run(&Maze, Solver, 1, &Result);
+		if((Result.Outcome != SIM_SUCCESS) || Result.BusyReads){
+			printf("blue_before_wall %s: FAIL, %s after %u cells, %u square-up(s) during a spin\n",
+					sim_solver_name(Solver), sim_outcome_name(Result.Outcome), Result.Cells, Result.BusyReads);
+			Pass = 0;
+		}
+	}
+	if(Pass){
+		printf("blue_before_wall: ok\n");
+	}
+	return Pass;
+}
+
+/**
+ * @brief	Case of an inner cell without walls entered from the border of the visited
+ * 			 cells: out of the visited coordinates it looks like the exit, the cell beyond
+ * 			 with walls shows that it is not, the route visits the colored cells behind it.
+ *
+ * 			+---+---+---+
+ * 			|   | B |   |
+ * 			+---+   +---+
+ * 			| B         	exit to the east of (2, 1)
+ * 			+---+   +---+
+ * 			|   | ^ |   |	start (1, 0), heading NORTH
+ * 			+---+---+---+
+ *
+ * @return	1 if the case passes, 0 otherwise
+ */
+static uint8_t check_inner_without_walls(void){
+	maze_t Maze;
+	sim_result_t Result;
+
+	maze_closed(&Maze, 3, 3);
+	Maze.Header.StartX = 1;
+	maze_open(&Maze, 1, 0, NORTH);
+	maze_open(&Maze, 1, 1, NORTH);
+	maze_open(&Maze, 1, 1, EAST);
+	maze_open(&Maze, 1, 1, WEST);
+	maze_open(&Maze, 2, 1, EAST);
+	Maze.Cell[1 + 2 * 3] |= BLUE_B;
+	Maze.Cell[0 + 1 * 3] |= BLUE_B;
+	Maze.Header.NbColors = 2;
+
+	sim_run(&Maze, SIM_ROUTE, 1, &Result);
+	if(Result.Outcome != SIM_SUCCESS){
+		printf("inner_without_walls: FAIL, %s after %u cells, %u waypoint(s)\n",
+				sim_outcome_name(Result.Outcome), Result.Cells, map_get_waypoint_count());
+		return 0;
+	}
+	printf("inner_without_walls: ok\n");
+	return 1;
+}
+
+/**
+ * @brief	Case of more colored cells than MAX_WAYPOINTS: the cells beyond are
+ * 			 reported as dropped by the map, once each even if crossed again.
+ *
+ * 			+---+---+---+---+---+---+---+---+
+ * 			| B   B   B   B   B   B   B     	exit to the east of (7, 0)
+ * 			+---+---+---+---+---+---+---+---+
+ * 			 start (0, 0), heading EAST
+ *
+ * @return	1 if the case passes, 0 otherwise
+ */
+static uint8_t check_waypoint_dropped(void){
+	maze_t Maze;
+	sim_result_t Result;
+
+	maze_closed(&Maze, 8, 1);
+	Maze.Header.StartHeading = EAST;
+	for(uint8_t x = 0 ; x < 8 ; x++){
+		maze_open(&Maze, x, 0, EAST);
+	}
+	for(uint8_t x = 0 ; x < 7 ; x++){
+		Maze.Cell[x] |= BLUE_B;
+	}
+	Maze.Header.NbColors = 7;
+
+	sim_run(&Maze, SIM_ROUTE, 1, &Result);
+	if((Result.Outcome != SIM_SUCCESS) || (map_get_waypoint_count() != MAX_WAYPOINTS)
+			|| (map_get_waypoint_dropped() != 7 - MAX_WAYPOINTS)){
+		printf("waypoint_dropped: FAIL, %s after %u cells, %u waypoint(s), %u dropped\n",
+				sim_outcome_name(Result.Outcome), Result.Cells, map_get_waypoint_count(), map_get_waypoint_dropped());
+		return 0;
+	}
+	printf("waypoint_dropped: ok\n");
+	return 1;
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+
+/*** MAIN ***/
+int main(void){
+	uint8_t Pass = 1;
+
+	Pass &= check_blue_before_wall();
+	Pass &= check_inner_without_walls();
+	Pass &= check_waypoint_dropped();
+
+	return Pass ? 0 : 1;
+}
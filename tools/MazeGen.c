@@ -0,0 +1,289 @@
+/**
+ * @file	MazeGen.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which generates a corpus of mazes for MazeBench, written on stdout.
+ * 			Every maze is generated again from its seed, saved in its header, so a corpus
+ * 			 is the same on every host. Corpora of several kinds are concatenated.
+ * 				perfect:	one path between two cells, from a depth-first search
+ * 				braided:	perfect maze, then half of the dead ends opened (loops)
+ * 				rooms:		perfect maze, then open rooms of 2x2 to 3x3 cells
+ * 			The exit is one opening of the outer wall, the colored cells are red,
+ * 			 green or blue (floor actions of the modes 0 and 1, waypoints of the mode 5).
+ *
+ * 			Build:	make MazeGen		(gcc -O2 -DHOST_BUILD -I.. -Ihost -o MazeGen MazeGen.c MazeSim.c ../DataProcess.c ../MazeMap.c ../HeadingEstimator.c -lm)
+ * 			Usage:	./MazeGen <kind> <width>x<height> <count> <seed> [colors] > corpus.maz
+ * 					./MazeGen perfect 6x6 100 1 3 > corpus.maz
+ * 					./MazeGen braided 8x8 100 2 3 >> corpus.maz
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <main.h>
+#include <MazeMap.h>
+
+#include "MazeSim.h"
+
+// Generator define
+#define SEED_MULTIPLIER		2654435761u		// spreads the seeds of consecutive mazes (Knuth)
+#define BRAID_SHARE			2				// one dead end out of BRAID_SHARE is opened
+#define ROOM_CELLS			32				// one room per ROOM_CELLS cells, at least one
+#define ROOM_MIN_SIZE		2				// in [cells]
+#define ROOM_MAX_SIZE		3				// in [cells]
+
+
+/*** STATIC VARIABLES ***/
+// Absolute directions NORTH, EAST, SOUTH, WEST
+static const int8_t DeltaX[4] = {0, 1, 0, -1};
+static const int8_t DeltaY[4] = {1, 0, -1, 0};
+static const uint8_t FloorColor[3] = {RED_B, GREEN_B, BLUE_B};
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Returns a random value between 0 and Range-1.
+ */
+static uint32_t random_below(uint32_t* State, uint32_t Range){
+	return sim_random(State) % Range;
+}
+
+/**
+ * @brief	Checks if the neighbor of a cell is inside the maze.
+ */
+static uint8_t has_neighbor(const maze_t* Maze, uint8_t X, uint8_t Y, uint8_t Direction){
+	int16_t NextX = X + DeltaX[Direction];
+	int16_t NextY = Y + DeltaY[Direction];
+
+	return (NextX >= 0) && (NextY >= 0) && (NextX < Maze->Header.Width) && (NextY < Maze->Header.Height);
+}
+
+/**
+ * @brief	Carves a perfect maze with a depth-first search (recursive backtracker)
+ * 			 from a random cell, all the walls are set before.
+ */
+static void carve_perfect(maze_t* Maze, uint32_t* State){
+	uint8_t Stack[MAZE_MAX_SIZE * MAZE_MAX_SIZE];
+	uint8_t Visited[MAZE_MAX_SIZE * MAZE_MAX_SIZE] = {0};
+	uint8_t Width = Maze->Header.Width;
+	uint8_t Candidate[4];
+	uint8_t Depth = 0;
+	uint8_t NbCandidates, Idx, X, Y, Dir, Next;
+
+	Idx = random_below(State, Width * Maze->Header.Height);
+	Visited[Idx] = 1;
+	Stack[Depth++] = Idx;
+
+	while(Depth){
+		Idx = Stack[Depth-1];
+		X = Idx % Width;
+		Y = Idx / Width;
+
+		NbCandidates = 0;
+		for(Dir = NORTH ; Dir <= WEST ; Dir++){
+			if(has_neighbor(Maze, X, Y, Dir) && !Visited[(Y + DeltaY[Dir]) * Width + X + DeltaX[Dir]]){
+				Candidate[NbCandidates++] = Dir;
+			}
+		}
+
+		if(!NbCandidates){
+			Depth--;
+			continue;
+		}
+
+		Dir = Candidate[random_below(State, NbCandidates)];
+		maze_open(Maze, X, Y, Dir);
+		Next = (Y + DeltaY[Dir]) * Width + X + DeltaX[Dir];
+		Visited[Next] = 1;
+		Stack[Depth++] = Next;
+	}
+}
+
+/**
+ * @brief	Opens an inner wall of some dead ends, each one adds a loop.
+ */
+static void braid(maze_t* Maze, uint32_t* State){
+	uint8_t Candidate[4];
+	uint8_t NbCandidates;
+
+	for(uint8_t Y = 0 ; Y < Maze->Header.Height ; Y++){
+		for(uint8_t X = 0 ; X < Maze->Header.Width ; X++){
+			// Dead end --> three walls
+			switch (Maze->Cell[Y * Maze->Header.Width + X] & WALL_B) {
+			case WALL_B & ~(1 << NORTH):
+			case WALL_B & ~(1 << EAST):
+			case WALL_B & ~(1 << SOUTH):
+			case WALL_B & ~(1 << WEST):
+				break;
+			default:
+				continue;
+			}
+			if(random_below(State, BRAID_SHARE)){
+				continue;
+			}
+
+			NbCandidates = 0;
+			for(uint8_t Dir = NORTH ; Dir <= WEST ; Dir++){
+				if((Maze->Cell[Y * Maze->Header.Width + X] & (1 << Dir)) && has_neighbor(Maze, X, Y, Dir)){
+					Candidate[NbCandidates++] = Dir;
+				}
+			}
+			if(NbCandidates){
+				maze_open(Maze, X, Y, Candidate[random_below(State, NbCandidates)]);
+			}
+		}
+	}
+}
+
+/**
+ * @brief	Removes all the inner walls of some rectangles of cells.
+ */
+static void carve_rooms(maze_t* Maze, uint32_t* State){
+	uint8_t NbRooms = 1 + (Maze->Header.Width * Maze->Header.Height) / ROOM_CELLS;
+	uint8_t RoomWidth, RoomHeight, RoomX, RoomY;
+
+	for(uint8_t n = 0 ; n < NbRooms ; n++){
+		RoomWidth = ROOM_MIN_SIZE + random_below(State, ROOM_MAX_SIZE - ROOM_MIN_SIZE + 1);
+		RoomHeight = ROOM_MIN_SIZE + random_below(State, ROOM_MAX_SIZE - ROOM_MIN_SIZE + 1);
+		if(RoomWidth > Maze->Header.Width){
+			RoomWidth = Maze->Header.Width;
+		}
+		if(RoomHeight > Maze->Header.Height){
+			RoomHeight = Maze->Header.Height;
+		}
+		RoomX = random_below(State, Maze->Header.Width - RoomWidth + 1);
+		RoomY = random_below(State, Maze->Header.Height - RoomHeight + 1);
+
+		for(uint8_t Y = RoomY ; Y < RoomY + RoomHeight ; Y++){
+			for(uint8_t X = RoomX ; X < RoomX + RoomWidth ; X++){
+				if(X + 1 < RoomX + RoomWidth){
+					maze_open(Maze, X, Y, EAST);
+				}
+				if(Y + 1 < RoomY + RoomHeight){
+					maze_open(Maze, X, Y, NORTH);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief	Generates a maze from its seed, the same maze for the same arguments.
+ */
+static void generate_maze(maze_t* Maze, uint8_t Kind, uint8_t Width, uint8_t Height, uint8_t NbColors, uint32_t Seed){
+	uint32_t State = Seed;
+	uint8_t NbCells = Width * Height;
+	uint8_t ExitIdx, Idx, Dir;
+
+	Maze->Header.Magic = MAZE_MAGIC;
+	Maze->Header.Kind = Kind;
+	Maze->Header.Width = Width;
+	Maze->Header.Height = Height;
+	Maze->Header.Seed = Seed;
+	memset(Maze->Cell, WALL_B, NbCells);
+
+	carve_perfect(Maze, &State);
+	switch (Kind) {
+	case MAZE_BRAIDED:
+		braid(Maze, &State);
+		break;
+	case MAZE_ROOMS:
+		carve_rooms(Maze, &State);
+		break;
+	default:	// MAZE_PERFECT
+		break;
+	}
+
+	// Exit: one opening in a random side of the outer wall
+	Dir = random_below(&State, 4);
+	if((Dir == NORTH) || (Dir == SOUTH)){
+		ExitIdx = ((Dir == NORTH) ? (Height - 1) : 0) * Width + random_below(&State, Width);
+	}else{
+		ExitIdx = random_below(&State, Height) * Width + ((Dir == EAST) ? (Width - 1) : 0);
+	}
+	maze_open(Maze, ExitIdx % Width, ExitIdx / Width, Dir);
+
+	// Start anywhere but at the exit
+	do{
+		Idx = random_below(&State, NbCells);
+	}while(Idx == ExitIdx);
+	Maze->Header.StartX = Idx % Width;
+	Maze->Header.StartY = Idx / Width;
+	Maze->Header.StartHeading = random_below(&State, 4);
+
+	// Colored cells, neither at the start nor at the exit
+	Maze->Header.NbColors = 0;
+	while(Maze->Header.NbColors < NbColors){
+		Idx = random_below(&State, NbCells);
+		if((Idx == ExitIdx) || (Idx == Maze->Header.StartY * Width + Maze->Header.StartX) || (Maze->Cell[Idx] & COLOR_B)){
+			continue;
+		}
+		Maze->Cell[Idx] |= FloorColor[random_below(&State, 3)];
+		Maze->Header.NbColors++;
+	}
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** MAIN ***/
+int main(int argc, char* argv[]){
+	maze_t Maze;
+	unsigned Width, Height, Count, Seed;
+	unsigned NbColors = 0;
+	uint32_t MazeSeed;
+	uint8_t Kind;
+
+	if((argc != 5) && (argc != 6)){
+		fprintf(stderr, "usage: %s <perfect|braided|rooms> <width>x<height> <count> <seed> [colors] > corpus\n", argv[0]);
+		return 1;
+	}
+
+	for(Kind = 0 ; Kind < MAZE_NB_KINDS ; Kind++){
+		if(!strcmp(argv[1], maze_kind_name(Kind))){
+			break;
+		}
+	}
+	if(Kind == MAZE_NB_KINDS){
+		fprintf(stderr, "unknown kind: %s\n", argv[1]);
+		return 1;
+	}
+
+	if((sscanf(argv[2], "%ux%u", &Width, &Height) != 2)
+			|| (Width < MAZE_MIN_SIZE) || (Width > MAZE_MAX_SIZE)
+			|| (Height < MAZE_MIN_SIZE) || (Height > MAZE_MAX_SIZE)){
+		fprintf(stderr, "size from %ux%u to %ux%u cells\n", MAZE_MIN_SIZE, MAZE_MIN_SIZE, MAZE_MAX_SIZE, MAZE_MAX_SIZE);
+		return 1;
+	}
+
+	Count = strtoul(argv[3], NULL, 0);
+	Seed = strtoul(argv[4], NULL, 0);
+	if(argc == 6){
+		NbColors = strtoul(argv[5], NULL, 0);
+	}
+	// Waypoints recorded by the map, start and exit stay white
+	if((NbColors > MAX_WAYPOINTS) || (NbColors > Width * Height - 2)){
+		fprintf(stderr, "at most %u colored cells\n", (MAX_WAYPOINTS < Width * Height - 2) ? MAX_WAYPOINTS : Width * Height - 2);
+		return 1;
+	}
+
+	for(unsigned i = 0 ; i < Count ; i++){
+		MazeSeed = (Seed * SEED_MULTIPLIER) ^ ((i + 1) * SEED_MULTIPLIER * SEED_MULTIPLIER);
+		if(!MazeSeed){
+			MazeSeed = 1;
+		}
+		generate_maze(&Maze, Kind, Width, Height, NbColors, MazeSeed);
+		if(!maze_write(stdout, &Maze)){
+			perror("stdout");
+			return 1;
+		}
+	}
+
+	return 0;
+}
+/*** END MAIN ***/
@@ -0,0 +1,896 @@
+/**
+ * @file	MazeSim.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Maze simulator of the host tools, with the firmware sources of the detections
+ * 			 and of the solving (DataProcess.c and MazeMap.c) compiled with HOST_BUILD.
+ * 			The IR values and the camera row are built from the walls and the floor of
+ * 			 the cell, so that they go through scan_walls() and extract_color().
+ * 			The motor commands take the time of the acceleration ramp and of the speed.
+ * 			Without noise the e-puck always stops at the center of the next cell. The noise
+ * 			 models add a noise and a crosstalk to the IR values, a light of the run and
+ * 			 a noise to the pixels, a slip to each wheel, a bias and a noise to the gyro.
+ * 			 The slips and the error of the calibration move the e-puck away from the centers,
+ * 			 a front wall and the edges of the side walls bring it back as in the firmware.
+ * 			The heading estimator of the firmware (HeadingEstimator.c) gets the IMU samples
+ * 			 on the simulated clock, the turns run as in ControlMotor until the fused
+ * 			 heading reaches their target.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <leds.h>
+
+#include <main.h>
+#include <SystemControl.h>
+#include <DataAcquisition.h>
+#include <DataProcess.h>
+#include <MazeMap.h>
+#include <MazeParameters.h>
+#include <CameraControl.h>
+#include <HeadingEstimator.h>
+#include <LatencyProbe.h>
+#if COLOR_CLASSIFIER == TRUE
+#include <ColorLut.h>
+#endif
+
+#include "MazeSim.h"
+
+// Simulation define
+#define SIM_NB_IR			(IR8 + 1)
+#define SIM_RUNNING			SIM_NB_OUTCOMES		// step result, the mode goes on
+// Noise model define
+#define SIM_EPUCK_RADIUS	37.5f	// in [mm], the IR sensors are on its border
+#define SIM_CLEARANCE		((CELL_SIZE / 2.0f) - SIM_EPUCK_RADIUS)	// in [mm], from the center to a wall
+#define SIM_MIN_DISTANCE	2.0f	// in [mm], IR value saturates closer
+#define SIM_PROX_MAX		4095	// 12 bits ADC
+#define SIM_QUARTER_TURN	(M_PI / 2)
+#define SIM_IMU_PERIOD		4		// in [ms], samples of the IMU (250 Hz)
+
+
+/*** STATIC VARIABLES ***/
+typedef struct sim_solver_s{
+	const char* Name;
+	uint8_t (*Step)(void);		// one step of the mode, returns SIM_RUNNING or the outcome
+} sim_solver_t;
+
+static int32_t ParamValue[SIM_NB_PARAMS] = {
+		[PARAM_ONE_CELL] 		= ONE_CELL,
+		[PARAM_LEFT_TURN] 		= -LEFT_TURN,
+		[PARAM_RIGHT_TURN] 		= RIGHT_TURN,
+		[PARAM_BACKWARD_TURN] 	= BACKWARD_TURN,
+		[PARAM_ONE_TURN] 		= -ONE_TURN,
+		[PARAM_PROX_THRESHOLD] 	= PROXIMITY_THRESHOLD,
+		[PARAM_IMAGE_WIDTH] 	= IMAGE_BUFFER_SIZE,
+		[PARAM_COLOR_THRESHOLD] = COLOR_THRESHOLD,
+		[PARAM_RED_GAIN] 		= RED_GAIN,
+		[PARAM_GREEN_GAIN] 		= GREEN_GAIN,
+		[PARAM_BLUE_GAIN] 		= BLUE_GAIN,
+		[PARAM_CONTRAST] 		= CAMERA_CONTRAST,
+		[PARAM_COLOR_WINDOW] 	= COLOR_WINDOW,
+		[PARAM_COLOR_CONFIDENCE]= COLOR_MIN_CONFIDENCE,
+		[PARAM_CAMERA_PRESET] 	= CAMERA_PRESET,
+		[SIM_NOMINAL_SPEED] 	= NOMINAL_SPEED,
+		[SIM_CORRECTION_SPEED] 	= CORRECTION_SPEED};	// noise parameters are 0 (no noise)
+
+static const char* const ParamName[SIM_NB_PARAMS] = {
+		[PARAM_ONE_CELL] 		= "one_cell",
+		[PARAM_LEFT_TURN] 		= "left_turn",
+		[PARAM_RIGHT_TURN] 		= "right_turn",
+		[PARAM_BACKWARD_TURN] 	= "backward_turn",
+		[PARAM_ONE_TURN] 		= "one_turn",
+		[PARAM_PROX_THRESHOLD] 	= "prox_threshold",
+		[PARAM_IMAGE_WIDTH] 	= "image_width",
+		[PARAM_COLOR_THRESHOLD] = "color_threshold",
+		[PARAM_RED_GAIN] 		= "red_gain",
+		[PARAM_GREEN_GAIN] 		= "green_gain",
+		[PARAM_BLUE_GAIN] 		= "blue_gain",
+		[PARAM_CONTRAST] 		= "contrast",
+		[PARAM_COLOR_WINDOW] 	= "color_window",
+		[PARAM_COLOR_CONFIDENCE]= "color_confidence",
+		[PARAM_CAMERA_PRESET] 	= "camera_preset",
+		[SIM_NOMINAL_SPEED] 	= "nominal_speed",
+		[SIM_CORRECTION_SPEED] 	= "correction_speed",
+		[SIM_IR_NOISE] 			= "ir_noise",
+		[SIM_IR_CROSSTALK] 		= "ir_crosstalk",
+		[SIM_LIGHT_SHIFT] 		= "light_shift",
+		[SIM_PIXEL_NOISE] 		= "pixel_noise",
+		[SIM_WHEEL_SLIP] 		= "wheel_slip",
+		[SIM_CALIBRATION] 		= "calibration",
+		[SIM_GYRO_BIAS] 		= "gyro_bias",
+		[SIM_GYRO_NOISE] 		= "gyro_noise"};
+
+static const char* const KindName[MAZE_NB_KINDS] = {"perfect", "braided", "rooms"};
+static const char* const OutcomeName[SIM_NB_OUTCOMES] = {"success", "false_exit", "blocked", "crashed", "timeout", "incomplete"};
+
+// Simulated e-puck, reset by sim_run()
+static const maze_t* Maze 		= NULL;
+static int16_t PosX 			= 0;	// outside of the maze once exited
+static int16_t PosY 			= 0;
+static uint8_t Heading 			= NORTH;
+static int16_t NominalSpeed 	= NOMINAL_SPEED;	// in [step/s]
+static int8_t ExitStatus 		= SEARCHING;
+static uint8_t ColorVisited[MAZE_MAX_SIZE * MAZE_MAX_SIZE];
+static uint8_t NbColorVisited 	= 0;
+static sim_result_t* Run 		= NULL;
+// Noise of the run, reset by sim_run()
+static uint32_t NoiseState 		= 1;
+static float AlongError 		= 0;	// in [mm], from the center of the cell, forward is positive
+static float LateralError 		= 0;	// in [mm], from the center of the cell, left is positive
+static float HeadingError 		= 0;	// in [rad], counterclockwise is positive
+static uint8_t MotorBusy 		= 0;	// a turn runs, motor_wait_ready() has not been called since
+static int16_t StepsDone 		= 0;	// in [steps], of the last command, never stopped short
+static float LightGain[3] 		= {1, 1, 1};	// red, green, blue
+static double SimTime 			= 0;	// in [s], clock of the IMU samples and of PROBE_NOW()
+static double NextSample 		= 0;	// in [s], next IMU sample
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Returns the time of a motor command in [s]: acceleration ramp
+ * 			 from RAMP_START_SPEED at ACCEL_MAX, then constant speed.
+ */
+static float command_time(int32_t Steps, int16_t Speed){
+	float RampTime, RampSteps;
+
+	if(Speed <= RAMP_START_SPEED){
+		return (float)Steps / Speed;
+	}
+
+	RampTime = (float)(Speed - RAMP_START_SPEED) / ACCEL_MAX;
+	RampSteps = (Speed + RAMP_START_SPEED) * RampTime / 2;
+	if(Steps >= RampSteps){
+		return RampTime + (Steps - RampSteps) / Speed;
+	}
+	// Stops before the end of the ramp: Steps = v0*t + a*t^2/2
+	return (sqrtf((float)RAMP_START_SPEED * RAMP_START_SPEED + 2.0f * ACCEL_MAX * Steps)
+			- RAMP_START_SPEED) / ACCEL_MAX;
+}
+
+/**
+ * @brief	Returns a random value with a normal distribution (Box-Muller), 0 without noise.
+ */
+static float gaussian(float Sigma){
+	float Uniform1, Uniform2;
+
+	if(Sigma == 0){
+		return 0;
+	}
+	Uniform1 = ((sim_random(&NoiseState) >> 8) + 1) / 16777216.0f;	// in ]0, 1]
+	Uniform2 = (sim_random(&NoiseState) >> 8) / 16777216.0f;
+	return Sigma * sqrtf(-2.0f * logf(Uniform1)) * cosf(2.0f * M_PI * Uniform2);
+}
+
+/**
+ * @brief	Returns the relative error of a wheel for one command, calibration and slip.
+ */
+static float wheel_error(void){
+	return (ParamValue[SIM_CALIBRATION] + gaussian(ParamValue[SIM_WHEEL_SLIP])) / 1000.0f;
+}
+
+/**
+ * @brief	Gives the IMU samples of a period at constant speeds to the heading estimator.
+ *
+ * @param Duration	in [s]
+ * @param Rate		Real rotation of the e-puck in [rad/s], counterclockwise is positive
+ */
+static void imu_run(float Duration, int16_t SpeedLeft, int16_t SpeedRight, float Rate){
+	double End = SimTime + Duration;
+	float Gyro;
+
+	while(NextSample <= End){
+		SimTime = NextSample;
+		Gyro = Rate + (ParamValue[SIM_GYRO_BIAS] + gaussian(ParamValue[SIM_GYRO_NOISE])) / 1000.0f;
+		heading_update(Gyro, SpeedLeft, SpeedRight, probe_host_now());
+		NextSample += SIM_IMU_PERIOD / 1000.0;
+	}
+	SimTime = End;
+}
+
+/**
+ * @brief	Stands still, the heading estimator learns the bias of the gyro.
+ *
+ * @param Duration	in [ms]
+ */
+static void stand_still(uint16_t Duration){
+	imu_run(Duration / 1000.0f, STOP_SPEED, STOP_SPEED, 0);
+}
+
+#if HEADING_USE_GYRO == TRUE
+/**
+ * @brief	Runs a turn as ControlMotor with HeadingTurn, every CONTROL_PERIOD: acceleration
+ * 			 ramp, stop once the fused heading reaches the target or after the steps
+ * 			 of step_limit(). The error of the wheels changes the real rotation
+ * 			 seen by the gyro, not the applied speeds of the odometry.
+ *
+ * @param Target	in [rad], counterclockwise is positive
+ * @param Error		Relative error of the wheels
+ *
+ * @return	Real angle turned in [rad], counterclockwise is positive
+ */
+static float closed_turn(int16_t AngleVal, float Target, float Error){
+	float StepLimit = abs(AngleVal) + (abs(AngleVal) * HEADING_STEP_MARGIN) / 100;
+	float Period = CONTROL_PERIOD / 1000.0f;	// in [s]
+	float Start = heading_get();
+	float Steps = 0;
+	float Angle = 0;
+	float Rate;
+	int32_t Speed;
+	uint32_t Ticks = 0;
+
+	while((Steps < StepLimit) && ((Target < 0 ? Start - heading_get() : heading_get() - Start)
+			< (fabsf(Target) - HEADING_TOLERANCE))){
+		Speed = RAMP_START_SPEED + (ACCEL_MAX * Ticks * CONTROL_PERIOD) / 1000;
+		if(Speed > NominalSpeed){
+			Speed = NominalSpeed;
+		}
+		// Turn right --> clockwise --> negative rotation
+		Rate = ((Target < 0) ? -Speed : Speed) * (1 + Error) / DEGREE_2_STEP * (M_PI / 180);
+		if(Target < 0){
+			imu_run(Period, Speed, -Speed, Rate);
+		}else{
+			imu_run(Period, -Speed, Speed, Rate);
+		}
+		Steps += Speed * Period;
+		Angle += Rate * Period;
+		Ticks++;
+	}
+	Run->Time += Ticks * Period;
+	return Angle;
+}
+#endif
+
+/**
+ * @brief	Returns the IR value of a wall, inversely proportional to the square
+ * 			 of the distance from the sensor, Value at the center of the cell.
+ *
+ * @param Distance	From the center of the e-puck to the wall in [mm]
+ */
+static float wall_value(uint16_t Value, float Distance){
+	float Gap = Distance - SIM_EPUCK_RADIUS;
+
+	if(Gap < SIM_MIN_DISTANCE){
+		Gap = SIM_MIN_DISTANCE;
+	}
+	return Value * (SIM_CLEARANCE * SIM_CLEARANCE) / (Gap * Gap);
+}
+
+/**
+ * @brief	Returns the 5 or 6 bits value of a pixel of one color, with the light of the run.
+ */
+static uint8_t pixel_value(uint8_t Level, float Gain, uint8_t Max){
+	float Value = Level * Gain + gaussian(ParamValue[SIM_PIXEL_NOISE] * Max / 100.0f) + 0.5f;
+
+	if(Value < 0){
+		return 0;
+	}
+	return (Value > Max) ? Max : (uint8_t)Value;
+}
+
+/**
+ * @brief	Checks if a cell is inside the maze.
+ */
+static uint8_t is_inside(int16_t X, int16_t Y){
+	return (X >= 0) && (Y >= 0) && (X < Maze->Header.Width) && (Y < Maze->Header.Height);
+}
+
+/**
+ * @brief	Gives the coordinates of the neighbor of a cell in an absolute direction.
+ */
+static void neighbor(int16_t* X, int16_t* Y, uint8_t Direction){
+	switch (Direction) {
+	case NORTH:
+		(*Y)++;
+		break;
+	case EAST:
+		(*X)++;
+		break;
+	case SOUTH:
+		(*Y)--;
+		break;
+	default:	// WEST
+		(*X)--;
+		break;
+	}
+}
+
+/**
+ * @brief	Returns ActualCell as GetProximity and ProcessImage would
+ * 			 set it at the center of the cell where the e-puck stands.
+ */
+static uint8_t sense_cell(void){
+	float Clean[SIM_NB_IR];
+	float Value;
+	uint16_t Prox[SIM_NB_IR];
+	uint8_t Row[2 * IMAGE_BUFFER_SIZE];
+#if COLOR_CLASSIFIER == TRUE
+	uint8_t Confidence;
+#else
+	uint32_t RedVal, GreenVal, BlueVal;
+#endif
+	uint8_t Absolute = maze_walls(Maze, PosX, PosY);
+	uint8_t Floor = is_inside(PosX, PosY) ? (Maze->Cell[PosY * Maze->Header.Width + PosX] & COLOR_B) : 0;
+	uint8_t Walls = NO_WALL;
+	uint8_t Red, Green, Blue;
+	// From the center of the e-puck to the walls in [mm]
+	float Front = CELL_SIZE / 2.0f - AlongError;
+	float Back = CELL_SIZE / 2.0f + AlongError;
+	float Left = CELL_SIZE / 2.0f - LateralError;
+	float Right = CELL_SIZE / 2.0f + LateralError;
+
+	// Rotates the walls from the absolute frame to the e-puck reference
+	for(uint8_t Wall = WALL_FRONT_BIT ; Wall <= WALL_LEFT_BIT ; Wall++){
+		if(Absolute & (1 << ((Wall + Heading) & 0x03))){
+			Walls |= 1 << Wall;
+		}
+	}
+
+	for(uint8_t i = 0 ; i < SIM_NB_IR ; i++){
+		Clean[i] = SIM_PROX_FREE;
+	}
+	if(Walls & WALL_FRONT_B){
+		Clean[IR1] = Clean[IR8] = wall_value(SIM_PROX_WALL, Front);
+		Clean[IR2] = Clean[IR7] = wall_value(SIM_PROX_DIAGONAL, Front);
+	}
+	if(Walls & WALL_RIGHT_B){
+		Clean[IR3] = wall_value(SIM_PROX_WALL, Right);
+		Clean[IR2] = fmaxf(Clean[IR2], wall_value(SIM_PROX_DIAGONAL, Right));
+	}
+	if(Walls & WALL_BACK_B){
+		Clean[IR4] = Clean[IR5] = wall_value(SIM_PROX_WALL, Back);
+	}
+	if(Walls & WALL_LEFT_B){
+		Clean[IR6] = wall_value(SIM_PROX_WALL, Left);
+		Clean[IR7] = fmaxf(Clean[IR7], wall_value(SIM_PROX_DIAGONAL, Left));
+	}
+
+	// Crosstalk of the two neighbors on the ring of sensors, then noise
+	for(uint8_t i = 0 ; i < SIM_NB_IR ; i++){
+		Value = Clean[i] + gaussian(ParamValue[SIM_IR_NOISE]) + 0.5f
+				+ ParamValue[SIM_IR_CROSSTALK] * (Clean[(i + 1) % SIM_NB_IR] + Clean[(i + SIM_NB_IR - 1) % SIM_NB_IR]) / 100.0f;
+		Prox[i] = (Value < 0) ? 0 : ((Value > SIM_PROX_MAX) ? SIM_PROX_MAX : (uint16_t)Value);
+	}
+
+	// Uniform floor, a white floor lights the three colors
+	Red = (!Floor || (Floor & RED_B)) ? SIM_PIXEL_LIT : SIM_PIXEL_DARK;
+	Green = 2 * ((!Floor || (Floor & GREEN_B)) ? SIM_PIXEL_LIT : SIM_PIXEL_DARK);
+	Blue = (!Floor || (Floor & BLUE_B)) ? SIM_PIXEL_LIT : SIM_PIXEL_DARK;
+	for(uint16_t i = 0 ; i < (2 * IMAGE_BUFFER_SIZE) ; i+=2){
+		uint8_t PixelRed = pixel_value(Red, LightGain[0], 0x1F);
+		uint8_t PixelGreen = pixel_value(Green, LightGain[1], 0x3F);
+		uint8_t PixelBlue = pixel_value(Blue, LightGain[2], 0x1F);
+
+		Row[i] = (PixelRed << 3) | (PixelGreen >> 3);
+		Row[i+1] = ((PixelGreen & 0x07) << 5) | PixelBlue;
+	}
+#if COLOR_CLASSIFIER == TRUE
+	return scan_walls(Prox, param_get(PARAM_PROX_THRESHOLD)) | classify_row(Row, param_get(PARAM_IMAGE_WIDTH), ColorLut, &Confidence);
+#else
+	sum_row_colors(Row, param_get(PARAM_IMAGE_WIDTH), &RedVal, &GreenVal, &BlueVal);
+
+	return scan_walls(Prox, param_get(PARAM_PROX_THRESHOLD)) | extract_color(&RedVal, &GreenVal, &BlueVal, param_get(PARAM_COLOR_THRESHOLD));
+#endif
+}
+
+/**
+ * @brief	Returns the free cells ahead as get_corridor_length().
+ */
+static uint8_t sense_corridor(void){
+	int16_t X = PosX;
+	int16_t Y = PosY;
+	uint8_t NbCells = 0;
+
+	while((NbCells < TOF_MAX_CELLS) && !(maze_walls(Maze, X, Y) & (1 << Heading))){
+		neighbor(&X, &Y, Heading);
+		NbCells++;
+	}
+	return NbCells;
+}
+
+/**
+ * @brief	Counts the colored cells of the maze the first time they are reached.
+ */
+static void visit_cell(void){
+	uint8_t Idx;
+
+	if(!is_inside(PosX, PosY)){
+		return;
+	}
+	Idx = PosY * Maze->Header.Width + PosX;
+	if((Maze->Cell[Idx] & COLOR_B) && !ColorVisited[Idx]){
+		ColorVisited[Idx] = 1;
+		NbColorVisited++;
+	}
+}
+
+/**
+ * @brief	Checks the offset of the e-puck against the walls of its cell.
+ * 			 Further than half a cell, the e-puck stands in the neighbor cell.
+ *
+ * @return	0 if it runs into a side wall, 1 otherwise
+ */
+static uint8_t settle(void){
+	uint8_t Walls = maze_walls(Maze, PosX, PosY);
+	uint8_t LeftDir = (Heading + 3) & 0x03;
+	uint8_t RightDir = (Heading + 1) & 0x03;
+
+	if(((LateralError > SIM_CLEARANCE) && (Walls & (1 << LeftDir)))
+			|| ((LateralError < -SIM_CLEARANCE) && (Walls & (1 << RightDir)))){
+		return 0;
+	}
+	// Stopped by the collision monitor before a front wall
+	if((AlongError > SIM_CLEARANCE) && (Walls & (1 << Heading))){
+		AlongError = SIM_CLEARANCE;
+	}
+
+	if(AlongError > CELL_SIZE / 2.0f){
+		neighbor(&PosX, &PosY, Heading);
+		AlongError -= CELL_SIZE;
+		Run->Cells++;
+		visit_cell();
+	}else if(AlongError < -CELL_SIZE / 2.0f){
+		neighbor(&PosX, &PosY, (Heading + 2) & 0x03);
+		AlongError += CELL_SIZE;
+	}
+	if(LateralError > CELL_SIZE / 2.0f){
+		neighbor(&PosX, &PosY, LeftDir);
+		LateralError -= CELL_SIZE;
+		visit_cell();
+	}else if(LateralError < -CELL_SIZE / 2.0f){
+		neighbor(&PosX, &PosY, RightDir);
+		LateralError += CELL_SIZE;
+		visit_cell();
+	}
+	return 1;
+}
+
+/**
+ * @brief	Moves the e-puck forward of several cells. The error of each wheel moves
+ * 			 it along and turns it, so that it drifts to the side.
+ * 			The first edge of a side wall re-zeros the distance, as in the firmware.
+ *
+ * @return	0 if it runs into a wall, 1 otherwise
+ */
+static uint8_t drive(uint8_t NbCells, uint8_t UseEdges){
+	uint8_t Sides = (1 << ((Heading + 1) & 0x03)) | (1 << ((Heading + 3) & 0x03));
+	float Distance = NbCells * param_get(PARAM_ONE_CELL) / MM_2_STEP;	// in [mm]
+	float LeftError = wheel_error();
+	float RightError = wheel_error();
+	uint8_t Edge = 0;
+	uint8_t Previous;
+
+	for(uint8_t i = 0 ; i < NbCells ; i++){
+		if(maze_walls(Maze, PosX, PosY) & (1 << Heading)){
+			return 0;
+		}
+		Previous = maze_walls(Maze, PosX, PosY) & Sides;
+		neighbor(&PosX, &PosY, Heading);
+		Run->Cells++;
+		visit_cell();
+		if(Previous != (maze_walls(Maze, PosX, PosY) & Sides)){
+			Edge = 1;
+		}
+	}
+
+	AlongError += Distance * (1 + (LeftError + RightError) / 2) - NbCells * CELL_SIZE;
+	HeadingError += (RightError - LeftError) * Distance / WHEEL_DISTANCE;
+	LateralError += Distance * sinf(HeadingError);
+	if(UseEdges && Edge){
+		AlongError = 0;
+	}
+	return settle();
+}
+
+/**
+ * @brief	Same as go_next_cell(): turn at NominalSpeed if needed, then one cell.
+ *
+ * @return	0 if it runs into a wall, 1 otherwise
+ */
+static uint8_t go_next_cell_sim(int16_t DirectionVal){
+	float Along = AlongError;
+
+	// Squares up and snaps the distance to a front wall (front_wall_correction)
+	if(maze_walls(Maze, PosX, PosY) & (1 << Heading)){
+		if(MotorBusy){
+			// IR1 and IR8 read while spinning --> correction clamped to ALIGN_MAX_HEADING
+			Run->BusyReads++;
+			HeadingError -= (ALIGN_MAX_HEADING / DEGREE_2_STEP) * (M_PI / 180);
+		}else{
+			HeadingError = 0;
+			AlongError = Along = 0;
+		}
+	}
+
+	// The offset is given again in the frame of the new heading
+	switch (DirectionVal) {
+	case LEFT_TURN:
+		turn(-param_get(PARAM_LEFT_TURN));
+		Heading = (Heading + 3) & 0x03;
+		AlongError = LateralError;
+		LateralError = -Along;
+		break;
+	case RIGHT_TURN:
+		turn(param_get(PARAM_RIGHT_TURN));
+		Heading = (Heading + 1) & 0x03;
+		AlongError = -LateralError;
+		LateralError = Along;
+		break;
+	case BACKWARD_TURN:
+		turn(param_get(PARAM_BACKWARD_TURN));
+		Heading = (Heading + 2) & 0x03;
+		AlongError = -AlongError;
+		LateralError = -LateralError;
+		break;
+	default:	// MOVE_FORWARD
+		break;
+	}
+
+	// The move waits for the turn
+	MotorBusy = 0;
+	StepsDone = param_get(PARAM_ONE_CELL);
+	Run->Time += command_time(param_get(PARAM_ONE_CELL), NominalSpeed);
+	imu_run(command_time(param_get(PARAM_ONE_CELL), NominalSpeed), NominalSpeed, NominalSpeed, 0);
+	return drive(1, 1);
+}
+
+/**
+ * @brief	Same as go_straight(): several cells at CRUISE_SPEED, without the edges.
+ *
+ * @return	0 if it runs into a wall, 1 otherwise
+ */
+static uint8_t go_straight_sim(uint8_t NbCells){
+	float Time = command_time(NbCells * param_get(PARAM_ONE_CELL), CRUISE_SPEED);
+
+	StepsDone = NbCells * param_get(PARAM_ONE_CELL);
+	Run->Time += Time;
+	imu_run(Time, CRUISE_SPEED, CRUISE_SPEED, 0);
+	return drive(NbCells, 0);
+}
+
+/**
+ * @brief	Same steps as solve_maze_step() of main.c.
+ */
+static uint8_t solve_maze_step(int16_t (*Algorithm)(uint8_t)){
+	uint8_t Cell = sense_cell();
+
+	check_exit(Cell, &ExitStatus);
+	switch (ExitStatus) {
+	case SEARCHING:
+		floor_color_action(Cell);
+		return go_next_cell_sim(Algorithm(Cell)) ? SIM_RUNNING : SIM_CRASHED;
+	case FOUND:
+		return is_inside(PosX, PosY) ? SIM_FALSE_EXIT : SIM_SUCCESS;
+	default:	// BLOCKED
+		return SIM_BLOCKED;
+	}
+}
+
+// Selector = 0: maze solving with left wall follower algorithm.
+static uint8_t left_wall_follower_step(void){
+	return solve_maze_step(left_wall_follower);
+}
+
+// Selector = 1: maze solving with Pledge algorithm.
+static uint8_t pledge_step(void){
+	return solve_maze_step(pledge_algorithm);
+}
+
+// Selector = 5: maze exploration then route through the colored cells, same steps as route_step() of main.c.
+static uint8_t route_step(void){
+	int16_t Direction = MOVE_FORWARD;
+	uint8_t NbCells = 0;
+	uint8_t Corridor;
+	uint8_t Cell = sense_cell();
+
+	map_record_cell(Cell);
+
+	if(!map_exploration_done()){
+		// Left wall follower until it loops, out of the exit --> back into the maze
+		if(!map_frontier_direction(&Direction)){
+			Direction = left_wall_follower(Cell);
+		}
+	}else if(route_next_direction(&Direction) == ROUTE_DONE){
+		return (NbColorVisited == Maze->Header.NbColors) ? SIM_SUCCESS : SIM_INCOMPLETE;
+	}else if(Direction == MOVE_FORWARD){
+		NbCells = route_straight_cells();
+	}
+
+	if(NbCells > 1){
+		Run->Time += TOF_SETTLE_TIME / 1000.0f;
+		stand_still(TOF_SETTLE_TIME);
+		Corridor = sense_corridor();
+		if(Corridor < NbCells){
+			NbCells = Corridor;
+		}
+	}
+
+	// The moves of the simulation are never cut short by a collision stop
+	if(NbCells > 1){
+		map_advance(MOVE_FORWARD, NbCells);
+		return go_straight_sim(NbCells) ? SIM_RUNNING : SIM_CRASHED;
+	}
+	map_advance(Direction, 1);
+	return go_next_cell_sim(Direction) ? SIM_RUNNING : SIM_CRASHED;
+}
+
+static const sim_solver_t Solvers[SIM_NB_SOLVERS] = {
+		[SIM_LEFT_WALL] = {"left_wall_follower", 	left_wall_follower_step},
+		[SIM_PLEDGE] 	= {"pledge", 				pledge_step},
+		[SIM_ROUTE] 	= {"route", 				route_step}};
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** FIRMWARE FUNCTIONS ***/
+// Actions of DataProcess.c, the motion is simulated
+
+void set_led(led_name_t led_number, unsigned int value){
+	(void)led_number;
+	(void)value;
+}
+
+void set_rgb_led(rgb_led_name_t led_number, uint8_t red_val, uint8_t green_val, uint8_t blue_val){
+	(void)led_number;
+	(void)red_val;
+	(void)green_val;
+	(void)blue_val;
+}
+
+void set_body_led(unsigned int value){
+	(void)value;
+}
+
+void set_front_led(unsigned int value){
+	(void)value;
+}
+
+int32_t param_get(uint8_t Id){
+	return ParamValue[Id];
+}
+
+void correction_nominal_speed(int16_t SpeedCorrection){
+	// CORRECTION_SPEED is compiled in DataProcess.c, only its sign is kept
+	NominalSpeed += (SpeedCorrection > 0) ? ParamValue[SIM_CORRECTION_SPEED] : -ParamValue[SIM_CORRECTION_SPEED];
+	if(NominalSpeed > SPEED_LIMIT_SUP){
+		NominalSpeed = SPEED_LIMIT_SUP;
+	}
+	if(NominalSpeed < SPEED_LIMIT_INF){
+		NominalSpeed = SPEED_LIMIT_INF;
+	}
+}
+
+uint32_t probe_host_now(void){
+	// Cycles of the simulated clock, wraps as the cycle counter
+	return (uint32_t)(uint64_t)(SimTime * PROBE_CYCLES_PER_US * 1000000.0);
+}
+
+void turn(int16_t AngleVal){
+	float Target = -(AngleVal / DEGREE_2_STEP) * (M_PI / 180);	// in [rad], counterclockwise
+	float Error = wheel_error();
+	float Angle;
+
+#if HEADING_USE_GYRO == TRUE
+	Angle = closed_turn(AngleVal, Target, Error);
+#else
+	Run->Time += command_time(abs(AngleVal), NominalSpeed);
+	Angle = Target * (1 + Error);
+#endif
+
+	Run->Turns++;
+	Run->TurnError += fabsf(Angle - Target);
+	// Error to the nearest quarter of turn, the heading changes by 90 degrees (go_next_cell)
+	HeadingError += Angle - roundf(Target / SIM_QUARTER_TURN) * SIM_QUARTER_TURN;
+	MotorBusy = 1;
+	StepsDone = abs(AngleVal);
+}
+
+int16_t motor_wait_ready(void){
+	MotorBusy = 0;
+	return StepsDone;
+}
+
+/*** END FIRMWARE FUNCTIONS ***/
+
+/*** PUBLIC FUNCTIONS ***/
+
+uint32_t sim_random(uint32_t* State){
+	*State ^= *State << 13;
+	*State ^= *State >> 17;
+	*State ^= *State << 5;
+	return *State;
+}
+
+void maze_open(maze_t* Maze, uint8_t X, uint8_t Y, uint8_t Direction){
+	int16_t NextX = X;
+	int16_t NextY = Y;
+
+	Maze->Cell[Y * Maze->Header.Width + X] &= ~(1 << Direction);
+
+	neighbor(&NextX, &NextY, Direction);
+	if((NextX >= 0) && (NextY >= 0) && (NextX < Maze->Header.Width) && (NextY < Maze->Header.Height)){
+		Maze->Cell[NextY * Maze->Header.Width + NextX] &= ~(1 << ((Direction + 2) & 0x03));
+	}
+}
+
+uint8_t maze_walls(const maze_t* Maze, int16_t X, int16_t Y){
+	uint8_t Walls = NO_WALL;
+	int16_t NextX, NextY;
+
+	if((X >= 0) && (Y >= 0) && (X < Maze->Header.Width) && (Y < Maze->Header.Height)){
+		return Maze->Cell[Y * Maze->Header.Width + X] & WALL_B;
+	}
+
+	// Outside --> outer walls of the neighbors inside
+	for(uint8_t Dir = NORTH ; Dir <= WEST ; Dir++){
+		NextX = X;
+		NextY = Y;
+		neighbor(&NextX, &NextY, Dir);
+		if((NextX >= 0) && (NextY >= 0) && (NextX < Maze->Header.Width) && (NextY < Maze->Header.Height)
+				&& (Maze->Cell[NextY * Maze->Header.Width + NextX] & (1 << ((Dir + 2) & 0x03)))){
+			Walls |= 1 << Dir;
+		}
+	}
+	return Walls;
+}
+
+uint8_t maze_write(FILE* Corpus, const maze_t* Maze){
+	size_t Size = Maze->Header.Width * Maze->Header.Height;
+
+	return (fwrite(&Maze->Header, sizeof(Maze->Header), 1, Corpus) == 1)
+			&& (fwrite(Maze->Cell, 1, Size, Corpus) == Size);
+}
+
+uint8_t maze_read(FILE* Corpus, maze_t* Maze){
+	maze_header_t* Header = &Maze->Header;
+	size_t Size;
+
+	if(fread(Header, sizeof(*Header), 1, Corpus) != 1){
+		return 0;
+	}
+	if((Header->Magic != MAZE_MAGIC) || (Header->Kind >= MAZE_NB_KINDS)
+			|| (Header->Width < MAZE_MIN_SIZE) || (Header->Width > MAZE_MAX_SIZE)
+			|| (Header->Height < MAZE_MIN_SIZE) || (Header->Height > MAZE_MAX_SIZE)
+			|| (Header->StartX >= Header->Width) || (Header->StartY >= Header->Height)
+			|| (Header->StartHeading > WEST)){
+		return 0;
+	}
+
+	Size = Header->Width * Header->Height;
+	return fread(Maze->Cell, 1, Size, Corpus) == Size;
+}
+
+uint8_t sim_set_param(uint8_t Id, int32_t Value){
+	// Turns to the left are given as positive values, as in the namespace "maze"
+	if(((Id < SIM_IR_NOISE) && (Value <= 0)) || ((Id == PARAM_IMAGE_WIDTH) && (Value > IMAGE_BUFFER_SIZE))){
+		return 0;
+	}
+	// Only the error of the calibration and the bias of the gyro have a sign
+	if((Id >= SIM_IR_NOISE) && (Id != SIM_CALIBRATION) && (Id != SIM_GYRO_BIAS) && (Value < 0)){
+		return 0;
+	}
+	ParamValue[Id] = Value;
+	return 1;
+}
+
+void sim_run(const maze_t* MazeVal, uint8_t Solver, uint32_t Seed, sim_result_t* Result){
+	uint32_t MaxDecisions = SIM_MAX_DECISIONS * MazeVal->Header.Width * MazeVal->Header.Height;
+	uint8_t Outcome = SIM_RUNNING;
+
+	// Same state as after a reset of the e-puck, put at the start
+	Maze = MazeVal;
+	Run = Result;
+	PosX = Maze->Header.StartX;
+	PosY = Maze->Header.StartY;
+	Heading = Maze->Header.StartHeading;
+	NominalSpeed = ParamValue[SIM_NOMINAL_SPEED];
+	ExitStatus = SEARCHING;
+	for(uint16_t i = 0 ; i < (MAZE_MAX_SIZE * MAZE_MAX_SIZE) ; i++){
+		ColorVisited[i] = 0;
+	}
+	NbColorVisited = 0;
+	reset_orientation();
+	map_reset();
+
+	// Noise of the run, the light is the same for the whole run
+	NoiseState = Seed;
+	AlongError = 0;
+	LateralError = 0;
+	HeadingError = 0;
+	MotorBusy = 0;
+	for(uint8_t i = 0 ; i < 3 ; i++){
+		LightGain[i] = 1 + gaussian(ParamValue[SIM_LIGHT_SHIFT] / 100.0f);
+		if(LightGain[i] < 0){
+			LightGain[i] = 0;
+		}
+	}
+	SimTime = 0;
+	NextSample = 0;
+	heading_reset();
+
+	Result->Cells = 0;
+	Result->Turns = 0;
+	Result->Decisions = 0;
+	Result->Time = 0;
+	Result->BusyReads = 0;
+	Result->TurnError = 0;
+	visit_cell();
+	// Hands removed (wait_hands_removed), the bias is learnt meanwhile
+	stand_still(MODE_START_DELAY);
+
+	while(Outcome == SIM_RUNNING){
+		if(Result->Decisions >= MaxDecisions){
+			Outcome = SIM_TIMEOUT;
+			break;
+		}
+		Result->Decisions++;
+		Outcome = Solvers[Solver].Step();
+	}
+	Result->Outcome = Outcome;
+}
+
+void sim_stat_add(sim_stat_t* Stat, const sim_result_t* Result){
+	Stat->Runs++;
+	Stat->Outcome[Result->Outcome]++;
+	if(Result->Outcome == SIM_SUCCESS){
+		Stat->Cells += Result->Cells;
+		Stat->Turns += Result->Turns;
+		Stat->Time += Result->Time;
+		Stat->TurnError += Result->TurnError;
+	}
+}
+
+void sim_stat_print_header(FILE* Csv){
+	fprintf(Csv, ",runs,success_rate,cells,turns,time_s,turn_error_mrad");
+	for(uint8_t n = SIM_SUCCESS + 1 ; n < SIM_NB_OUTCOMES ; n++){
+		fprintf(Csv, ",%s", OutcomeName[n]);
+	}
+}
+
+void sim_stat_print(FILE* Csv, const sim_stat_t* Stat){
+	unsigned long Success = Stat->Outcome[SIM_SUCCESS];
+
+	fprintf(Csv, ",%lu,%.3f,%.2f,%.2f,%.2f,%.2f", Stat->Runs,
+			Stat->Runs ? (double)Success / Stat->Runs : 0.0,
+			Success ? (double)Stat->Cells / Success : 0.0,
+			Success ? (double)Stat->Turns / Success : 0.0,
+			Success ? Stat->Time / Success : 0.0,
+			Stat->Turns ? 1000 * Stat->TurnError / Stat->Turns : 0.0);
+	for(uint8_t n = SIM_SUCCESS + 1 ; n < SIM_NB_OUTCOMES ; n++){
+		fprintf(Csv, ",%lu", Stat->Outcome[n]);
+	}
+}
+
+uint8_t sim_param_id(const char* Name){
+	uint8_t Id;
+
+	for(Id = 0 ; Id < SIM_NB_PARAMS ; Id++){
+		if(!strcmp(Name, ParamName[Id])){
+			break;
+		}
+	}
+	return Id;
+}
+
+const char* sim_param_name(uint8_t Id){
+	return ParamName[Id];
+}
+
+const char* sim_solver_name(uint8_t Solver){
+	return Solvers[Solver].Name;
+}
+
+const char* sim_outcome_name(uint8_t Outcome){
+	return OutcomeName[Outcome];
+}
+
+const char* maze_kind_name(uint8_t Kind){
+	return KindName[Kind];
+}
+
+/*** END PUBLIC FUNCTIONS ***/
@@ -0,0 +1,210 @@
+/**
+ * @file	MazeSim.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Public prototypes of the maze simulator of the host tools.
+ * 			A maze of a corpus file, an e-puck moving cell by cell in it and
+ * 			 the solving modes of main.c run on the firmware sources (HOST_BUILD).
+ * 			Define for the corpus format, the sensor models and the results.
+ */
+
+#ifndef MAZESIM_H_
+#define MAZESIM_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <MazeParameters.h>
+
+// Corpus define
+#define MAZE_MAGIC			0x4D	// 'M', first byte of every maze of a corpus
+#define MAZE_MAX_SIZE		8		// cells per side, the map of the firmware fits it from any start
+#define MAZE_MIN_SIZE		2		// cells per side
+// Kind define
+#define MAZE_PERFECT		0		// one path between two cells (no loop)
+#define MAZE_BRAIDED		1		// loops, some cells are not connected to the outer wall
+#define MAZE_ROOMS			2		// open rooms without inner walls
+#define MAZE_NB_KINDS		3
+// Sensor model define
+#define SIM_PROX_WALL		400		// IR value of a wall at half a cell (FRONT_WALL_TARGET)
+#define SIM_PROX_DIAGONAL	150		// IR2 and IR7 value of a front or side wall
+#define SIM_PROX_FREE		20		// IR value without wall (ambient light)
+#define SIM_PIXEL_LIT		31		// RGB565 red or blue value of a lit color (5 bits)
+#define SIM_PIXEL_DARK		8		// RGB565 red or blue value of an unlit color (5 bits)
+// Parameter define, after the runtime parameters of the firmware (PARAM_ONE_CELL, ...)
+#define SIM_NOMINAL_SPEED	PARAM_NB		// in [step/s], NominalSpeed at start, default NOMINAL_SPEED
+#define SIM_CORRECTION_SPEED (PARAM_NB + 1)	// in [step/s], change of the red and green cells, default CORRECTION_SPEED
+// Noise define, parameters of the noise models, 0 by default (no noise)
+#define SIM_IR_NOISE		(PARAM_NB + 2)	// standard deviation of every IR value
+#define SIM_IR_CROSSTALK	(PARAM_NB + 3)	// in [%], of the two neighbor IR sensors added to a value
+#define SIM_LIGHT_SHIFT		(PARAM_NB + 4)	// in [%], standard deviation of the gain of each color, drawn per run
+#define SIM_PIXEL_NOISE		(PARAM_NB + 5)	// in [%] of the full scale, standard deviation of every pixel
+#define SIM_WHEEL_SLIP		(PARAM_NB + 6)	// in [per mille], standard deviation of the distance of a wheel per command
+#define SIM_CALIBRATION		(PARAM_NB + 7)	// in [per mille], error of MM_2_STEP and DEGREE_2_STEP, positive --> too far
+#define SIM_GYRO_BIAS		(PARAM_NB + 8)	// in [mrad/s], bias left by calibrate_gyro(), counterclockwise is positive
+#define SIM_GYRO_NOISE		(PARAM_NB + 9)	// in [mrad/s], standard deviation of every gyro sample
+#define SIM_NB_PARAMS		(PARAM_NB + 10)
+// Solver define (index in the table)
+#define SIM_LEFT_WALL		0		// Selector = 0
+#define SIM_PLEDGE			1		// Selector = 1
+#define SIM_ROUTE			2		// Selector = 5, success once all colored cells are visited
+#define SIM_NB_SOLVERS		3
+// Outcome define
+#define SIM_SUCCESS			0		// out of the maze (SIM_ROUTE: route done through all colored cells)
+#define SIM_FALSE_EXIT		1		// exit found inside the maze (no wall around)
+#define SIM_BLOCKED			2		// four walls around
+#define SIM_CRASHED			3		// moved into a wall, or too close to a side wall
+#define SIM_TIMEOUT			4		// more than SIM_MAX_DECISIONS decisions per cell
+#define SIM_INCOMPLETE		5		// SIM_ROUTE: route done, a colored cell has been missed
+#define SIM_NB_OUTCOMES		6
+#define SIM_MAX_DECISIONS	16		// per cell of the maze
+
+
+/*** Structure ***/
+// Header of every maze of a corpus file, little endian
+typedef struct __attribute__((packed)) maze_header_s{
+	uint8_t Magic;			// MAZE_MAGIC
+	uint8_t Kind;			// MAZE_PERFECT, MAZE_BRAIDED or MAZE_ROOMS
+	uint8_t Width;			// in [cells]
+	uint8_t Height;			// in [cells]
+	uint8_t StartX;
+	uint8_t StartY;
+	uint8_t StartHeading;	// NORTH, EAST, SOUTH or WEST
+	uint8_t NbColors;		// number of red, green or blue cells
+	uint32_t Seed;			// the maze is generated again from it
+} maze_header_t;
+
+/* A maze is the header followed by Width*Height cells, row by row from the south.
+ * Each cell uses the same bits as the map of the firmware (MazeMap.c).
+ * 		Bit 0 --> north wall
+ * 		Bit 1 --> east wall
+ * 		Bit 2 --> south wall
+ * 		Bit 3 --> west wall
+ * 		Bits 4 to 6 --> color of the floor, 0 for a white floor
+ * The exit is a border cell without its outer wall.
+ */
+typedef struct maze_s{
+	maze_header_t Header;
+	uint8_t Cell[MAZE_MAX_SIZE * MAZE_MAX_SIZE];
+} maze_t;
+
+typedef struct sim_result_s{
+	uint8_t Outcome;		// SIM_SUCCESS, SIM_FALSE_EXIT, ...
+	uint16_t Cells;			// cells travelled
+	uint16_t Turns;			// turn commands, spins of the blue cells included
+	uint16_t Decisions;		// steps of the solving mode
+	float Time;				// in [s], simulated time of the motor commands
+	uint16_t BusyReads;		// front walls squared up to while a turn was still running
+	float TurnError;		// in [rad], sum over the turns of the error of the real angle
+} sim_result_t;
+
+typedef struct sim_stat_s{
+	unsigned long Runs;
+	unsigned long Outcome[SIM_NB_OUTCOMES];
+	unsigned long Cells;	// sums over the successful runs
+	unsigned long Turns;
+	double Time;			// in [s]
+	double TurnError;		// in [rad]
+} sim_stat_t;
+
+
+/**
+ * @brief	Returns the next value of a xorshift generator, the same
+ * 			 sequence on every host for the same state.
+ *
+ * @param [in/out] State	State of the generator, not 0
+ */
+uint32_t sim_random(uint32_t* State);
+
+/**
+ * @brief	Removes a wall of a cell, also from its neighbor inside the maze.
+ *
+ * @param Direction		NORTH, EAST, SOUTH or WEST
+ */
+void maze_open(maze_t* Maze, uint8_t X, uint8_t Y, uint8_t Direction);
+
+/**
+ * @brief	Returns the walls around any cell in the absolute frame,
+ * 			 outside of the maze only its outer walls are seen.
+ */
+uint8_t maze_walls(const maze_t* Maze, int16_t X, int16_t Y);
+
+/**
+ * @brief	Writes a maze at the end of a corpus file.
+ *
+ * @return	1 if written, 0 otherwise
+ */
+uint8_t maze_write(FILE* Corpus, const maze_t* Maze);
+
+/**
+ * @brief	Reads the next maze of a corpus file.
+ *
+ * @return	1 if a maze has been read, 0 at the end of the corpus or if it is invalid
+ */
+uint8_t maze_read(FILE* Corpus, maze_t* Maze);
+
+/**
+ * @brief	Sets a parameter of the simulated e-puck (PARAM_ONE_CELL, ..., SIM_CORRECTION_SPEED),
+ * 			 the defaults of the firmware are used otherwise.
+ *
+ * @return	1 if set, 0 if the simulation can't use the value (not positive, image too wide, negative noise)
+ */
+uint8_t sim_set_param(uint8_t Id, int32_t Value);
+
+/**
+ * @brief	Returns the Id of a parameter from its name, as in the namespace "maze"
+ * 			 of the firmware ("one_cell", ...), SIM_NB_PARAMS if unknown.
+ */
+uint8_t sim_param_id(const char* Name);
+
+/**
+ * @brief	Returns the name of a parameter for the reports.
+ */
+const char* sim_param_name(uint8_t Id);
+
+/**
+ * @brief	Runs one solving mode from the start of a maze until it stops.
+ * 			The e-puck is reset before (orientation, map, nominal speed, offset).
+ *
+ * @param Solver	SIM_LEFT_WALL, SIM_PLEDGE or SIM_ROUTE
+ * @param Seed		Seed of the noise models, not 0. The same seed gives the same run.
+ */
+void sim_run(const maze_t* Maze, uint8_t Solver, uint32_t Seed, sim_result_t* Result);
+
+/**
+ * @brief	Adds a run to the statistics of a solver.
+ */
+void sim_stat_add(sim_stat_t* Stat, const sim_result_t* Result);
+
+/**
+ * @brief	Writes the CSV columns of sim_stat_print(), each one after a comma:
+ * 			 runs, success rate, then cells, turns and time-to-exit as means over
+ * 			 the successful runs, the mean error of their turns, then the count of every failure.
+ */
+void sim_stat_print_header(FILE* Csv);
+
+/**
+ * @brief	Writes the statistics of a solver as CSV columns, each one after a comma.
+ */
+void sim_stat_print(FILE* Csv, const sim_stat_t* Stat);
+
+/**
+ * @brief	Returns the name of a solver for the reports.
+ */
+const char* sim_solver_name(uint8_t Solver);
+
+/**
+ * @brief	Returns the name of an outcome for the reports.
+ */
+const char* sim_outcome_name(uint8_t Outcome);
+
+/**
+ * @brief	Returns the name of a kind of maze for the reports.
+ */
+const char* maze_kind_name(uint8_t Kind);
+
+#endif /* MAZESIM_H_ */
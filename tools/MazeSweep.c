@@ -0,0 +1,323 @@
+/**
+ * @file	MazeSweep.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which sweeps parameters of the simulated e-puck over a corpus of MazeGen,
+ * 			 on all the cores, and writes a CSV summary per point of the sweep and per mode.
+ * 			The firmware keeps its state in static variables (EPuckOrientation, the map, ...),
+ * 			 so the runs are shared between processes and not threads: every worker has its own
+ * 			 copy of the statics, reset by sim_run(). The workers take the next runs from
+ * 			 a queue in shared memory as soon as they are done, the slowest mazes don't stall
+ * 			 the other cores. The results are the same for any number of workers.
+ * 			With the noise models, every maze is run several times (-r) with other seeds
+ * 			 of the noise, the seeds only depend on the maze and the repeat.
+ *
+ * 			Build:	make MazeSweep
+ * 			Usage:	./MazeSweep [-j jobs] [-r repeats] <corpus> <name>=<first>[:<last>[:<step>]] ... > sweep.csv
+ * 					./MazeSweep bench.maz prox_threshold=40:400:20 color_threshold=50:90:4 > sweep.csv
+ * 					./MazeSweep -r 4 bench.maz ir_noise=0:200:20 > robustness.csv
+ * 					make robustness									(sweeps of every noise)
+ * 			Names:	one_cell, left_turn, right_turn, backward_turn, one_turn, prox_threshold,
+ * 					image_width, color_threshold (namespace "maze"), nominal_speed, correction_speed,
+ * 					ir_noise, ir_crosstalk, light_shift, pixel_noise, wheel_slip, calibration,
+ * 					gyro_bias, gyro_noise (noise)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "MazeSim.h"
+
+// Sweep define
+#define MAX_SWEPT			4		// parameters swept together
+#define MAX_POINTS			10000	// points of the sweep (product of the values)
+#define TASK_CHUNK			4		// mazes taken at once from the queue
+#define MAX_REPEATS			100		// runs of a maze with other seeds of the noise
+#define SEED_MULTIPLIER		2654435761u		// spreads the seeds of the repeats (Knuth)
+
+
+/*** STATIC VARIABLES ***/
+typedef struct sweep_range_s{
+	uint8_t Id;
+	int32_t First;
+	int32_t Step;
+	uint32_t NbValues;
+} sweep_range_t;
+
+// Queue in shared memory, a task is one run of a maze at one point of the sweep
+typedef struct sweep_queue_s{
+	uint32_t Next;
+} sweep_queue_t;
+
+static sweep_range_t Range[MAX_SWEPT];
+static uint8_t NbSwept 		= 0;
+static uint32_t NbPoints 	= 1;
+static maze_t* Mazes 		= NULL;
+static uint32_t NbMazes 	= 0;
+static uint32_t NbRepeats 	= 1;
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Reads a range "<name>=<first>[:<last>[:<step>]]".
+ *
+ * @return	1 if valid, 0 otherwise
+ */
+static uint8_t parse_range(const char* Arg, sweep_range_t* Swept){
+	char Name[32];
+	int First, Last, Step = 1;
+	int NbRead = sscanf(Arg, "%31[^=]=%d:%d:%d", Name, &First, &Last, &Step);
+
+	if(NbRead < 2){
+		return 0;
+	}
+	if(NbRead == 2){
+		Last = First;
+	}
+
+	Swept->Id = sim_param_id(Name);
+	if((Swept->Id == SIM_NB_PARAMS) || (Step <= 0) || (Last < First)){
+		return 0;
+	}
+	Swept->First = First;
+	Swept->Step = Step;
+	Swept->NbValues = (Last - First) / Step + 1;
+	return 1;
+}
+
+/**
+ * @brief	Returns the value of a swept parameter at a point of the sweep,
+ * 			 the first parameter changes the slowest.
+ */
+static int32_t point_value(uint32_t Point, uint8_t Swept){
+	for(int8_t n = NbSwept - 1 ; n > Swept ; n--){
+		Point /= Range[n].NbValues;
+	}
+	return Range[Swept].First + (int32_t)(Point % Range[Swept].NbValues) * Range[Swept].Step;
+}
+
+/**
+ * @brief	Sets the parameters of a point of the sweep.
+ *
+ * @return	1 if the simulation can use all the values, 0 otherwise
+ */
+static uint8_t apply_point(uint32_t Point){
+	uint8_t Valid = 1;
+
+	for(uint8_t n = 0 ; n < NbSwept ; n++){
+		Valid &= sim_set_param(Range[n].Id, point_value(Point, n));
+	}
+	return Valid;
+}
+
+/**
+ * @brief	Loads all the mazes of a corpus.
+ *
+ * @return	1 if the whole corpus is valid, 0 otherwise
+ */
+static uint8_t load_corpus(const char* Name){
+	FILE* Corpus = fopen(Name, "rb");
+	maze_t Maze;
+	uint32_t Capacity = 0;
+
+	if(Corpus == NULL){
+		perror(Name);
+		return 0;
+	}
+	while(maze_read(Corpus, &Maze)){
+		if(NbMazes == Capacity){
+			Capacity = Capacity ? 2 * Capacity : 256;
+			Mazes = realloc(Mazes, Capacity * sizeof(maze_t));
+			if(Mazes == NULL){
+				perror("realloc");
+				fclose(Corpus);
+				return 0;
+			}
+		}
+		Mazes[NbMazes++] = Maze;
+	}
+	if(!feof(Corpus) || !NbMazes){
+		fprintf(stderr, "%s: invalid maze %u\n", Name, NbMazes);
+		fclose(Corpus);
+		return 0;
+	}
+	fclose(Corpus);
+	return 1;
+}
+
+/**
+ * @brief	Returns the seed of the noise of one repeat of a maze, never 0 (xorshift).
+ */
+static uint32_t noise_seed(uint32_t MazeSeed, uint32_t Repeat){
+	uint32_t Seed = MazeSeed ^ ((Repeat + 1) * SEED_MULTIPLIER);
+
+	return Seed ? Seed : 1;
+}
+
+/**
+ * @brief	Worker process: runs the tasks of the queue until it is empty.
+ * 			The results are written in shared memory, one per task and solver.
+ */
+static void run_worker(sweep_queue_t* Queue, sim_result_t* Results){
+	uint32_t NbRuns = NbMazes * NbRepeats;
+	uint32_t NbTasks = NbPoints * NbRuns;
+	uint32_t Task, Last, Point;
+	maze_t* Maze;
+	uint32_t AppliedPoint = NbPoints;
+
+	while((Task = __atomic_fetch_add(&Queue->Next, TASK_CHUNK, __ATOMIC_RELAXED)) < NbTasks){
+		Last = (Task + TASK_CHUNK < NbTasks) ? Task + TASK_CHUNK : NbTasks;
+		for( ; Task < Last ; Task++){
+			Point = Task / NbRuns;
+			Maze = &Mazes[(Task % NbRuns) / NbRepeats];
+			if(Point != AppliedPoint){
+				apply_point(Point);
+				AppliedPoint = Point;
+			}
+			for(uint8_t Solver = 0 ; Solver < SIM_NB_SOLVERS ; Solver++){
+				sim_run(Maze, Solver, noise_seed(Maze->Header.Seed, Task % NbRepeats), &Results[(size_t)Task * SIM_NB_SOLVERS + Solver]);
+			}
+		}
+	}
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** MAIN ***/
+int main(int argc, char* argv[]){
+	long NbJobs = sysconf(_SC_NPROCESSORS_ONLN);
+	sweep_queue_t* Queue;
+	sim_result_t* Results;
+	size_t ResultSize;
+	sim_stat_t Stat;
+	struct timespec Start, End;
+	double Elapsed;
+	uint32_t NbRuns;
+	int Status, Failed = 0;
+	int Arg, Option;
+
+	while((Option = getopt(argc, argv, "j:r:")) != -1){
+		switch (Option) {
+		case 'j':
+			NbJobs = strtol(optarg, NULL, 0);
+			break;
+		case 'r':
+			NbRepeats = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			NbJobs = 0;
+			break;
+		}
+	}
+	Arg = optind;
+	if((argc - Arg < 2) || (argc - Arg - 1 > MAX_SWEPT) || (NbJobs < 1) || (NbRepeats < 1) || (NbRepeats > MAX_REPEATS)){
+		fprintf(stderr, "usage: %s [-j jobs] [-r repeats] <corpus> <name>=<first>[:<last>[:<step>]] ... (at most %u) > sweep.csv\n",
+				argv[0], MAX_SWEPT);
+		return 1;
+	}
+
+	if(!load_corpus(argv[Arg++])){
+		return 1;
+	}
+
+	for( ; Arg < argc ; Arg++){
+		if(!parse_range(argv[Arg], &Range[NbSwept])){
+			fprintf(stderr, "invalid range: %s\n", argv[Arg]);
+			return 1;
+		}
+		NbPoints *= Range[NbSwept++].NbValues;
+		if(NbPoints > MAX_POINTS){
+			fprintf(stderr, "more than %u points\n", MAX_POINTS);
+			return 1;
+		}
+	}
+	for(uint32_t Point = 0 ; Point < NbPoints ; Point++){
+		if(!apply_point(Point)){
+			fprintf(stderr, "point %u out of what the simulation supports\n", Point);
+			return 1;
+		}
+	}
+
+	// Shared by the workers, inherited through fork()
+	NbRuns = NbMazes * NbRepeats;
+	// The queue counts the tasks on 32 bits
+	if((uint64_t)NbPoints * NbRuns + TASK_CHUNK > UINT32_MAX){
+		fprintf(stderr, "too many runs, fewer points or repeats\n");
+		return 1;
+	}
+	ResultSize = (size_t)NbPoints * NbRuns * SIM_NB_SOLVERS * sizeof(sim_result_t);
+	Queue = mmap(NULL, sizeof(sweep_queue_t) + ResultSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(Queue == MAP_FAILED){
+		perror("mmap");
+		return 1;
+	}
+	Queue->Next = 0;
+	Results = (sim_result_t*)(Queue + 1);
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for(long n = 0 ; n < NbJobs ; n++){
+		switch (fork()) {
+		case -1:
+			perror("fork");
+			Failed = 1;
+			break;
+		case 0:
+			run_worker(Queue, Results);
+			_exit(0);
+		default:
+			break;
+		}
+	}
+	while(wait(&Status) > 0){
+		if(!WIFEXITED(Status) || WEXITSTATUS(Status)){
+			Failed = 1;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+
+	// A task left by a failed worker would bias the summary
+	if(Failed || (Queue->Next < NbPoints * NbRuns)){
+		fprintf(stderr, "a worker failed, no summary\n");
+		return 1;
+	}
+
+	for(uint8_t n = 0 ; n < NbSwept ; n++){
+		printf("%s,", sim_param_name(Range[n].Id));
+	}
+	printf("solver");
+	sim_stat_print_header(stdout);
+	printf("\n");
+
+	for(uint32_t Point = 0 ; Point < NbPoints ; Point++){
+		for(uint8_t Solver = 0 ; Solver < SIM_NB_SOLVERS ; Solver++){
+			memset(&Stat, 0, sizeof(Stat));
+			for(uint32_t Run = 0 ; Run < NbRuns ; Run++){
+				sim_stat_add(&Stat, &Results[((size_t)Point * NbRuns + Run) * SIM_NB_SOLVERS + Solver]);
+			}
+			for(uint8_t n = 0 ; n < NbSwept ; n++){
+				printf("%d,", (int)point_value(Point, n));
+			}
+			printf("%s", sim_solver_name(Solver));
+			sim_stat_print(stdout, &Stat);
+			printf("\n");
+		}
+	}
+
+	Elapsed = (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9;
+	fprintf(stderr, "%lu runs on %ld processes in %.2f s (%.0f runs/s)\n",
+			(unsigned long)NbPoints * NbRuns * SIM_NB_SOLVERS, NbJobs, Elapsed,
+			NbPoints * NbRuns * SIM_NB_SOLVERS / Elapsed);
+
+	return 0;
+}
+/*** END MAIN ***/
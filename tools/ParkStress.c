@@ -0,0 +1,373 @@
+/**
+ * @file	ParkStress.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host stress test of the park and unpark of the threads (ThreadPark.c),
+ * 			 compiled with the kernel of host/ch.h defined here on POSIX threads.
+ * 			The workers run the loop of a parkable thread of the firmware. The requesters:
+ * 			 - park_cycles: one requester as ModeManager, every state waited for.
+ * 			   A parked worker must not run, a woken worker must run again.
+ * 			 - early_wakes: one requester asks for the wakeup before the sleep is
+ * 			   acknowledged, every wakeup must be acknowledged in time.
+ * 			 - random_requests: several requesters on several workers at random. The
+ * 			   acknowledge goes to the last requester, the others may time out (only
+ * 			   counted). Every worker must then wake up and park again.
+ * 			Writes one line per case and returns 1 if a case fails, a watchdog ends
+ * 			 the test if a thread is stuck.
+ *
+ * 			Build:	make ParkStress		(gcc -O2 -DHOST_BUILD -DHOST_KERNEL -pthread -I.. -Ihost -o ParkStress ParkStress.c ../ThreadPark.c)
+ * 			Usage:	./ParkStress
+ * 					make check
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <main.h>
+#include <ThreadPark.h>
+
+// Stress define
+#define STRESS_WORKERS		3
+#define STRESS_REQUESTERS	3
+#define STRESS_CYCLES		200		// sleep and wakeup waited for, per worker
+#define STRESS_EARLY_WAKES	20000	// wakeups before the sleep acknowledge
+#define STRESS_REQUESTS		5000	// random requests per requester
+#define STRESS_SHORT_WAIT	2		// in [ms], wait of the random requests
+#define STRESS_HOLD			2		// in [ms], a parked worker must not run meanwhile
+#define STRESS_WATCHDOG		60		// in [s]
+
+
+/*** STATIC VARIABLES ***/
+struct host_thread_s{
+	pthread_t Id;
+	pthread_cond_t Cond;
+	eventmask_t Pending;		// guarded by KernelLock
+};
+
+typedef struct worker_s{
+	thread_t Thd;
+	thd_metadata_t MetaData;
+	volatile unsigned long Work;	// loops done awake
+	volatile uint8_t Stop;
+} worker_t;
+
+typedef struct requester_s{
+	thread_t Thd;
+	uint32_t Seed;
+	unsigned long Timeouts;
+} requester_t;
+
+static pthread_mutex_t KernelLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread thread_t *Self = NULL;
+static struct timespec Boot;
+static thread_t MainThd;
+static worker_t Worker[STRESS_WORKERS];
+static requester_t Requester[STRESS_REQUESTERS];
+
+
+/*** KERNEL FUNCTIONS ***/
+// Kernel of host/ch.h, one mutex is the lock of the kernel
+
+void chSysLock(void){
+	pthread_mutex_lock(&KernelLock);
+}
+
+void chSysUnlock(void){
+	pthread_mutex_unlock(&KernelLock);
+}
+
+void chSchRescheduleS(void){
+	pthread_mutex_unlock(&KernelLock);
+	sched_yield();
+	pthread_mutex_lock(&KernelLock);
+}
+
+void chEvtSignalI(thread_t *tp, eventmask_t events){
+	tp->Pending |= events;
+	pthread_cond_signal(&tp->Cond);
+}
+
+eventmask_t chEvtWaitAny(eventmask_t events){
+	eventmask_t Received;
+
+	pthread_mutex_lock(&KernelLock);
+	while(!(Self->Pending & events)){
+		pthread_cond_wait(&Self->Cond, &KernelLock);
+	}
+	Received = Self->Pending & events;
+	Self->Pending &= ~Received;
+	pthread_mutex_unlock(&KernelLock);
+
+	return Received;
+}
+
+eventmask_t chEvtWaitAnyTimeout(eventmask_t events, systime_t timeout){
+	struct timespec Deadline;
+	eventmask_t Received;
+
+	clock_gettime(CLOCK_MONOTONIC, &Deadline);
+	Deadline.tv_sec += ST2MS(timeout) / 1000;
+	Deadline.tv_nsec += (ST2MS(timeout) % 1000) * 1000000L;
+	if(Deadline.tv_nsec >= 1000000000L){
+		Deadline.tv_sec++;
+		Deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&KernelLock);
+	while(!(Self->Pending & events) && (timeout != TIME_IMMEDIATE)){
+		if(pthread_cond_timedwait(&Self->Cond, &KernelLock, &Deadline) == ETIMEDOUT){
+			break;
+		}
+	}
+	Received = Self->Pending & events;
+	Self->Pending &= ~Received;
+	pthread_mutex_unlock(&KernelLock);
+
+	return Received;
+}
+
+thread_t *chThdGetSelfX(void){
+	return Self;
+}
+
+systime_t chVTGetSystemTime(void){
+	struct timespec Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (systime_t)((Now.tv_sec - Boot.tv_sec) * 1000 + (Now.tv_nsec - Boot.tv_nsec) / 1000000);
+}
+
+/*** END KERNEL FUNCTIONS ***/
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Prepares a thread of the kernel, before it runs.
+ */
+static void thread_init(thread_t *Thd){
+	pthread_condattr_t Attr;
+
+	pthread_condattr_init(&Attr);
+	pthread_condattr_setclock(&Attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&Thd->Cond, &Attr);
+	pthread_condattr_destroy(&Attr);
+	Thd->Pending = 0;
+}
+
+/**
+ * @brief	Ends the test if a thread is stuck.
+ */
+static void watchdog(int Signal){
+	static const char Message[] = "watchdog: FAIL, a thread is stuck\n";
+
+	(void)Signal;
+	if(write(STDOUT_FILENO, Message, sizeof(Message) - 1) < 0){
+		_exit(1);
+	}
+	_exit(1);
+}
+
+/**
+ * @brief	Loop of a parkable thread of the firmware, one unit of work per period.
+ */
+static void *worker_thread(void *Arg){
+	worker_t *W = Arg;
+	systime_t Time;
+
+	Self = &W->Thd;
+	while(!W->Stop){
+		if(park_requested(&W->MetaData)){
+			park_self(&W->MetaData);
+		}
+		Time = chVTGetSystemTime();
+		W->Work++;
+		park_sleep_until(0, Time, Time + MS2ST(1));
+	}
+	return NULL;
+}
+
+/**
+ * @brief	Requests at random on all the workers, only the count of timeouts is kept.
+ */
+static void *requester_thread(void *Arg){
+	requester_t *R = Arg;
+	worker_t *W;
+
+	Self = &R->Thd;
+	for(uint32_t i = 0 ; i < STRESS_REQUESTS ; i++){
+		R->Seed = R->Seed * 1103515245 + 12345;
+		W = &Worker[(R->Seed >> 16) % STRESS_WORKERS];
+		park_request(&W->MetaData, ((R->Seed >> 8) & 1) ? SLEEP_MODE : AWAKE_MODE);
+		// Some requests aren't waited for, the next one arrives before the acknowledge
+		if((R->Seed >> 12) & 1){
+			if(park_wait_ack(&W->MetaData, MS2ST(STRESS_SHORT_WAIT)) != MSG_OK){
+				R->Timeouts++;
+			}
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief	Returns 1 if the worker runs within PARK_TIMEOUT.
+ */
+static uint8_t worker_runs(const worker_t *W){
+	unsigned long Work = W->Work;
+	systime_t Start = chVTGetSystemTime();
+
+	while((chVTGetSystemTime() - Start) < MS2ST(PARK_TIMEOUT)){
+		if(W->Work != Work){
+			return 1;
+		}
+		sched_yield();
+	}
+	return 0;
+}
+
+/**
+ * @brief	Parks and wakes a worker up, each state waited for and checked.
+ *
+ * @return	Description of the first error, NULL if none
+ */
+static const char *park_cycle(worker_t *W){
+	unsigned long Work;
+
+	park_request(&W->MetaData, SLEEP_MODE);
+	if(park_wait_ack(&W->MetaData, MS2ST(PARK_TIMEOUT)) != MSG_OK){
+		return "sleep not acknowledged";
+	}
+	Work = W->Work;
+	usleep(STRESS_HOLD * 1000);
+	if(W->Work != Work){
+		return "parked worker ran";
+	}
+
+	park_request(&W->MetaData, AWAKE_MODE);
+	if(park_wait_ack(&W->MetaData, MS2ST(PARK_TIMEOUT)) != MSG_OK){
+		return "wakeup not acknowledged";
+	}
+	if(!worker_runs(W)){
+		return "woken worker doesn't run";
+	}
+	return NULL;
+}
+
+/**
+ * @brief	Case park_cycles, as ModeManager between two modes.
+ */
+static uint8_t check_park_cycles(void){
+	const char *Error = NULL;
+
+	for(uint8_t w = 0 ; (w < STRESS_WORKERS) && !Error ; w++){
+		for(uint16_t i = 0 ; (i < STRESS_CYCLES) && !Error ; i++){
+			Error = park_cycle(&Worker[w]);
+		}
+	}
+	printf("park_cycles: %s\n", Error ? Error : "ok");
+	return Error == NULL;
+}
+
+/**
+ * @brief	Case early_wakes, the wakeup overtakes the sleep at every point of park_self().
+ */
+static uint8_t check_early_wakes(void){
+	worker_t *W = &Worker[0];
+	const char *Error = NULL;
+
+	for(uint32_t i = 0 ; (i < STRESS_EARLY_WAKES) && !Error ; i++){
+		park_request(&W->MetaData, SLEEP_MODE);
+		// Lets the worker go further in park_self() every other time
+		if(i & 1){
+			sched_yield();
+		}
+		park_request(&W->MetaData, AWAKE_MODE);
+		if(park_wait_ack(&W->MetaData, MS2ST(PARK_TIMEOUT)) != MSG_OK){
+			Error = "wakeup not acknowledged";
+		}
+	}
+	if(!Error && !worker_runs(W)){
+		Error = "woken worker doesn't run";
+	}
+	printf("early_wakes: %s\n", Error ? Error : "ok");
+	return Error == NULL;
+}
+
+/**
+ * @brief	Case random_requests, then every worker is woken up by one requester.
+ */
+static uint8_t check_random_requests(void){
+	const char *Error = NULL;
+	unsigned long Timeouts = 0;
+
+	for(uint8_t r = 0 ; r < STRESS_REQUESTERS ; r++){
+		thread_init(&Requester[r].Thd);
+		Requester[r].Seed = r + 1;
+		Requester[r].Timeouts = 0;
+		pthread_create(&Requester[r].Thd.Id, NULL, requester_thread, &Requester[r]);
+	}
+	for(uint8_t r = 0 ; r < STRESS_REQUESTERS ; r++){
+		pthread_join(Requester[r].Thd.Id, NULL);
+		Timeouts += Requester[r].Timeouts;
+	}
+
+	// No request may be lost: one requester again, as in the firmware
+	for(uint8_t w = 0 ; (w < STRESS_WORKERS) && !Error ; w++){
+		park_request(&Worker[w].MetaData, AWAKE_MODE);
+		if(park_wait_ack(&Worker[w].MetaData, MS2ST(PARK_TIMEOUT)) != MSG_OK){
+			Error = "final wakeup not acknowledged";
+		}else if(!worker_runs(&Worker[w])){
+			Error = "woken worker doesn't run";
+		}else{
+			Error = park_cycle(&Worker[w]);
+		}
+	}
+	printf("random_requests: %s, %lu waits of other requesters timed out\n", Error ? Error : "ok", Timeouts);
+	return Error == NULL;
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+
+/*** MAIN ***/
+int main(void){
+	uint8_t Pass = 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &Boot);
+	signal(SIGALRM, watchdog);
+	alarm(STRESS_WATCHDOG);
+
+	thread_init(&MainThd);
+	Self = &MainThd;
+
+	for(uint8_t w = 0 ; w < STRESS_WORKERS ; w++){
+		thread_init(&Worker[w].Thd);
+		Worker[w].MetaData = (thd_metadata_t){.Request = AWAKE_MODE, .Sleep = AWAKE_MODE};
+		park_init(&Worker[w].MetaData, &Worker[w].Thd);
+		pthread_create(&Worker[w].Thd.Id, NULL, worker_thread, &Worker[w]);
+	}
+
+	Pass &= check_park_cycles();
+	Pass &= check_early_wakes();
+	Pass &= check_random_requests();
+
+	// Workers are awake, the stop ends their wait
+	for(uint8_t w = 0 ; w < STRESS_WORKERS ; w++){
+		Worker[w].Stop = 1;
+		chSysLock();
+		chEvtSignalI(&Worker[w].Thd, PARK_EVT);
+		chSysUnlock();
+		pthread_join(Worker[w].Thd.Id, NULL);
+	}
+
+	return Pass ? 0 : 1;
+}
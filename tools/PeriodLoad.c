@@ -0,0 +1,200 @@
+/**
+ * @file	PeriodLoad.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which runs the overload scenario of GenerateLoad (LOAD_KEY) on a model
+ * 			 of the scheduler, with the period statistics of SystemMonitor.c (HOST_BUILD).
+ * 			The model runs the periodic threads and GenerateLoad with their priorities on
+ * 			 a clock of 1 us: a higher priority preempts at once, the threads of the same
+ * 			 priority share the CPU by round robin every CH_CFG_TIME_QUANTUM ticks.
+ * 			 A periodic thread ticks its period monitor when it runs again, does its work
+ * 			 then sleeps until its next period. GenerateLoad is busy LoadLevel percent
+ * 			 of each LOAD_PERIOD of system time, as in the firmware.
+ * 			The other threads and the interrupts are not modelled, the work of each
+ * 			 thread is an estimate (MODEL_*_WORK).
+ * 			Writes the TLM_PERIOD records of every load level as CSV, the periods in [us].
+ *
+ * 			Build:	make PeriodLoad		(gcc -O2 -DHOST_BUILD -I.. -Ihost -o PeriodLoad PeriodLoad.c ../SystemMonitor.c)
+ * 			Usage:	./PeriodLoad > overload.csv
+ * 					make overload
+ */
+
+#include <stdio.h>
+
+#include <main.h>
+#include <SystemMonitor.h>
+#include <Telemetry.h>
+#include <LatencyProbe.h>
+
+// Model define
+#define MODEL_QUANTUM			20		// in [ticks] of 1 ms, CH_CFG_TIME_QUANTUM of chconf.h
+#define MODEL_DURATION			10		// in [s], of every load level, then one report
+#define MODEL_CONTROL_WORK		20		// in [us], one cycle of ControlMotor
+#define MODEL_PROXIMITY_WORK	300		// in [us], one scan of GetProximity
+#define MODEL_NORMALPRIO		128		// NORMALPRIO of ChibiOS
+#define MODEL_NB_THREADS		3
+#define MODEL_NO_PERIOD			PERIOD_NB	// thread without period monitor
+
+
+/*** STATIC VARIABLES ***/
+typedef struct model_thread_s{
+	const char* Name;
+	uint8_t Priority;
+	uint8_t PeriodId;		// PERIOD_CONTROL_MOTOR, ... or MODEL_NO_PERIOD
+	uint32_t PeriodUs;		// in [us]
+	uint32_t WorkUs;		// in [us], 0 --> busy until BusyEnd (GenerateLoad)
+	// State of the model
+	uint64_t Release;		// in [us], next end of the sleep
+	uint64_t BusyEnd;		// in [us], GenerateLoad leaves its busy loop
+	uint32_t Remaining;		// in [us], work left in the cycle
+	uint32_t Queued;		// order in the ready list of its priority
+	uint8_t Ready;
+	uint8_t Started;		// has run in this cycle, the period monitor has been ticked
+} model_thread_t;
+
+static model_thread_t Thread[MODEL_NB_THREADS] = {
+		{.Name = "ControlMotor", .Priority = MODEL_NORMALPRIO + 1, .PeriodId = PERIOD_CONTROL_MOTOR,
+				.PeriodUs = 1000, .WorkUs = MODEL_CONTROL_WORK},
+		{.Name = "GetProximity", .Priority = MODEL_NORMALPRIO, .PeriodId = PERIOD_GET_PROXIMITY,
+				.PeriodUs = 50000, .WorkUs = MODEL_PROXIMITY_WORK},
+		{.Name = "GenerateLoad", .Priority = MODEL_NORMALPRIO, .PeriodId = MODEL_NO_PERIOD,
+				.PeriodUs = LOAD_PERIOD * 1000, .WorkUs = 0}};
+
+static uint64_t Now 		= 0;	// in [us], clock of the model
+static uint32_t NbQueued 	= 0;
+static uint8_t LoadLevel 	= 0;	// in [%]
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Puts a thread at the end of the ready list of its priority.
+ */
+static void make_ready(model_thread_t* Thd){
+	Thd->Ready = 1;
+	Thd->Queued = ++NbQueued;
+}
+
+/**
+ * @brief	Returns the thread to run: highest priority, then first of the ready list.
+ */
+static model_thread_t* pick_thread(void){
+	model_thread_t* Next = NULL;
+
+	for(uint8_t i = 0 ; i < MODEL_NB_THREADS ; i++){
+		if(Thread[i].Ready && ((Next == NULL) || (Thread[i].Priority > Next->Priority)
+				|| ((Thread[i].Priority == Next->Priority) && (Thread[i].Queued < Next->Queued)))){
+			Next = &Thread[i];
+		}
+	}
+	return Next;
+}
+
+/**
+ * @brief	Runs the model for a duration at one load level.
+ */
+static void run_model(uint32_t DurationUs){
+	uint64_t End = Now + DurationUs;
+	model_thread_t* Running = NULL;
+	model_thread_t* Next;
+	uint64_t QuantumEnd = 0;
+
+	for( ; Now < End ; Now++){
+		// End of the sleeps
+		for(uint8_t i = 0 ; i < MODEL_NB_THREADS ; i++){
+			model_thread_t* Thd = &Thread[i];
+
+			if(!Thd->Ready && (Now >= Thd->Release) && ((Thd->WorkUs) || LoadLevel)){
+				Thd->Release += Thd->PeriodUs;
+				Thd->Remaining = Thd->WorkUs;
+				Thd->BusyEnd = Now + (Thd->PeriodUs * LoadLevel) / 100;
+				Thd->Started = 0;
+				make_ready(Thd);
+			}
+		}
+
+		// Round robin at the tick where the quantum of the running thread is over
+		if((Running != NULL) && Running->Ready && (Now >= QuantumEnd) && !(Now % 1000)){
+			make_ready(Running);
+			QuantumEnd = Now + MODEL_QUANTUM * 1000;
+		}
+
+		Next = pick_thread();
+		if(Next == NULL){
+			Running = NULL;
+			continue;
+		}
+		if(Next != Running){
+			Running = Next;
+			QuantumEnd = Now + MODEL_QUANTUM * 1000;
+		}
+
+		if(!Running->Started){
+			Running->Started = 1;
+			if(Running->PeriodId != MODEL_NO_PERIOD){
+				period_monitor_tick(Running->PeriodId);
+			}
+		}
+
+		// One us of work, or of the busy loop of GenerateLoad
+		if(Running->WorkUs){
+			Running->Remaining--;
+			Running->Ready = (Running->Remaining > 0);
+		}else{
+			Running->Ready = (Now + 1 < Running->BusyEnd);
+		}
+	}
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** FIRMWARE FUNCTIONS ***/
+
+uint32_t probe_host_now(void){
+	// Cycles of the model, wraps as the cycle counter
+	return (uint32_t)(Now * PROBE_CYCLES_PER_US);
+}
+
+void telemetry_write(uint8_t Type, const void* Payload, uint8_t Size){
+	const tlm_period_t* Data = Payload;
+
+	if((Type != TLM_PERIOD) || (Size != sizeof(tlm_period_t)) || (Data->Id >= PERIOD_NB)){
+		return;
+	}
+	for(uint8_t i = 0 ; i < MODEL_NB_THREADS ; i++){
+		if(Thread[i].PeriodId == Data->Id){
+			printf("%u,%s,%u,%u,%u,%u,%u,%u\n", LoadLevel, Thread[i].Name, (unsigned)Data->Count, Data->Misses,
+					Data->Min * TLM_PERIOD_UNIT, Data->Max * TLM_PERIOD_UNIT,
+					Data->Mean * TLM_PERIOD_UNIT, Data->Jitter * TLM_PERIOD_UNIT);
+		}
+	}
+}
+
+/*** END FIRMWARE FUNCTIONS ***/
+
+
+/*** MAIN ***/
+int main(void){
+	printf("load,thread,count,misses,min_us,max_us,mean_us,jitter_us\n");
+
+	// Load levels of LOAD_KEY, the statistics are cleared by each report
+	for(LoadLevel = 0 ; LoadLevel < 100 ; LoadLevel += LOAD_STEP){
+		// Every thread starts a cycle, GetProximity 1 ms after GenerateLoad
+		for(uint8_t i = 0 ; i < MODEL_NB_THREADS ; i++){
+			Thread[i].Ready = 0;
+			Thread[i].Release = Now + ((Thread[i].PeriodId == PERIOD_GET_PROXIMITY) ? 1000 : 0);
+			if(Thread[i].PeriodId != MODEL_NO_PERIOD){
+				period_monitor_init(Thread[i].PeriodId, Thread[i].PeriodUs);
+			}
+		}
+		run_model(MODEL_DURATION * 1000000);
+		period_monitor_report();
+	}
+
+	return 0;
+}
+/*** END MAIN ***/
@@ -0,0 +1,333 @@
+/**
+ * @file	TelemetryDecoder.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which decodes the telemetry stream of the e-puck into CSV files,
+ * 			 one file per record type (<prefix>_cell.csv, <prefix>_prox.csv, ...).
+ * 			Prints at the end the mean idle share and wakeups per selector position.
+ *
+ * 			Build:	gcc -O2 -I.. -o TelemetryDecoder TelemetryDecoder.c
+ * 			Usage:	stty -F /dev/ttyACM0 raw
+ * 					./TelemetryDecoder /dev/ttyACM0 run1
+ * 					./TelemetryDecoder run1.bin run1		(stream saved with cat)
+ * 			Commands (single characters) can be sent on the same device meanwhile:
+ * 					printf h > /dev/ttyACM0					(latency histograms)
+ * 					printf j > /dev/ttyACM0					(periods of the periodic threads)
+ * 					printf o > /dev/ttyACM0					(load generator 0, 25, 50, 75 %)
+ * 					printf p > /dev/ttyACM0					(next runtime parameter, then + or -)
+ * 					printf l > /dev/ttyACM0					(all the runtime parameters)
+ * 			The data of the images (TLM_IMAGE) is skipped, ImageReceiver writes the images.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <Telemetry.h>
+#include <SystemControl.h>
+
+// Summary define
+#define NB_SELECTOR_POS		16
+
+
+/*** STATIC VARIABLES ***/
+static FILE* Output[TLM_NB_TYPES];
+
+static const char* const RecordName[TLM_NB_TYPES] = {
+		NULL, "cell", "prox", "color", "motor", "pose", "status", "thread", "histogram", "period", "load", "power", "mode", "collision", "align", "slip", "heading", "corridor", "param", "decision", "vision", "calibration", "camera", "frame", "image"};
+
+static const char* const RecordHeader[TLM_NB_TYPES] = {
+		NULL,
+		"time,seq,cell,walls,color",
+		"time,seq,ir1,ir2,ir3,ir4,ir5,ir6,ir7,ir8",
+		"time,seq,red_val,green_val,blue_val,color,confidence,published",
+		"time,seq,speed_left,speed_right,position2reach,nominal_speed,pos_left,pos_right",
+		"time,seq,x,y,heading,cell,waypoints,dropped",
+		"time,seq,dropped,bytes_sent",
+		"time,seq,name,cpu_permille,switches,unused_stack",
+		"time,seq,probe,first_bucket,count0,count1,count2,count3,count4,count5,count6",
+		"time,seq,id,count,misses,min_us,max_us,mean_us,jitter_us",
+		"time,seq,selector,idle_permille,wakeups_per_s,ctx_switches_per_s,irqs_per_s",
+		"time,seq,peripheral,state,ready_us,previous_state_ms",
+		"time,seq,previous,selector,debounce_ms,step_ms,threads_ms,latency_ms",
+		"time,seq,prox_front,speed,latency_us,stop_steps,stop_mm,remaining_steps",
+		"time,seq,source,side,heading_steps,distance_steps,prox_left,prox_right",
+		"time,seq,source,acceleration,speed,pos,expected,measured",
+		"time,seq,target_mrad,fused_mrad,odometry_mrad,steps,bias_urad_s",
+		"time,seq,distance_mm,cells",
+		"time,seq,id,result,value,min,max",
+		"time,seq,selector,cell,direction,nb_cells,corridor",
+		"time,seq,distance_mm,row,duration_us",
+		"time,seq,result,iterations,duration_ms,red_gain,green_gain,blue_gain,contrast,red_val,green_val,blue_val",
+		"time,seq,preset,auto_exposure,exposure_lines,frame_lines,frames,rate_fps,travel_mm",
+		"time,seq,frame,width,height,nb_chunks,selector,cell,x,y,heading",
+		"time,block,frame,chunk,encoding,length,raw_length,checksum"};
+
+// Sums of the TLM_LOAD records per selector position
+static unsigned long LoadReports[NB_SELECTOR_POS];
+static unsigned long IdleSum[NB_SELECTOR_POS];
+static unsigned long WakeupSum[NB_SELECTOR_POS];
+
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Opens the CSV file of a record type the first time it is needed.
+ */
+static FILE* get_output(const char* Prefix, uint8_t Type){
+	char FileName[256];
+
+	if(Output[Type] == NULL){
+		snprintf(FileName, sizeof(FileName), "%s_%s.csv", Prefix, RecordName[Type]);
+		Output[Type] = fopen(FileName, "w");
+		if(Output[Type] != NULL){
+			fprintf(Output[Type], "%s\n", RecordHeader[Type]);
+		}
+	}
+	return Output[Type];
+}
+
+/**
+ * @brief	Writes one record as a CSV line.
+ */
+static void decode_record(const char* Prefix, const tlm_record_t* Record){
+	FILE* Csv = get_output(Prefix, Record->Type);
+	const void* Payload = Record->Payload;
+
+	if(Csv == NULL){
+		return;
+	}
+
+	fprintf(Csv, "%u,%u,", (unsigned)Record->Time, (unsigned)Record->Seq);
+
+	switch (Record->Type) {
+	case TLM_CELL:{
+		const tlm_cell_t* Data = Payload;
+		fprintf(Csv, "0x%02X,0x%X,0x%X\n", Data->Cell, Data->Cell & 0x0F, (Data->Cell & 0x70) >> 4);
+		break;
+	}
+	case TLM_PROX:{
+		const tlm_prox_t* Data = Payload;
+		for(uint8_t i = 0 ; i < 8 ; i++){
+			fprintf(Csv, (i < 7) ? "%u," : "%u\n", Data->Prox[i]);
+		}
+		break;
+	}
+	case TLM_COLOR:{
+		const tlm_color_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%u,0x%02X,%u,0x%02X\n", (unsigned)Data->RedVal, (unsigned)Data->GreenVal,
+				(unsigned)Data->BlueVal, Data->Color, Data->Confidence, Data->Published);
+		break;
+	}
+	case TLM_MOTOR:{
+		const tlm_motor_t* Data = Payload;
+		fprintf(Csv, "%d,%d,%d,%d,%d,%d\n", Data->SpeedLeft, Data->SpeedRight,
+				Data->Position2Reach, Data->NominalSpeed, (int)Data->PosLeft, (int)Data->PosRight);
+		break;
+	}
+	case TLM_POSE:{
+		const tlm_pose_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%u,0x%02X,%u,%u\n", Data->X, Data->Y, Data->Heading, Data->Cell,
+				Data->Waypoints, Data->Dropped);
+		break;
+	}
+	case TLM_STATUS:{
+		const tlm_status_t* Data = Payload;
+		fprintf(Csv, "%u,%u\n", (unsigned)Data->Dropped, (unsigned)Data->BytesSent);
+		break;
+	}
+	case TLM_THREAD:{
+		const tlm_thread_t* Data = Payload;
+		fprintf(Csv, "%.8s,%u,%u,%u\n", Data->Name, Data->CpuShare,
+				(unsigned)Data->Switches, Data->UnusedStack);
+		break;
+	}
+	case TLM_HISTOGRAM:{
+		const tlm_histogram_t* Data = Payload;
+		fprintf(Csv, "%u,%u", Data->Probe, Data->FirstBucket);
+		for(uint8_t i = 0 ; i < TLM_HISTOGRAM_BUCKETS ; i++){
+			fprintf(Csv, ",%u", Data->Counts[i]);
+		}
+		fprintf(Csv, "\n");
+		break;
+	}
+	case TLM_PERIOD:{
+		const tlm_period_t* Data = Payload;
+		// Periods written in [us]
+		fprintf(Csv, "%u,%u,%u,%u,%u,%u,%u\n", Data->Id, (unsigned)Data->Count, Data->Misses,
+				Data->Min * TLM_PERIOD_UNIT, Data->Max * TLM_PERIOD_UNIT,
+				Data->Mean * TLM_PERIOD_UNIT, Data->Jitter * TLM_PERIOD_UNIT);
+		break;
+	}
+	case TLM_LOAD:{
+		const tlm_load_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%u,%u,%u\n", Data->Selector, Data->IdleShare, (unsigned)Data->Wakeups,
+				(unsigned)Data->CtxSwitches, (unsigned)Data->Irqs);
+		if(Data->Selector < NB_SELECTOR_POS){
+			LoadReports[Data->Selector]++;
+			IdleSum[Data->Selector] += Data->IdleShare;
+			WakeupSum[Data->Selector] += Data->Wakeups;
+		}
+		break;
+	}
+	case TLM_POWER:{
+		const tlm_power_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%u,%u\n", Data->Peripheral, Data->State,
+				(unsigned)Data->ReadyUs, (unsigned)Data->StateMs);
+		break;
+	}
+	case TLM_MODE:{
+		const tlm_mode_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%u,%u,%u,%u\n", Data->Previous, Data->Selector, (unsigned)Data->DebounceMs,
+				(unsigned)Data->StepMs, Data->ThreadsMs, (unsigned)Data->LatencyMs);
+		break;
+	}
+	case TLM_COLLISION:{
+		const tlm_collision_t* Data = Payload;
+		fprintf(Csv, "%u,%d,%u,%d,%.2f,%d\n", Data->ProxFront, Data->Speed, (unsigned)Data->LatencyUs,
+				(int)Data->StopSteps, Data->StopSteps / MM_2_STEP, (int)Data->Remaining);
+		break;
+	}
+	case TLM_ALIGN:{
+		const tlm_align_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%d,%d,%u,%u\n", Data->Source, Data->Side, Data->Heading,
+				Data->Distance, Data->ProxLeft, Data->ProxRight);
+		break;
+	}
+	case TLM_SLIP:{
+		const tlm_slip_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%d,%d,%d,%d\n", Data->Source, Data->Acceleration, Data->Speed,
+				Data->Pos, Data->Expected, Data->Measured);
+		break;
+	}
+	case TLM_HEADING:{
+		const tlm_heading_t* Data = Payload;
+		fprintf(Csv, "%d,%d,%d,%d,%d\n", Data->Target, Data->Fused, Data->Odometry,
+				Data->Steps, (int)Data->Bias);
+		break;
+	}
+	case TLM_CORRIDOR:{
+		const tlm_corridor_t* Data = Payload;
+		fprintf(Csv, "%u,%u\n", Data->Distance, Data->Cells);
+		break;
+	}
+	case TLM_PARAM:{
+		const tlm_param_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%d,%d,%d\n", Data->Id, Data->Result, (int)Data->Value,
+				(int)Data->Min, (int)Data->Max);
+		break;
+	}
+	case TLM_DECISION:{
+		const tlm_decision_t* Data = Payload;
+		fprintf(Csv, "%u,0x%02X,%d,%u,%u\n", Data->Selector, Data->Cell, Data->Direction,
+				Data->NbCells, Data->Corridor);
+		break;
+	}
+	case TLM_VISION:{
+		const tlm_vision_t* Data = Payload;
+		fprintf(Csv, "%u,%d,%u\n", Data->Distance, Data->Row, (unsigned)Data->DurationUs);
+		break;
+	}
+	case TLM_CALIBRATION:{
+		const tlm_calibration_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", Data->Result, Data->Iterations, Data->DurationMs,
+				Data->RedGain, Data->GreenGain, Data->BlueGain, Data->Contrast,
+				Data->RedVal, Data->GreenVal, Data->BlueVal);
+		break;
+	}
+	case TLM_FRAME:{
+		const tlm_frame_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%u,%u,%u,0x%02X,%u,%u,%u\n", Data->Frame, Data->Width, Data->Height,
+				Data->NbChunks, Data->Selector, Data->Cell, Data->X, Data->Y, Data->Heading);
+		break;
+	}
+	case TLM_IMAGE:{
+		const tlm_image_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%u,%u,%u,%u\n", Data->Frame, Data->Chunk, Data->Encoding,
+				Data->Length, Data->RawLength, Data->Checksum);
+		break;
+	}
+	case TLM_CAMERA:{
+		const tlm_camera_t* Data = Payload;
+		fprintf(Csv, "%u,%u,%u,%u,%u,%.1f,%.1f\n", Data->Preset, Data->AutoExposure, Data->Exposure,
+				Data->FrameHeight, Data->Frames, Data->Rate / 10.0, Data->Travel / 10.0);
+		break;
+	}
+	default:
+		break;
+	}
+	fflush(Csv);
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** MAIN ***/
+int main(int argc, char* argv[]){
+	tlm_record_t Record;
+	uint8_t* Window = (uint8_t*)&Record;
+	size_t Filled = 0;
+	unsigned long NbRecords = 0;
+	unsigned long NbResync = 0;
+	FILE* Input;
+	int Byte;
+
+	if(argc != 3){
+		fprintf(stderr, "usage: %s <stream|device> <csv prefix>\n", argv[0]);
+		return 1;
+	}
+
+	Input = fopen(argv[1], "rb");
+	if(Input == NULL){
+		perror(argv[1]);
+		return 1;
+	}
+
+	// Slides a window of one record over the stream until sync byte and type are valid
+	while((Byte = fgetc(Input)) != EOF){
+		Window[Filled++] = (uint8_t)Byte;
+
+		if((Filled >= 2) && ((Record.Sync != TLM_SYNC) || (Record.Type == 0) || (Record.Type >= TLM_NB_TYPES))){
+			// Drops the first byte and looks for the next sync byte
+			memmove(Window, Window + 1, --Filled);
+			while(Filled && (Window[0] != TLM_SYNC)){
+				memmove(Window, Window + 1, --Filled);
+			}
+			NbResync++;
+			continue;
+		}
+
+		if(Filled == sizeof(tlm_record_t)){
+			decode_record(argv[2], &Record);
+			NbRecords++;
+			Filled = 0;
+
+			// Data of the image stream, decoded by ImageReceiver
+			if(Record.Type == TLM_IMAGE){
+				for(uint16_t Length = ((const tlm_image_t*)Record.Payload)->Length ; Length && (fgetc(Input) != EOF) ; Length--){
+				}
+			}
+		}
+	}
+
+	fprintf(stderr, "%lu records decoded, %lu resynchronisations\n", NbRecords, NbResync);
+
+	for(uint8_t Selector = 0 ; Selector < NB_SELECTOR_POS ; Selector++){
+		if(LoadReports[Selector]){
+			fprintf(stderr, "selector %2u: idle %5.1f %%, %lu wakeups/s (%lu reports)\n", Selector,
+					IdleSum[Selector] / (10.0 * LoadReports[Selector]),
+					WakeupSum[Selector] / LoadReports[Selector], LoadReports[Selector]);
+		}
+	}
+
+	for(uint8_t Type = 0 ; Type < TLM_NB_TYPES ; Type++){
+		if(Output[Type] != NULL){
+			fclose(Output[Type]);
+		}
+	}
+	fclose(Input);
+	return 0;
+}
+/*** END MAIN ***/
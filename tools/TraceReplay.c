@@ -0,0 +1,374 @@
+/**
+ * @file	TraceReplay.c
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host tool which replays a telemetry stream of the e-puck (the trace) through
+ * 			 the wall and color detections and the maze solving of the firmware,
+ * 			 compiled from the same sources (DataProcess.c and MazeMap.c).
+ * 			The recorded inputs are the raw IR values (TLM_PROX), the sums of the camera
+ * 			 row (TLM_COLOR), the selector (TLM_MODE), the runtime parameters (TLM_PARAM),
+ * 			 the time of flight corridor (TLM_DECISION) and the steps done at the end of
+ * 			 the motor commands (TLM_MOTOR), the map only advances of the completed cells.
+ * 			The recorded results are ActualCell (TLM_CELL), the colors of the frame and
+ * 			 after the vote (TLM_COLOR) and the decisions (TLM_DECISION).
+ * 			Every result which differs is written as a CSV line, the exit status is 1
+ * 			 if a decision differs so that it can be used by git bisect run.
+ *
+ * 			Build:	gcc -O2 -DHOST_BUILD -I.. -Ihost -o TraceReplay TraceReplay.c ../DataProcess.c ../MazeMap.c
+ * 			Usage:	cat /dev/ttyACM0 > run1.bin								(record on the floor)
+ * 					./TraceReplay run1.bin > run1_diff.csv
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <leds.h>
+
+#include <main.h>
+#include <Telemetry.h>
+#include <SystemControl.h>
+#include <DataAcquisition.h>
+#include <DataProcess.h>
+#include <MazeMap.h>
+#include <MazeParameters.h>
+#include <CameraControl.h>
+
+// Replay define
+#define NO_DECISION		0x7FFF	// direction when the replayed mode doesn't move
+
+
+/*** STATIC VARIABLES ***/
+// Inputs replayed so far
+static int32_t ParamValue[PARAM_NB] = {
+		[PARAM_ONE_CELL] 		= ONE_CELL,
+		[PARAM_LEFT_TURN] 		= -LEFT_TURN,
+		[PARAM_RIGHT_TURN] 		= RIGHT_TURN,
+		[PARAM_BACKWARD_TURN] 	= BACKWARD_TURN,
+		[PARAM_ONE_TURN] 		= -ONE_TURN,
+		[PARAM_PROX_THRESHOLD] 	= PROXIMITY_THRESHOLD,
+		[PARAM_IMAGE_WIDTH] 	= IMAGE_BUFFER_SIZE,
+		[PARAM_COLOR_THRESHOLD] = COLOR_THRESHOLD,
+		[PARAM_RED_GAIN] 		= RED_GAIN,
+		[PARAM_GREEN_GAIN] 		= GREEN_GAIN,
+		[PARAM_BLUE_GAIN] 		= BLUE_GAIN,
+		[PARAM_CONTRAST] 		= CAMERA_CONTRAST,
+		[PARAM_COLOR_WINDOW] 	= COLOR_WINDOW,
+		[PARAM_COLOR_CONFIDENCE]= COLOR_MIN_CONFIDENCE,
+		[PARAM_CAMERA_PRESET] 	= CAMERA_PRESET};
+static uint8_t Walls 		= NO_WALL;
+static uint8_t Color 		= 0;
+static color_vote_t Vote;
+static int8_t ExitStatus 	= SEARCHING;
+// Move of the last decision of the route, the map advances of its completed cells at the next one
+static int16_t PendingDirection = NO_DECISION;
+static int32_t PendingSteps 	= 0;	// in [steps], left motor at the end of the last command (TLM_MOTOR)
+
+// Summary
+static unsigned long NbRecords 		= 0;
+static unsigned long NbLost 		= 0;
+static unsigned long NbDecisions 	= 0;
+static unsigned long NbDecisionDiffs = 0;
+static unsigned long NbWallDiffs 	= 0;
+static unsigned long NbColorDiffs 	= 0;
+
+
+/*** FIRMWARE FUNCTIONS ***/
+// Actions of DataProcess.c, nothing to drive on the host
+
+void set_led(led_name_t led_number, unsigned int value){
+	(void)led_number;
+	(void)value;
+}
+
+void set_rgb_led(rgb_led_name_t led_number, uint8_t red_val, uint8_t green_val, uint8_t blue_val){
+	(void)led_number;
+	(void)red_val;
+	(void)green_val;
+	(void)blue_val;
+}
+
+void set_body_led(unsigned int value){
+	(void)value;
+}
+
+void set_front_led(unsigned int value){
+	(void)value;
+}
+
+void turn(int16_t AngleVal){
+	(void)AngleVal;
+}
+
+int16_t motor_wait_ready(void){
+	return 0;
+}
+
+void correction_nominal_speed(int16_t SpeedCorrection){
+	(void)SpeedCorrection;
+}
+
+int32_t param_get(uint8_t Id){
+	return ParamValue[Id];
+}
+
+/*** END FIRMWARE FUNCTIONS ***/
+
+/*** INTERNAL FUNCTIONS ***/
+
+/**
+ * @brief	Writes a result which differs from the recorded one as a CSV line.
+ */
+static void print_diff(const tlm_record_t* Record, const char* Kind, uint8_t Selector,
+		uint8_t RecordedCell, uint8_t ReplayedCell, int Recorded, int Replayed){
+	printf("%u,%u,%s,%u,0x%02X,0x%02X,%d,%d\n", (unsigned)Record->Time, (unsigned)Record->Seq,
+			Kind, Selector, RecordedCell, ReplayedCell, Recorded, Replayed);
+}
+
+/**
+ * @brief	Skips the data following a TLM_IMAGE record.
+ */
+static void skip_block(FILE* Input, const tlm_record_t* Record){
+	uint16_t Length = ((const tlm_image_t*)Record->Payload)->Length;
+
+	while(Length-- && (fgetc(Input) != EOF)){
+	}
+}
+
+/**
+ * @brief	Same rounding as cells_done() of main.c.
+ */
+static uint8_t cells_done(int32_t Steps){
+	return (Steps + ParamValue[PARAM_ONE_CELL] / 2) / ParamValue[PARAM_ONE_CELL];
+}
+
+/**
+ * @brief	Same steps as the mode hooks of main.c when a mode starts.
+ */
+static void replay_mode_enter(uint8_t Selector){
+	switch (Selector) {
+	case POS_SEL_1:
+		reset_orientation();
+		break;
+	case POS_SEL_5:
+		reset_orientation();
+		map_reset();
+		PendingDirection = NO_DECISION;
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief	Same steps as solve_maze_step() and route_step() of main.c up to
+ * 			 the decision, with the replayed cell and the recorded corridor.
+ *
+ * @return	Direction given to go_next_cell(), NO_DECISION if the e-puck wouldn't move
+ */
+static int16_t replay_decision(uint8_t Selector, uint8_t Cell, uint8_t Corridor, uint8_t* NbCells){
+	int16_t Direction = MOVE_FORWARD;
+
+	*NbCells = 0;
+
+	switch (Selector) {
+	case POS_SEL_0:
+	case POS_SEL_1:
+		check_exit(Cell, &ExitStatus);
+		if(ExitStatus != SEARCHING){
+			return NO_DECISION;
+		}
+		floor_color_action(Cell);
+		return (Selector == POS_SEL_0) ? left_wall_follower(Cell) : pledge_algorithm(Cell);
+	case POS_SEL_5:
+		// Move of the previous decision, done once the motors are ready
+		if(PendingDirection != NO_DECISION){
+			map_advance(PendingDirection, cells_done(PendingSteps));
+			PendingDirection = NO_DECISION;
+		}
+		map_record_cell(Cell);
+		if(!map_exploration_done()){
+			// Left wall follower until it loops, out of the exit --> back into the maze
+			if(!map_frontier_direction(&Direction)){
+				Direction = left_wall_follower(Cell);
+			}
+		}else if(route_next_direction(&Direction) == ROUTE_DONE){
+			return NO_DECISION;
+		}else if(Direction == MOVE_FORWARD){
+			*NbCells = route_straight_cells();
+		}
+
+		if(*NbCells > 1){
+			if(Corridor < *NbCells){
+				*NbCells = Corridor;
+			}
+		}
+
+		if(*NbCells <= 1){
+			*NbCells = 0;
+		}
+		// All the cells unless a TLM_MOTOR record ends the move earlier
+		PendingDirection = Direction;
+		PendingSteps = (*NbCells ? *NbCells : 1) * ParamValue[PARAM_ONE_CELL];
+		return Direction;
+	default:
+		return NO_DECISION;
+	}
+}
+
+/**
+ * @brief	Replays one record: inputs are saved, results are computed again and compared.
+ */
+static void replay_record(const tlm_record_t* Record){
+	uint16_t Prox[8];
+	uint8_t Cell, NbCells, Frame, Confidence;
+	int16_t Direction;
+
+	switch (Record->Type) {
+	case TLM_PROX:{
+		const tlm_prox_t* Data = (const void*)Record->Payload;
+		// Copied out of the packed record, scan_walls() reads aligned values
+		memcpy(Prox, Data->Prox, sizeof(Prox));
+		Walls = scan_walls(Prox, ParamValue[PARAM_PROX_THRESHOLD]);
+		break;
+	}
+	case TLM_CELL:{
+		const tlm_cell_t* Data = (const void*)Record->Payload;
+		// Written by GetProximity right after its scan, the colors may come from an older frame
+		if((Data->Cell & WALL_B) != Walls){
+			print_diff(Record, "walls", 0, Data->Cell & WALL_B, Walls, 0, 0);
+			NbWallDiffs++;
+		}
+		break;
+	}
+	case TLM_COLOR:{
+		const tlm_color_t* Data = (const void*)Record->Payload;
+#if COLOR_CLASSIFIER == TRUE
+		// Pixels not recorded --> the colors of the frame are replayed as recorded
+		Frame = Data->Color;
+		Confidence = Data->Confidence;
+#else
+		uint32_t RedVal = Data->RedVal;
+		uint32_t GreenVal = Data->GreenVal;
+		uint32_t BlueVal = Data->BlueVal;
+		Frame = extract_color(&RedVal, &GreenVal, &BlueVal, ParamValue[PARAM_COLOR_THRESHOLD]);
+		Confidence = color_confidence(RedVal, GreenVal, BlueVal, ParamValue[PARAM_COLOR_THRESHOLD]);
+		if(Data->Color != Frame){
+			print_diff(Record, "color", 0, Data->Color, Frame, 0, 0);
+			NbColorDiffs++;
+		}
+#endif
+		// Same vote as ProcessImage, the saved colors are used by the decisions
+		Color = vote_color(&Vote, Frame, Confidence, ParamValue[PARAM_COLOR_WINDOW], ParamValue[PARAM_COLOR_CONFIDENCE]);
+		if(Data->Published != Color){
+			print_diff(Record, "published", 0, Data->Published, Color, 0, 0);
+			NbColorDiffs++;
+		}
+		break;
+	}
+	case TLM_PARAM:{
+		const tlm_param_t* Data = (const void*)Record->Payload;
+		if((Data->Result == PARAM_ACCEPTED) && (Data->Id < PARAM_NB)){
+			ParamValue[Data->Id] = Data->Value;
+		}
+		break;
+	}
+	case TLM_MOTOR:{
+		const tlm_motor_t* Data = (const void*)Record->Payload;
+		// End of a command, the last one of a decision is its move
+		if((Data->SpeedLeft == STOP_SPEED) && (Data->SpeedRight == STOP_SPEED)){
+			PendingSteps = (Data->PosLeft < 0) ? -Data->PosLeft : Data->PosLeft;
+		}
+		break;
+	}
+	case TLM_MODE:{
+		const tlm_mode_t* Data = (const void*)Record->Payload;
+		replay_mode_enter(Data->Selector);
+		break;
+	}
+	case TLM_DECISION:{
+		const tlm_decision_t* Data = (const void*)Record->Payload;
+		Cell = Walls | Color;
+		Direction = replay_decision(Data->Selector, Cell, Data->Corridor, &NbCells);
+		NbDecisions++;
+		if(Direction != Data->Direction){
+			print_diff(Record, "direction", Data->Selector, Data->Cell, Cell, Data->Direction, Direction);
+			NbDecisionDiffs++;
+		}else if(NbCells != Data->NbCells){
+			print_diff(Record, "cells", Data->Selector, Data->Cell, Cell, Data->NbCells, NbCells);
+			NbDecisionDiffs++;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/*** END INTERNAL FUNCTIONS ***/
+
+/*** MAIN ***/
+int main(int argc, char* argv[]){
+	tlm_record_t Record;
+	uint8_t* Window = (uint8_t*)&Record;
+	size_t Filled = 0;
+	uint16_t LastSeq = 0;
+	FILE* Input;
+	int Byte;
+
+	if(argc != 2){
+		fprintf(stderr, "usage: %s <stream>\n", argv[0]);
+		return 1;
+	}
+
+	Input = fopen(argv[1], "rb");
+	if(Input == NULL){
+		perror(argv[1]);
+		return 1;
+	}
+
+	printf("time,seq,kind,selector,recorded_cell,replayed_cell,recorded,replayed\n");
+
+	// Same resynchronisation as TelemetryDecoder
+	while((Byte = fgetc(Input)) != EOF){
+		Window[Filled++] = (uint8_t)Byte;
+
+		if((Filled >= 2) && ((Record.Sync != TLM_SYNC) || (Record.Type == 0) || (Record.Type >= TLM_NB_TYPES))){
+			memmove(Window, Window + 1, --Filled);
+			while(Filled && (Window[0] != TLM_SYNC)){
+				memmove(Window, Window + 1, --Filled);
+			}
+			continue;
+		}
+
+		if(Filled == sizeof(tlm_record_t)){
+			// Blocks of the image stream are numbered apart, their data isn't a record
+			if(Record.Type == TLM_IMAGE){
+				skip_block(Input, &Record);
+				Filled = 0;
+				continue;
+			}
+
+			// Records dropped by the firmware or the link --> the replay may diverge from there
+			if(NbRecords && ((uint16_t)(Record.Seq - LastSeq) != 1)){
+				NbLost += (uint16_t)(Record.Seq - LastSeq - 1);
+			}
+			LastSeq = Record.Seq;
+
+			replay_record(&Record);
+			NbRecords++;
+			Filled = 0;
+		}
+	}
+	fclose(Input);
+
+	fprintf(stderr, "%lu records replayed, %lu lost\n", NbRecords, NbLost);
+	fprintf(stderr, "%lu decisions, %lu differ\n", NbDecisions, NbDecisionDiffs);
+	fprintf(stderr, "%lu wall and %lu color detections differ\n", NbWallDiffs, NbColorDiffs);
+
+	return NbDecisionDiffs ? 1 : 0;
+}
+/*** END MAIN ***/
@@ -0,0 +1,44 @@
+/**
+ * @file	ch.h
+ *
+ * @author	David 	RUEGG
+ * @author	Thibaut	STOLTZ
+ *
+ * @date	19.10.2026
+ *
+ * @brief	Host replacement of the part of the ChibiOS kernel API used by ThreadPark.c
+ * 			 (HOST_BUILD with HOST_KERNEL). Same names and semantics, the functions are
+ * 			 defined by the host tool on POSIX threads: the kernel lock is one mutex,
+ * 			 the events of a thread are a mask guarded by it.
+ * 			The system tick is 1 ms, as CH_CFG_ST_FREQUENCY of chconf.h.
+ */
+
+#ifndef CH_H
+#define CH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct host_thread_s thread_t;	// defined by the host tool
+typedef uint32_t systime_t;
+typedef int32_t msg_t;
+typedef uint32_t eventmask_t;
+
+#define MSG_OK				((msg_t)0)
+#define MSG_TIMEOUT			((msg_t)-1)
+#define TIME_IMMEDIATE		((systime_t)0)
+#define EVENT_MASK(eid)		((eventmask_t)1 << (eid))
+#define MS2ST(msec)			((systime_t)(msec))
+#define ST2MS(n)			((uint32_t)(n))
+
+void chSysLock(void);
+void chSysUnlock(void);
+// Lets the other threads run, the state guarded by the lock may change meanwhile
+void chSchRescheduleS(void);
+void chEvtSignalI(thread_t *tp, eventmask_t events);
+eventmask_t chEvtWaitAny(eventmask_t events);
+eventmask_t chEvtWaitAnyTimeout(eventmask_t events, systime_t timeout);
+thread_t *chThdGetSelfX(void);
+systime_t chVTGetSystemTime(void);
+
+#endif /* CH_H */